@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+
+"""
+Decode a binary burst trace written by osmo-bts ('burst-trace dump PATH' on
+the VTY, 'SET burst-trace-dump PATH' on the CTRL interface, or the file
+configured with 'burst-trace crash-dump PATH').
+
+Usage: burst_trace_decode.py [--event NAME] [--trx N] [--tn N] FILE
+"""
+
+import argparse
+import struct
+import sys
+
+HDR = struct.Struct('<4sBBHI')
+REC = struct.Struct('<QIBBBBhhbBH')
+
+EVENTS = {
+	1: 'TRXD-RX',
+	2: 'UL-BURST',
+	3: 'UL-DATA',
+	4: 'DL-DEQUEUE',
+	5: 'DL-BURST',
+}
+
+# enum trx_chan_type in include/osmo-bts/scheduler.h
+CHANS = [
+	'IDLE', 'FCCH', 'SCH', 'BCCH', 'RACH', 'CCCH', 'CBCH', 'PDTCH', 'PTCCH',
+	'TCH/F', 'TCH/H(0)', 'TCH/H(1)',
+	'SDCCH/4(0)', 'SDCCH/4(1)', 'SDCCH/4(2)', 'SDCCH/4(3)',
+	'SDCCH/8(0)', 'SDCCH/8(1)', 'SDCCH/8(2)', 'SDCCH/8(3)',
+	'SDCCH/8(4)', 'SDCCH/8(5)', 'SDCCH/8(6)', 'SDCCH/8(7)',
+	'SACCH/TF', 'SACCH/TH(0)', 'SACCH/TH(1)',
+	'SACCH/4(0)', 'SACCH/4(1)', 'SACCH/4(2)', 'SACCH/4(3)',
+	'SACCH/8(0)', 'SACCH/8(1)', 'SACCH/8(2)', 'SACCH/8(3)',
+	'SACCH/8(4)', 'SACCH/8(5)', 'SACCH/8(6)', 'SACCH/8(7)',
+]
+
+def chan_name(chan):
+	if chan == 0xff:
+		return '-'
+	if chan < len(CHANS):
+		return CHANS[chan]
+	return 'chan%u' % chan
+
+def arg_str(event, arg):
+	if event == 3:
+		return 'ber10k=%u' % arg
+	if event == 4:
+		return 'found' if arg else 'not-found'
+	return 'len=%u' % arg
+
+def main():
+	parser = argparse.ArgumentParser(description='Decode an osmo-bts burst trace')
+	parser.add_argument('file')
+	parser.add_argument('--event', choices=EVENTS.values(), help='only show this event')
+	parser.add_argument('--trx', type=int, help='only show this TRX')
+	parser.add_argument('--tn', type=int, help='only show this timeslot')
+	args = parser.parse_args()
+
+	with open(args.file, 'rb') as f:
+		data = f.read()
+
+	if len(data) < HDR.size:
+		sys.exit('%s: file too short' % args.file)
+	magic, version, rec_len, _, num_recs = HDR.unpack_from(data)
+	if magic != b'OBTR':
+		sys.exit('%s: not a burst trace' % args.file)
+	if version != 1 or rec_len != REC.size:
+		sys.exit('%s: unsupported version %u (record length %u)' % (args.file, version, rec_len))
+
+	num_avail = (len(data) - HDR.size) // rec_len
+	if num_avail < num_recs:
+		print('warning: truncated file, %u of %u records' % (num_avail, num_recs), file=sys.stderr)
+		num_recs = num_avail
+
+	t0 = None
+	for i in range(num_recs):
+		(time_ns, fn, event, trx, tn, chan, toa256, ci_cb,
+		 rssi, flags, arg) = REC.unpack_from(data, HDR.size + i * rec_len)
+		ev_name = EVENTS.get(event, 'ev%u' % event)
+		if args.event is not None and ev_name != args.event:
+			continue
+		if args.trx is not None and trx != args.trx:
+			continue
+		if args.tn is not None and tn != args.tn:
+			continue
+		if t0 is None:
+			t0 = time_ns
+		print('%12.6f fn=%-7u trx=%u tn=%u %-10s %-12s rssi=%-4d toa256=%-5d ci_cb=%-4d flags=0x%02x %s'
+		      % ((time_ns - t0) / 1e9, fn, trx, tn, ev_name, chan_name(chan),
+			 rssi, toa256, ci_cb, flags, arg_str(event, arg)))
+
+if __name__ == '__main__':
+	main()
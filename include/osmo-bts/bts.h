@@ -5,10 +5,14 @@
 #include <osmocom/core/socket.h>
 #include <osmo-bts/gsm_data.h>
 #include <osmo-bts/bts_trx.h>
+#include <osmo-bts/overload.h>
 
 
 struct gsm_bts_trx;
 
+/* Size of the AGCH queue ring buffer, shall be larger than its hard limit */
+#define BTS_AGCH_QUEUE_SIZE		128
+
 enum bts_global_status {
 	BTS_STATUS_RF_ACTIVE,
 	BTS_STATUS_RF_MUTE,
@@ -29,6 +33,14 @@ enum {
 	BTS_CTR_AGCH_RCVD,
 	BTS_CTR_AGCH_SENT,
 	BTS_CTR_AGCH_DELETED,
+	BTS_CTR_RSL_TX_BATCHES,
+	BTS_CTR_RSL_TX_MSGS,
+	BTS_CTR_GSMTAP_DROPPED,
+	BTS_CTR_OVLD_GSMTAP,
+	BTS_CTR_OVLD_LOGGING,
+	BTS_CTR_OVLD_INTERF,
+	BTS_CTR_OVLD_MEAS_RES,
+	BTS_CTR_OVLD_MEAS_RES_DROP,
 };
 
 /* Used by OML layer for BTS Attribute reporting */
@@ -199,6 +211,8 @@ struct gsm_bts {
 	uint8_t si2q_count; /* si2q_index for the last (highest indexed) individual SI2quater message */
 	/* buffers where we put the pre-computed SI */
 	sysinfo_buf_t si_buf[_MAX_SYSINFO_TYPE][SI2Q_MAX_NUM];
+	/* SACCH SI from SACCH FILLING, shared with all lchans */
+	struct gsm_sacch_si *sacch_si[_MAX_SYSINFO_TYPE];
 	/* offsets used while generating SI2quater */
 	size_t e_offset;
 	size_t u_offset;
@@ -240,7 +254,16 @@ struct gsm_bts {
 	struct llist_head trx_list;
 
 	struct rate_ctr_group *ctrs;
+	/* Downlink latency and Uplink decode/queue time per SAPI, see latency.h */
+	struct bts_lat_stats dl_lat[_NUM_BTS_LAT_SAPI];
+	struct bts_lat_stats ul_dec[_NUM_BTS_LAT_SAPI];
+	struct bts_lat_stats ul_queue[_NUM_BTS_LAT_SAPI];
 	bool supp_meas_toa256;
+	/* Window for coalescing RSL messages into batches (us), 0 = disabled */
+	unsigned int rsl_tx_coalesce_us;
+	bool rsl_tx_coalesce_frame;	/* configured as "rsl-tx-coalesce frame" */
+	/* Shedding of non-essential work under load, see overload.h */
+	struct bts_ovld ovld;
 
 	struct {
 		/* Interference Boundaries for OML */
@@ -275,17 +298,33 @@ struct gsm_bts {
 
 	/* AGCH queuing */
 	struct {
-		struct llist_head queue;
+		/* ring buffer of queued messages, the oldest one is at 'head' */
+		struct {
+			struct msgb *msg;
+			/* RACH FN (modulo 42432) of the most recent Request
+			 * Reference in msg, GSM_TDMA_HYPERFRAME if unknown */
+			uint32_t rach_fn;
+		} ring[BTS_AGCH_QUEUE_SIZE];
+		unsigned int head;
 		int length;
 		int max_length;
+		/* age (in frames) after which a message is of no use anymore,
+		 * based on T3126 of the MS; 0 if unknown */
+		uint32_t deadline_fn;
 
 		int thresh_level;	/* Cleanup threshold in percent of max len */
 		int low_level;		/* Low water mark in percent of max len */
 		int high_level;		/* High water mark in percent of max len */
 
+		/* Combine two IMM ASS into one IMM ASS EXT (disabled by default) */
+		bool imm_ass_ext;
+		/* Use PCH blocks with only repeated paging for AGCH (disabled by default) */
+		bool pch_preempt;
+
 		/* TODO: Use a rate counter group instead */
 		uint64_t dropped_msgs;
 		uint64_t merged_msgs;
+		uint64_t merged_imm_ass_msgs;
 		uint64_t rejected_msgs;
 		uint64_t agch_msgs;
 		uint64_t pch_msgs;
@@ -365,6 +404,14 @@ struct gsm_bts {
 		char *remote_host;
 		uint32_t sapi_mask;
 		uint8_t sapi_acch;
+		/* bitmask of timeslots whose frames are sent */
+		uint8_t ts_mask;
+		/* only send every n-th frame (1 = all) */
+		uint16_t sample_rate;
+		uint16_t sample_cnt;
+		/* queue frames and send them once per TDMA frame */
+		bool batched;
+		struct gsmtap_batch *batch;
 	} gsmtap;
 
 	struct osmo_fsm_inst *shutdown_fi; /* FSM instance to manage shutdown procedure during process exit */
@@ -398,14 +445,20 @@ int bts_link_estab(struct gsm_bts *bts);
 int bts_agch_enqueue(struct gsm_bts *bts, struct msgb *msg);
 struct msgb *bts_agch_dequeue(struct gsm_bts *bts);
 int bts_agch_max_queue_length(int T, int bcch_conf);
+uint32_t bts_agch_deadline_fn(unsigned int tx_integer_idx, int bcch_conf);
 int bts_ccch_copy_msg(struct gsm_bts *bts, uint8_t *out_buf, struct gsm_time *gt,
-		      int is_ag_res);
+		      int is_ag_res, uint32_t *dl_lat_ts);
 int bts_supports_cipher(struct gsm_bts *bts, int rsl_cipher);
 uint8_t *bts_sysinfo_get(struct gsm_bts *bts, const struct gsm_time *g_time);
 void regenerate_si3_restoctets(struct gsm_bts *bts);
 void regenerate_si4_restoctets(struct gsm_bts *bts);
 int get_si4_ro_offset(const uint8_t *si4_buf);
 uint8_t *lchan_sacch_get(struct gsm_lchan *lchan);
+struct gsm_sacch_si *sacch_si_alloc(void *ctx);
+struct gsm_sacch_si *sacch_si_get(struct gsm_sacch_si *si);
+void sacch_si_put(struct gsm_sacch_si *si);
+void lchan_sacch_si_set(struct gsm_lchan *lchan, unsigned int osmo_si, struct gsm_sacch_si *si);
+void lchan_sacch_si_release(struct gsm_lchan *lchan);
 int lchan_init_lapdm(struct gsm_lchan *lchan);
 
 void load_timer_start(struct gsm_bts *bts);
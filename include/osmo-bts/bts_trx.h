@@ -1,5 +1,7 @@
 #pragma once
 
+#include <osmocom/core/select.h>
+
 #include <osmo-bts/gsm_data.h>
 
 struct gsm_bts_bb_trx {
@@ -19,6 +21,13 @@ struct gsm_bts_trx {
 	/* how do we talk RSL with this TRX? */
 	uint8_t rsl_tei;
 	struct e1inp_sign_link *rsl_link;
+	/* RSL messages waiting to be sent together, see abis.c */
+	struct {
+		struct llist_head queue;
+		unsigned int num;
+		unsigned int len;
+		struct osmo_timer_list timer;
+	} rsl_tx;
 
 	/* NM Radio Carrier and Baseband Transciever */
 	struct gsm_abis_mo mo;
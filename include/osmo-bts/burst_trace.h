@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Binary trace of per-burst scheduler events, see contrib/burst_trace_decode.py
+ * for decoding a dump.  The record layout is part of the dump format, bump
+ * BURST_TRACE_VERSION when changing it. */
+
+#define BURST_TRACE_MAGIC	"OBTR"
+#define BURST_TRACE_VERSION	1
+
+enum burst_trace_event {
+	BURST_TRACE_EV_TRXD_RX = 1,	/* UL burst received from the transceiver */
+	BURST_TRACE_EV_UL_BURST,	/* UL burst passed to a logical channel handler */
+	BURST_TRACE_EV_UL_DATA,		/* UL block decoded, arg: BER (1/10000) */
+	BURST_TRACE_EV_DL_DEQUEUE,	/* DL primitive lookup, arg: 1 if found */
+	BURST_TRACE_EV_DL_BURST,	/* DL burst generated, arg: burst length */
+};
+
+struct burst_trace_rec {
+	uint64_t time_ns;	/* CLOCK_MONOTONIC */
+	uint32_t fn;		/* TDMA frame number */
+	uint8_t event;		/* see enum burst_trace_event */
+	uint8_t trx;		/* TRX number */
+	uint8_t tn;		/* timeslot number */
+	uint8_t chan;		/* enum trx_chan_type, 0xff if unknown */
+	int16_t toa256;		/* Timing of Arrival (1/256 symbol) */
+	int16_t ci_cb;		/* C/I (cB) */
+	int8_t rssi;		/* RSSI (dBm) */
+	uint8_t flags;		/* event specific flags, e.g. TRX_BI_F_* */
+	uint16_t arg;		/* event specific value */
+} __attribute__((packed));
+
+/* Header of a dump, followed by num_recs records, oldest first */
+struct burst_trace_file_hdr {
+	char magic[4];
+	uint8_t version;
+	uint8_t rec_len;
+	uint16_t spare;
+	uint32_t num_recs;
+} __attribute__((packed));
+
+struct burst_trace {
+	struct burst_trace_rec *recs;
+	uint32_t num_recs;		/* size of the ring (power of two) */
+	uint64_t head;			/* total number of records written */
+	char *crash_path;		/* dump to this file on abort() */
+};
+
+/* NULL if tracing is disabled */
+extern struct burst_trace *g_burst_trace;
+
+int burst_trace_set_size(void *ctx, unsigned int num_recs);
+void burst_trace_add(struct burst_trace *bt, enum burst_trace_event event,
+		     uint8_t trx, uint32_t fn, uint8_t tn, uint8_t chan,
+		     int8_t rssi, int16_t toa256, int16_t ci_cb,
+		     uint8_t flags, uint16_t arg);
+int burst_trace_dump(const struct burst_trace *bt, const char *path);
+void burst_trace_dump_crash(void);
+
+/* Cheap enough to be called for every burst if tracing is disabled */
+static inline void burst_trace(enum burst_trace_event event,
+			       uint8_t trx, uint32_t fn, uint8_t tn, uint8_t chan,
+			       int8_t rssi, int16_t toa256, int16_t ci_cb,
+			       uint8_t flags, uint16_t arg)
+{
+	if (g_burst_trace)
+		burst_trace_add(g_burst_trace, event, trx, fn, tn, chan,
+				rssi, toa256, ci_cb, flags, arg);
+}
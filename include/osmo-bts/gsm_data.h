@@ -30,6 +30,7 @@
 #include <osmo-bts/paging.h>
 #include <osmo-bts/tx_power.h>
 #include <osmo-bts/oml.h>
+#include <osmo-bts/latency.h>
 
 #define GSM_FR_BITS	260
 #define GSM_EFR_BITS	244
@@ -96,6 +97,8 @@ enum gsm_lchan_state {
 };
 
 #define MAX_NUM_UL_MEAS	104
+/* maximum number of measurements expected in one period (TCH) */
+#define MAX_NUM_UL_MEAS_LAST	25
 #define LC_UL_M_F_L1_VALID	(1 << 0)
 #define LC_UL_M_F_RES_VALID	(1 << 1)
 #define LC_UL_M_F_OSMO_EXT_VALID (1 << 2)
@@ -113,6 +116,32 @@ struct bts_ul_meas {
 	uint8_t inv_rssi;
 };
 
+/* SACCH system information, shared between the BTS and all lchans using the
+ * same contents.  Never modified once shared, see sacch_si_alloc(). */
+struct gsm_sacch_si {
+	/* number of references (BTS, lchans) */
+	unsigned int refcnt;
+	/* L2 (LAPDm UI) header + L3 */
+	sysinfo_buf_t buf;
+};
+
+/* running sums over the uplink measurements of a measurement period */
+struct bts_ul_meas_sum {
+	uint32_t ber10k_full;
+	uint32_t ber10k_sub;
+	uint32_t inv_rssi_full;
+	uint32_t inv_rssi_sub;
+	int32_t ci_full;
+	int32_t ci_sub;
+	int32_t toa256;
+	/* sum of the squared toa256 values, for the standard deviation */
+	int64_t toa256_sq;
+	int16_t toa256_min;
+	int16_t toa256_max;
+	/* number of SUB measurements */
+	uint8_t num_sub;
+};
+
 struct amr_mode {
 	uint8_t mode;
 	uint8_t threshold;
@@ -319,6 +348,8 @@ struct gsm_lchan {
 	uint8_t sapis_dl[23];
 	uint8_t sapis_ul[23];
 	struct lapdm_channel lapdm_ch;
+	/* arrival times of RLL messages queued in LAPDm, [DCCH/SACCH][SAPI0/SAPI3] */
+	struct bts_dl_lat_rll dl_lat_rll[2][2];
 	struct llist_head dl_tch_queue;
 	struct {
 		/* bitmask of all SI that are present/valid in si_buf */
@@ -326,17 +357,21 @@ struct gsm_lchan {
 		/* bitmask of all SI that do not mirror the BTS-global SI values */
 		uint32_t overridden;
 		uint32_t last;
-		/* buffers where we put the pre-computed SI:
-		   SI2Q_MAX_NUM is the max number of SI2quater messages (see 3GPP TS 44.018) */
-		sysinfo_buf_t buf[_MAX_SYSINFO_TYPE][SI2Q_MAX_NUM];
+		/* pre-computed SACCH SI, usually shared with the BTS */
+		struct gsm_sacch_si *sacch[_MAX_SYSINFO_TYPE];
 	} si;
 	struct {
 		uint8_t flags;
 		/* RSL measurement result number, 0 at lchan_act */
 		uint8_t res_nr;
-		/* number of measurements stored in array below */
+		/* number of measurements received in the current period */
 		uint8_t num_ul_meas;
-		struct bts_ul_meas uplink[MAX_NUM_UL_MEAS];
+		/* sums over all measurements of the current period */
+		struct bts_ul_meas_sum ul_sum;
+		/* the most recent measurements (ring buffer indexed by
+		 * num_ul_meas), only used if more measurements than expected
+		 * were received in a period */
+		struct bts_ul_meas uplink_last[MAX_NUM_UL_MEAS_LAST];
 		/* last L1 header from the MS */
 	        struct rsl_l1_info l1_info;
 		struct gsm_meas_rep_unidir ul_res;
@@ -505,7 +540,9 @@ struct gsm_bts_trx_ts {
 	struct gsm_lchan lchan[TS_MAX_LCHAN];
 };
 
-#define GSM_LCHAN_SI(lchan, i) (void *)((lchan)->si.buf[i][0])
+/* NULL if the lchan has no SACCH buffer for the given SI type */
+#define GSM_LCHAN_SI(lchan, i) \
+	((lchan)->si.sacch[i] ? (void *)((lchan)->si.sacch[i]->buf) : NULL)
 
 enum gprs_rlc_par {
 	RLC_T3142,
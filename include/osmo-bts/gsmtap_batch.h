@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <osmocom/core/gsmtap.h>
+
+struct mmsghdr;
+struct iovec;
+
+/* Maximum payload of a queued GSMTAP frame */
+#define GSMTAP_BATCH_MAX_LEN	256
+
+struct gsmtap_batch_rec {
+	struct gsmtap_hdr hdr;
+	uint8_t data[GSMTAP_BATCH_MAX_LEN];
+	uint16_t len;
+};
+
+/* Ring of GSMTAP frames, sent with one system call per flush */
+struct gsmtap_batch {
+	int fd;				/* connected GSMTAP socket */
+	unsigned int num_recs;		/* size of the ring (power of two) */
+	unsigned int head;		/* next record to write */
+	unsigned int tail;		/* next record to send */
+	struct gsmtap_batch_rec *recs;
+	struct mmsghdr *msgs;
+	struct iovec *iov;
+};
+
+struct gsmtap_batch *gsmtap_batch_alloc(void *ctx, int fd, unsigned int num_recs);
+void gsmtap_batch_free(struct gsmtap_batch *gb);
+int gsmtap_batch_enqueue(struct gsmtap_batch *gb, uint16_t arfcn, uint8_t ts,
+			 uint8_t chan_type, uint8_t ss, uint32_t fn,
+			 int8_t signal_dbm, int8_t snr,
+			 const uint8_t *data, unsigned int len);
+int gsmtap_batch_flush(struct gsmtap_batch *gb);
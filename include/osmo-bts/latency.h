@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <osmocom/core/utils.h>
+
+struct msgb;
+struct gsm_bts;
+struct gsm_lchan;
+struct rate_ctr_group;
+
+/* End-to-end latency through the BTS, per SAPI.
+ *
+ * Downlink: messages are stamped with their arrival time (RSL in down_rsl(),
+ * RTP in l1sap_rtp_rx_cb(), PCU in pcu_rx_data_req()) in the msgb control
+ * buffer.  The stamp follows the message through the AGCH and TCH queues
+ * into the PH-DATA.req/TCH.req.  LAPDm builds new frames, so the arrival
+ * times of RLL messages are kept in a small FIFO per lchan, LAPDm entity
+ * and SAPI instead.  The latency is accounted when the L1 scheduler
+ * dequeues the primitive for its first burst.
+ *
+ * Uplink: osmo-bts-trx notes the time a TRXD PDU was received.  When the
+ * last burst of a block has been decoded and the L1 scheduler passes the
+ * result up, the decode time (reception to decoded) is accounted and the
+ * block becomes the current Uplink context.  Processing is synchronous, so
+ * RTP frames and PCU DATA.ind emitted within that context account the queue
+ * time (decoded to handed to RTP/PCU).  RSL DATA/UNIT DATA IND and MEAS RES
+ * may be held back for coalescing, so they carry the decode time in the
+ * msgb control buffer and account it when handed to libosmo-abis.
+ *
+ * Timestamps are CLOCK_MONOTONIC microseconds, truncated to 32 bit (they
+ * wrap after ~71 minutes, which unsigned subtraction handles); 0 means
+ * "not stamped". */
+
+enum bts_lat_sapi {
+	BTS_LAT_SAPI_CCCH,	/* AGCH (IMM ASS/REJ from RSL or PCU) */
+	BTS_LAT_SAPI_DCCH,	/* RLL SAPI 0 on SDCCH or FACCH */
+	BTS_LAT_SAPI_SACCH,	/* RLL SAPI 0 on SACCH */
+	BTS_LAT_SAPI_SAPI3,	/* RLL SAPI 3 (SMS) on any channel */
+	BTS_LAT_SAPI_TCH,	/* speech/data frames from RTP */
+	BTS_LAT_SAPI_PDTCH,	/* PDTCH/PTCCH blocks from the PCU */
+	_NUM_BTS_LAT_SAPI
+};
+extern const struct value_string bts_lat_sapi_names[];
+
+/* number of histogram buckets, the last one is open */
+#define BTS_LAT_NUM_BUCKETS	8
+
+struct bts_lat_stats {
+	/* histogram, one rate counter per bucket */
+	struct rate_ctr_group *ctrs;
+	/* upper bound of each bucket but the last one */
+	const uint32_t *bucket_us;
+	uint64_t samples;
+	uint64_t sum_us;
+	uint32_t max_us;
+};
+
+/* Access 4th and 5th part of msgb control buffer */
+#define msgb_dl_lat_ts(x) ((x)->cb[3])
+#define msgb_dl_lat_sapi(x) ((x)->cb[4])
+/* Same slots for Uplink RSL messages, see bts_ul_lat_rsl_stamp() */
+#define msgb_ul_lat_ts(x) ((x)->cb[3])
+#define msgb_ul_lat_sapi(x) ((x)->cb[4])
+
+/* Depth of the per-SAPI FIFO of RLL arrival times */
+#define BTS_DL_LAT_RLL_DEPTH	4
+
+struct bts_dl_lat_rll {
+	uint32_t ts_us[BTS_DL_LAT_RLL_DEPTH];
+	uint8_t head;
+	uint8_t len;
+	/* N(S) of the last I frame sent, -1 if none */
+	int8_t last_ns;
+};
+
+uint32_t bts_lat_now_us(void);
+int bts_lat_init(struct gsm_bts *bts);
+void bts_lat_stats_add(struct bts_lat_stats *st, uint32_t lat_us);
+
+void bts_dl_lat_stamp(struct msgb *msg, enum bts_lat_sapi sapi);
+void bts_dl_lat_account(struct gsm_bts *bts, const struct msgb *msg);
+
+void bts_dl_lat_rll_reset(struct gsm_lchan *lchan);
+void bts_dl_lat_rll_reset_sapi(struct gsm_lchan *lchan, bool sacch, uint8_t sapi);
+void bts_dl_lat_rll_push(struct gsm_lchan *lchan, bool sacch, uint8_t sapi, uint32_t ts_us);
+void bts_dl_lat_rll_pop(struct gsm_lchan *lchan, const uint8_t *frame, unsigned int len,
+			bool sacch, struct msgb *msg);
+
+void bts_ul_lat_set_rx(uint32_t rx_ts_us);
+void bts_ul_lat_decoded(struct gsm_bts *bts, enum bts_lat_sapi sapi);
+void bts_ul_lat_done(void);
+void bts_ul_lat_sent(struct gsm_bts *bts);
+void bts_ul_lat_rsl_stamp(struct msgb *msg);
+void bts_ul_lat_rsl_sent(struct gsm_bts *bts, const struct msgb *msg);
@@ -22,6 +22,8 @@ struct msgb;
 /* Access 3rd part of msgb control buffer */
 #define rtpmsg_ts(x) ((x)->cb[2])
 
+/* 4th and 5th part are used by msgb_dl_lat_ts() and msgb_dl_lat_sapi() */
+
 /**
  * Classification of OML message. ETSI for plain GSM 12.21
  * messages and IPA/Osmo for manufacturer messages.
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/utils.h>
+
+struct msgb;
+struct gsm_bts;
+struct gsm_lchan;
+
+/* Overload shedding: when the main loop does not keep up with the TDMA
+ * clock, non-essential work is disabled step by step, each level includes
+ * the previous ones.  The PHY feeds the controller once per frame clock
+ * tick with the time it took from the (nominal) start of the frame until
+ * the frame was scheduled, see bts_ovld_fn().  Currently only osmo-bts-trx
+ * does so, for all other PHYs the level stays at BTS_OVLD_L_NONE. */
+
+enum bts_ovld_level {
+	BTS_OVLD_L_NONE,	/* normal operation */
+	BTS_OVLD_L_GSMTAP,	/* no GSMTAP */
+	BTS_OVLD_L_LOGGING,	/* only log messages of level NOTICE or higher */
+	BTS_OVLD_L_INTERF,	/* no interference reports to BSC and PCU */
+	BTS_OVLD_L_MEAS_RES,	/* MEAS RES are queued and sent a few per frame */
+	_NUM_BTS_OVLD_L
+};
+extern const struct value_string bts_ovld_level_names[];
+
+struct bts_ovld {
+	bool enabled;
+	enum bts_ovld_level level;
+	/* thresholds in percent of a TDMA frame */
+	uint8_t high_pct;
+	uint8_t low_pct;
+	/* moving average of the frame processing time (us) */
+	uint32_t avg_us;
+	/* consecutive frames above the high / below the low threshold */
+	unsigned int hot_fn;
+	unsigned int calm_fn;
+	/* deferred RSL MEAS RES messages */
+	struct llist_head meas_res_queue;
+	unsigned int meas_res_queue_len;
+};
+
+void bts_ovld_init(struct gsm_bts *bts);
+void bts_ovld_reset(struct gsm_bts *bts);
+void bts_ovld_fn(struct gsm_bts *bts, uint32_t proc_us, unsigned int missed_fn);
+int bts_ovld_meas_res_defer(struct gsm_bts *bts, struct msgb *msg);
+void bts_ovld_meas_res_purge(struct gsm_lchan *lchan);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include <osmo-bts/pcuif_proto.h>
+
+struct msgb;
+
+/* Encoding (and, for testing and as reference for the PCU side, decoding) of
+ * PCU interface primitives, kept apart from the socket handling. */
+
+struct msgb *pcu_msgb_alloc(uint8_t msg_type, uint8_t bts_nr);
+
+/* INFO.ind as last sent to the PCU, base of INFO_DELTA.ind */
+struct pcu_info_state {
+	bool delta;		/* PCU requested INFO_DELTA.ind */
+	bool valid;		/* last was received by the PCU */
+	uint32_t seq;		/* seq of the last INFO_DELTA.ind, 0 after INFO.ind */
+	struct gsm_pcu_if_info_ind last;
+};
+
+int pcu_info_ind_encode(struct pcu_info_state *state, uint8_t bts_nr,
+			const struct gsm_pcu_if_info_ind *info_ind, struct msgb **msg_out);
+
+struct msgb *pcu_batch_alloc(uint8_t bts_nr);
+int pcu_batch_append(struct msgb *msg, uint8_t msg_type, const void *prim, uint8_t len);
+
+typedef int (*pcu_batch_elem_cb)(uint8_t msg_type, const void *data, uint8_t len, void *cb_data);
+int pcu_batch_decode(const struct gsm_pcu_if *pcu_prim, size_t prim_len,
+		     pcu_batch_elem_cb cb, void *cb_data);
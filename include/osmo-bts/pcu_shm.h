@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <osmocom/core/select.h>
+#include <osmo-bts/pcuif_proto.h>
+
+/* Called for each primitive read from the PCU->BTS ring */
+typedef int pcu_shm_rx_cb_t(struct gsm_pcu_if *pcu_prim, size_t len, void *data);
+
+struct pcu_shm {
+	struct gsm_pcu_if_shm *area;	/* mapped shared memory */
+	int mem_fd;			/* fd of the shared memory */
+	int tx_efd;			/* eventfd signalled by us */
+	struct osmo_fd rx_ofd;		/* eventfd signalled by the PCU */
+	bool tx_pending;		/* records written, but not signalled */
+
+	pcu_shm_rx_cb_t *rx_cb;
+	void *rx_cb_data;
+};
+
+void *pcu_shm_ring_reserve(struct gsm_pcu_if_shm_ring *ring, uint16_t len);
+void pcu_shm_ring_commit(struct gsm_pcu_if_shm_ring *ring, uint16_t len);
+int pcu_shm_ring_read(struct gsm_pcu_if_shm_ring *ring,
+		      pcu_shm_rx_cb_t *cb, void *cb_data);
+
+bool pcu_shm_supported(void);
+struct pcu_shm *pcu_shm_alloc(void *ctx, pcu_shm_rx_cb_t *rx_cb, void *rx_cb_data);
+void pcu_shm_free(struct pcu_shm *shm);
+int pcu_shm_tx(struct pcu_shm *shm, uint8_t msg_type, uint8_t bts_nr,
+	       const void *prim, uint16_t len);
+void pcu_shm_tx_flush(struct pcu_shm *shm);
@@ -9,6 +9,9 @@
 #define PCU_IF_VERSION		0x0a
 #define TXT_MAX_LEN	128
 
+/* maximum size of a PCU_IF_MSG_BATCH_IND primitive (including header) */
+#define PCU_IF_BATCH_MAX_LEN	4096
+
 /* msg_type */
 #define PCU_IF_MSG_DATA_REQ	0x00	/* send data to given channel */
 #define PCU_IF_MSG_DATA_CNF	0x01	/* confirm (e.g. transmission on PCH) */
@@ -19,9 +22,15 @@
 #define PCU_IF_MSG_DATA_CNF_DT	0x11	/* confirm (with direct tlli) */
 #define PCU_IF_MSG_RACH_IND	0x22	/* receive RACH */
 #define PCU_IF_MSG_INFO_IND	0x32	/* retrieve BTS info */
+#define PCU_IF_MSG_INFO_DELTA_IND 0x33	/* changed TS entries of BTS info */
+#define PCU_IF_MSG_INFO_DELTA_REQ 0x34	/* PCU requests INFO_DELTA.ind */
 #define PCU_IF_MSG_ACT_REQ	0x40	/* activate/deactivate PDCH */
 #define PCU_IF_MSG_TIME_IND	0x52	/* GSM time indication */
 #define PCU_IF_MSG_INTERF_IND	0x53	/* interference report */
+#define PCU_IF_MSG_BATCH_IND	0x54	/* batch of RTS/DATA/TIME indications */
+#define PCU_IF_MSG_BATCH_REQ	0x55	/* PCU requests batched indications */
+#define PCU_IF_MSG_SHM_REQ	0x56	/* PCU requests shared memory data plane */
+#define PCU_IF_MSG_SHM_CNF	0x57	/* BTS confirms shared memory data plane */
 #define PCU_IF_MSG_PAG_REQ	0x60	/* paging request */
 #define PCU_IF_MSG_TXT_IND	0x70	/* Text indication for BTS */
 #define PCU_IF_MSG_CONTAINER	0x80	/* Transparent container message */
@@ -39,6 +48,9 @@
 /* flags */
 #define PCU_IF_FLAG_ACTIVE	(1 << 0)/* BTS is active */
 #define PCU_IF_FLAG_SYSMO	(1 << 1)/* access PDCH of sysmoBTS directly */
+#define PCU_IF_FLAG_BATCH	(1 << 2)/* BTS supports PCU_IF_MSG_BATCH_REQ */
+#define PCU_IF_FLAG_SHM		(1 << 3)/* BTS supports PCU_IF_MSG_SHM_REQ */
+#define PCU_IF_FLAG_INFO_DELTA	(1 << 4)/* BTS supports PCU_IF_MSG_INFO_DELTA_REQ */
 #define PCU_IF_FLAG_CS1		(1 << 16)
 #define PCU_IF_FLAG_CS2		(1 << 17)
 #define PCU_IF_FLAG_CS3		(1 << 18)
@@ -179,6 +191,31 @@ struct gsm_pcu_if_info_ind {
 	} remote_ip[2];
 } __attribute__ ((packed));
 
+/* PCU asks BTS to (not) send INFO_DELTA.ind, only to be sent if
+ * PCU_IF_FLAG_INFO_DELTA is set in INFO.ind.  The BTS answers with a full
+ * INFO.ind, so this is also used to resynchronize after a lost update. */
+struct gsm_pcu_if_info_delta_req {
+	uint8_t		enable;
+	uint8_t		spare[3];
+} __attribute__ ((packed));
+
+struct gsm_pcu_if_info_delta_ts {
+	uint8_t		trx_nr;
+	uint8_t		ts_nr;
+	uint8_t		pdch;		/* 1 if set in pdch_mask, 0 otherwise */
+	uint8_t		spare;
+	struct gsm_pcu_if_info_trx_ts ts;
+} __attribute__ ((packed));
+
+/* Timeslot entries which changed since the previous INFO.ind or
+ * INFO_DELTA.ind.  Any other change is sent as a full INFO.ind. */
+struct gsm_pcu_if_info_delta_ind {
+	uint32_t	seq;		/* 1 after INFO.ind, incremented by one */
+	uint8_t		num_ts;
+	uint8_t		spare[3];
+	struct gsm_pcu_if_info_delta_ts ts[0];
+} __attribute__ ((packed));
+
 struct gsm_pcu_if_act_req {
 	uint8_t		activate;
 	uint8_t		trx_nr;
@@ -218,6 +255,45 @@ struct gsm_pcu_if_interf_ind {
 	uint8_t		interf[8];
 } __attribute__ ((packed));
 
+/* PCU asks BTS to (not) send RTS.req, DATA.ind and TIME.ind in batches,
+ * only to be sent if PCU_IF_FLAG_BATCH is set in INFO.ind */
+struct gsm_pcu_if_batch_req {
+	uint8_t		enable;
+	uint8_t		spare[3];
+} __attribute__ ((packed));
+
+/* One primitive within a batch */
+struct gsm_pcu_if_batch_elem {
+	uint8_t		msg_type;	/* PCU_IF_MSG_{RTS_REQ,DATA_IND,TIME_IND} */
+	uint8_t		len;		/* length of data */
+	uint8_t		data[0];	/* gsm_pcu_if_{rts_req,data,time_ind} */
+} __attribute__ ((packed));
+
+/* All RTS.req, DATA.ind and TIME.ind generated by the BTS in one scheduling
+ * round (typically one TDMA frame), in the order they were generated */
+struct gsm_pcu_if_batch_ind {
+	uint16_t	num_elems;
+	uint16_t	length;		/* total length of elems */
+	uint8_t		elems[0];	/* struct gsm_pcu_if_batch_elem */
+} __attribute__ ((packed));
+
+/* PCU asks BTS to (not) use the shared memory data plane, only to be sent
+ * if PCU_IF_FLAG_SHM is set in INFO.ind */
+struct gsm_pcu_if_shm_req {
+	uint8_t		enable;
+	uint8_t		spare[3];
+} __attribute__ ((packed));
+
+/* BTS answers PCU_IF_MSG_SHM_REQ.  On success, three file descriptors are
+ * passed as SCM_RIGHTS ancillary data: the shared memory (to be mapped with
+ * the given size), the eventfd signalled by the BTS and the eventfd to be
+ * signalled by the PCU whenever new records were written to a ring. */
+struct gsm_pcu_if_shm_cnf {
+	uint8_t		result;		/* 0 on success, errno otherwise */
+	uint8_t		spare[3];
+	uint32_t	size;		/* size of struct gsm_pcu_if_shm */
+} __attribute__ ((packed));
+
 /* Contains messages transmitted BSC<->PCU, potentially forwarded by BTS via IPA/PCU */
 struct gsm_pcu_if_container {
 	uint8_t		msg_type;
@@ -242,13 +318,69 @@ struct gsm_pcu_if {
 		struct gsm_pcu_if_rach_ind	rach_ind;
 		struct gsm_pcu_if_txt_ind	txt_ind;
 		struct gsm_pcu_if_info_ind	info_ind;
+		struct gsm_pcu_if_info_delta_ind info_delta_ind;
+		struct gsm_pcu_if_info_delta_req info_delta_req;
 		struct gsm_pcu_if_act_req	act_req;
 		struct gsm_pcu_if_time_ind	time_ind;
 		struct gsm_pcu_if_pag_req	pag_req;
 		struct gsm_pcu_if_app_info_req	app_info_req;
 		struct gsm_pcu_if_interf_ind	interf_ind;
 		struct gsm_pcu_if_container	container;
+		struct gsm_pcu_if_batch_req	batch_req;
+		struct gsm_pcu_if_batch_ind	batch_ind;
+		struct gsm_pcu_if_shm_req	shm_req;
+		struct gsm_pcu_if_shm_cnf	shm_cnf;
 	} u;
 } __attribute__ ((packed));
 
+/*
+ * Shared memory data plane
+ *
+ * Once PCU_IF_MSG_SHM_CNF was exchanged, the BTS sends RTS.req, TIME.ind and
+ * the DATA.ind of PDTCH and PTCCH through the BTS->PCU ring, and the PCU
+ * sends its DATA.req of PDTCH, PTCCH, PCH and AGCH through the PCU->BTS ring.
+ * All other primitives continue to use the socket.
+ *
+ * Each ring has a single producer and a single consumer.  A record consists
+ * of struct gsm_pcu_if_shm_rec followed by a struct gsm_pcu_if, which may be
+ * truncated after its union member, and is padded to a multiple of 4 bytes.
+ * A record never wraps around the end of the ring; instead, a record with
+ * len == PCU_IF_SHM_REC_WRAP tells the consumer to continue at offset 0.
+ *
+ * head and tail are free running byte counters: the producer only writes
+ * head (with release semantics, after writing the record), the consumer only
+ * writes tail (after processing the record).
+ */
+
+#define PCU_IF_SHM_MAGIC	0x50435553	/* "PCUS" */
+#define PCU_IF_SHM_RING_SIZE	(256 * 1024)	/* shall be a power of 2 */
+#define PCU_IF_SHM_REC_WRAP	0xffff
+
+enum gsm_pcu_if_shm_ring_dir {
+	PCU_IF_SHM_RING_BTS2PCU,
+	PCU_IF_SHM_RING_PCU2BTS,
+};
+
+struct gsm_pcu_if_shm_rec {
+	uint16_t	len;		/* length of the primitive */
+	uint16_t	spare;
+	uint8_t		data[0];	/* struct gsm_pcu_if */
+};
+
+struct gsm_pcu_if_shm_ring {
+	/* head and tail are on different cache lines */
+	uint32_t	head;
+	uint32_t	spare1[15];
+	uint32_t	tail;
+	uint32_t	spare2[15];
+	uint8_t		data[PCU_IF_SHM_RING_SIZE];
+};
+
+struct gsm_pcu_if_shm {
+	uint32_t	magic;
+	uint32_t	ring_size;
+	uint32_t	spare[14];
+	struct gsm_pcu_if_shm_ring ring[2];	/* see gsm_pcu_if_shm_ring_dir */
+};
+
 #endif /* _PCUIF_PROTO_H */
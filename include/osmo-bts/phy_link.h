@@ -59,7 +59,13 @@ struct phy_link {
 			uint16_t bts_mcast_port;
 			char *ms_mcast_group;		/* MS are listening to this group */
 			uint16_t ms_mcast_port;
+			bool batching;			/* use sendmmsg()/recvmmsg() */
+			int transport;			/* enum virt_um_transport */
+			char **unicast_peers;		/* MS side addresses (unicast) */
+			unsigned int num_unicast_peers;
+			char *shm_name;			/* shared memory object (shm) */
 			struct virt_um_inst *virt_um;
+			struct phy_instance **arfcn_map; /* ARFCN -> PHY instance */
 		} virt;
 		struct {
 			/* MAC address of the PHY */
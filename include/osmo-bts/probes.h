@@ -0,0 +1,52 @@
+#pragma once
+
+/* USDT (static user space tracepoints) for perf and bpftrace, compiled in
+ * with './configure --enable-usdt'.  All probes belong to the provider
+ * 'osmo_bts', see contrib/bpftrace/ for examples.  A disabled probe costs a
+ * NOP, its arguments are only evaluated into registers.
+ *
+ * Probes and their arguments:
+ *
+ *   sched_fn_entry	fn
+ *   sched_fn_return	fn
+ *   trxd_pdu		trx, fn, tn, pdu_ver, burst_len
+ *   ul_burst_entry	trx, fn, tn, chan, bid
+ *   ul_burst_return	trx, fn, tn, chan, bid
+ *   dl_burst_entry	trx, fn, tn, chan, bid
+ *   dl_burst_return	trx, fn, tn, chan, burst_len
+ *   dl_dequeue		trx, fn, tn, chan, found
+ *   ul_data_ind	trx, fn, tn, chan, l2_len
+ *   ul_tch_ind		trx, fn, tn, chan, tch_len
+ *   l1sap_up		trx, prim, op, chan_nr, fn
+ *   l1sap_down		trx, prim, op, chan_nr, fn
+ *   paging_gen_msg	bts, fn, len
+ *   agch_enqueue	bts, queue_len
+ *   rsl_down		trx, msg_type, chan_nr
+ *
+ * chan is an enum trx_chan_type, fn is 0 where not applicable. */
+
+#ifdef ENABLE_USDT
+
+#include <sys/sdt.h>
+
+#define BTS_PROBE1(name, a1) \
+	DTRACE_PROBE1(osmo_bts, name, a1)
+#define BTS_PROBE2(name, a1, a2) \
+	DTRACE_PROBE2(osmo_bts, name, a1, a2)
+#define BTS_PROBE3(name, a1, a2, a3) \
+	DTRACE_PROBE3(osmo_bts, name, a1, a2, a3)
+#define BTS_PROBE5(name, a1, a2, a3, a4, a5) \
+	DTRACE_PROBE5(osmo_bts, name, a1, a2, a3, a4, a5)
+
+#else
+
+#define BTS_PROBE1(name, a1) \
+	do { } while (0)
+#define BTS_PROBE2(name, a1, a2) \
+	do { } while (0)
+#define BTS_PROBE3(name, a1, a2, a3) \
+	do { } while (0)
+#define BTS_PROBE5(name, a1, a2, a3, a4, a5) \
+	do { } while (0)
+
+#endif
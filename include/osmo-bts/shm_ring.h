@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Single producer, single consumer ring of records in shared memory, as
+ * used by the PCU interface (see pcuif_proto.h) and the Virtual Um.
+ *
+ * A record is a 16 bit length (host byte order) and 16 bit spare,
+ * followed by the payload, padded to a multiple of 4 bytes.  Records do
+ * not wrap around the end of the ring: a length of SHM_RING_REC_WRAP
+ * means that the rest of the ring is unused and the next record starts
+ * at offset 0.  head and tail are free running byte counters, the
+ * producer only writes head (with release semantics) and the consumer
+ * only writes tail. */
+
+#define SHM_RING_REC_WRAP	0xffff
+
+struct shm_ring_rec {
+	uint16_t len;
+	uint16_t spare;
+	uint8_t data[0];
+} __attribute__((packed));
+
+/* View of a ring, the layout of head, tail and data is up to the user */
+struct shm_ring {
+	uint32_t *head;
+	uint32_t *tail;
+	uint8_t *data;
+	uint32_t size;
+	/* for logging corrupted records */
+	int log_subsys;
+	const char *name;
+};
+
+/* View of a ring struct with head, tail and data[] members */
+#define SHM_RING(r, subsys, ring_name) \
+	((struct shm_ring) { &(r)->head, &(r)->tail, (r)->data, sizeof((r)->data), subsys, ring_name })
+
+/* Called for each record read, data is only valid during the call */
+typedef void shm_ring_rx_cb_t(const uint8_t *data, uint16_t len, void *cb_data);
+
+void *shm_ring_reserve(const struct shm_ring *ring, uint16_t len);
+void shm_ring_commit(const struct shm_ring *ring, uint16_t len);
+int shm_ring_read(const struct shm_ring *ring, shm_ring_rx_cb_t *cb, void *cb_data);
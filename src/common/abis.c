@@ -43,6 +43,7 @@
 #include <osmocom/abis/e1_input.h>
 #include <osmocom/abis/ipaccess.h>
 #include <osmocom/gsm/ipa.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
 
 #include <osmo-bts/abis.h>
 #include <osmo-bts/logging.h>
@@ -217,6 +218,7 @@ static void abis_link_connected(struct osmo_fsm_inst *fi, uint32_t event, void *
 
 	/* Then iterate over the RSL signalling links */
 	llist_for_each_entry(trx, &bts->trx_list, list) {
+		abis_rsl_tx_discard(trx);
 		if (trx->rsl_link) {
 			e1inp_sign_link_destroy(trx->rsl_link);
 			trx->rsl_link = NULL;
@@ -333,18 +335,130 @@ int abis_oml_sendmsg(struct msgb *msg)
 	return abis_sendmsg(msg);
 }
 
+/*
+ * RSL transmit coalescing: if enabled, RSL messages generated within a
+ * short window are collected per TRX and handed over to libosmo-abis
+ * together at the end of the window.  They are queued back to back on the
+ * signalling link and leave the BTS in one burst, sharing TCP segments,
+ * instead of trickling out one by one.
+ */
+
+#define RSL_TX_COALESCE_MAX_MSGS	32
+#define RSL_TX_COALESCE_MAX_LEN		4096
+
+/* Messages the BSC is waiting for, these are never delayed */
+static bool rsl_tx_is_urgent(const struct msgb *msg)
+{
+	const struct abis_rsl_common_hdr *rh = (const struct abis_rsl_common_hdr *) msg->data;
+
+	if (msgb_length(msg) < sizeof(*rh))
+		return true;
+
+	switch (rh->msg_type) {
+	case RSL_MT_CHAN_RQD:
+	case RSL_MT_HANDO_DET:
+	case RSL_MT_CHAN_ACTIV_ACK:
+	case RSL_MT_CHAN_ACTIV_NACK:
+	case RSL_MT_CONN_FAIL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Hand the queued messages over to libosmo-abis, in order */
+static void rsl_tx_flush(struct gsm_bts_trx *trx)
+{
+	unsigned int num = trx->rsl_tx.num;
+	struct msgb *msg, *msg2;
+
+	osmo_timer_del(&trx->rsl_tx.timer);
+
+	if (llist_empty(&trx->rsl_tx.queue))
+		return;
+
+	if (!trx->rsl_link) {
+		abis_rsl_tx_discard(trx);
+		return;
+	}
+
+	llist_for_each_entry_safe(msg, msg2, &trx->rsl_tx.queue, list) {
+		llist_del(&msg->list);
+		bts_ul_lat_rsl_sent(trx->bts, msg);
+		abis_sendmsg(msg);
+	}
+	trx->rsl_tx.num = 0;
+	trx->rsl_tx.len = 0;
+
+	rate_ctr_inc2(trx->bts->ctrs, BTS_CTR_RSL_TX_BATCHES);
+	rate_ctr_add2(trx->bts->ctrs, BTS_CTR_RSL_TX_MSGS, num);
+}
+
+static void rsl_tx_timer_cb(void *data)
+{
+	rsl_tx_flush(data);
+}
+
+static int rsl_tx_enqueue(struct gsm_bts_trx *trx, struct msgb *msg)
+{
+	bool urgent = rsl_tx_is_urgent(msg);
+
+	llist_add_tail(&msg->list, &trx->rsl_tx.queue);
+	trx->rsl_tx.num++;
+	trx->rsl_tx.len += sizeof(struct ipaccess_head) + msgb_length(msg);
+
+	if (urgent || trx->rsl_tx.num >= RSL_TX_COALESCE_MAX_MSGS
+	    || trx->rsl_tx.len >= RSL_TX_COALESCE_MAX_LEN) {
+		rsl_tx_flush(trx);
+		return 0;
+	}
+
+	if (!osmo_timer_pending(&trx->rsl_tx.timer)) {
+		osmo_timer_setup(&trx->rsl_tx.timer, rsl_tx_timer_cb, trx);
+		osmo_timer_schedule(&trx->rsl_tx.timer, 0, trx->bts->rsl_tx_coalesce_us);
+	}
+
+	return 0;
+}
+
+/*! Drop all RSL messages waiting to be coalesced on a TRX. */
+void abis_rsl_tx_discard(struct gsm_bts_trx *trx)
+{
+	struct msgb *msg, *msg2;
+
+	osmo_timer_del(&trx->rsl_tx.timer);
+	llist_for_each_entry_safe(msg, msg2, &trx->rsl_tx.queue, list) {
+		llist_del(&msg->list);
+		msgb_free(msg);
+	}
+	trx->rsl_tx.num = 0;
+	trx->rsl_tx.len = 0;
+}
+
 int abis_bts_rsl_sendmsg(struct msgb *msg)
 {
-	OSMO_ASSERT(msg->trx);
+	struct gsm_bts_trx *trx = msg->trx;
+
+	OSMO_ASSERT(trx);
 
-	if (msg->trx->bts->variant == BTS_OSMO_OMLDUMMY) {
+	if (trx->bts->variant == BTS_OSMO_OMLDUMMY) {
 		msgb_free(msg);
 		return 0;
 	}
 
+	bts_ul_lat_rsl_stamp(msg);
+
 	/* osmo-bts uses msg->trx internally, but libosmo-abis uses
 	 * the signalling link at msg->dst */
-	msg->dst = msg->trx->rsl_link;
+	msg->dst = trx->rsl_link;
+
+	if (trx->bts->rsl_tx_coalesce_us && trx->rsl_link)
+		return rsl_tx_enqueue(trx, msg);
+
+	/* coalescing was disabled in the meantime, keep the order */
+	rsl_tx_flush(trx);
+	if (trx->rsl_link)
+		bts_ul_lat_rsl_sent(trx->bts, msg);
 	return abis_sendmsg(msg);
 }
 
@@ -37,6 +37,7 @@
 #include <osmocom/core/rate_ctr.h>
 #include <osmocom/gsm/protocol/gsm_12_21.h>
 #include <osmocom/gsm/gsm48.h>
+#include <osmocom/gsm/gsm0502.h>
 #include <osmocom/gsm/lapdm.h>
 #include <osmocom/trau/osmo_ortp.h>
 
@@ -54,6 +55,7 @@
 #include <osmo-bts/bts_shutdown_fsm.h>
 #include <osmo-bts/nm_common_fsm.h>
 #include <osmo-bts/power_control.h>
+#include <osmo-bts/probes.h>
 
 #define MIN_QUAL_RACH	 50 /* minimum link quality (in centiBels) for Access Bursts */
 #define MIN_QUAL_NORM	 -5 /* minimum link quality (in centiBels) for Normal Bursts */
@@ -103,6 +105,17 @@ static const struct rate_ctr_desc bts_ctr_desc[] = {
 	[BTS_CTR_AGCH_RCVD] =		{"agch:rcvd", "Received AGCH requests (Abis)"},
 	[BTS_CTR_AGCH_SENT] =		{"agch:sent", "Sent AGCH requests (Abis)"},
 	[BTS_CTR_AGCH_DELETED] =	{"agch:delete", "Sent AGCH DELETE IND (Abis)"},
+
+	[BTS_CTR_RSL_TX_BATCHES] =	{"rsl:tx_batches", "Batches of coalesced RSL messages (Abis)"},
+	[BTS_CTR_RSL_TX_MSGS] =		{"rsl:tx_coalesced", "RSL messages sent in batches (Abis)"},
+
+	[BTS_CTR_GSMTAP_DROPPED] =	{"gsmtap:drop", "Dropped GSMTAP frames (queue full)"},
+
+	[BTS_CTR_OVLD_GSMTAP] =		{"overload:gsmtap", "TDMA frames at overload level 'gsmtap'"},
+	[BTS_CTR_OVLD_LOGGING] =	{"overload:logging", "TDMA frames at overload level 'logging'"},
+	[BTS_CTR_OVLD_INTERF] =		{"overload:interference", "TDMA frames at overload level 'interference'"},
+	[BTS_CTR_OVLD_MEAS_RES] =	{"overload:meas_res", "TDMA frames at overload level 'meas-res'"},
+	[BTS_CTR_OVLD_MEAS_RES_DROP] =	{"overload:meas_res_drop", "Deferred MEAS RES dropped (queue full)"},
 };
 static const struct rate_ctr_group_desc bts_ctrg_desc = {
 	"bts",
@@ -313,7 +326,7 @@ int bts_init(struct gsm_bts *bts)
 
 	bts->band = GSM_BAND_1800;
 
-	INIT_LLIST_HEAD(&bts->agch_queue.queue);
+	bts->agch_queue.head = 0;
 	bts->agch_queue.length = 0;
 
 	bts->ctrs = rate_ctr_group_alloc(bts, &bts_ctrg_desc, bts->nr);
@@ -322,6 +335,13 @@ int bts_init(struct gsm_bts *bts)
 		return -1;
 	}
 
+	if (bts_lat_init(bts) < 0) {
+		llist_del(&bts->list);
+		return -1;
+	}
+
+	bts_ovld_init(bts);
+
 	/* enable management with default levels,
 	 * raise threshold to GSM_BTS_AGCH_QUEUE_THRESH_LEVEL_DISABLE to
 	 * disable this feature.
@@ -353,6 +373,8 @@ int bts_init(struct gsm_bts *bts)
 	bts->min_qual_norm = MIN_QUAL_NORM;
 	bts->max_ber10k_rach = 1707; /* 7 of 41 bits is Eb/N0 of 0 dB = 0.1707 */
 	bts->pcu.sock_path = talloc_strdup(bts, PCU_SOCK_DEFAULT);
+	bts->gsmtap.ts_mask = 0xff;
+	bts->gsmtap.sample_rate = 1;
 	for (i = 0; i < ARRAY_SIZE(bts->t200_ms); i++)
 		bts->t200_ms[i] = oml_default_t200_ms[i];
 
@@ -511,6 +533,8 @@ int lchan_init_lapdm(struct gsm_lchan *lchan)
 	/* We still need to set Rx callback to receive RACH requests: */
 	lapdm_channel_set_l3(lc, lapdm_rll_tx_cb, lchan);
 
+	bts_dl_lat_rll_reset(lchan);
+
 	return 0;
 }
 
@@ -556,6 +580,34 @@ int bts_agch_max_queue_length(int T, int bcch_conf)
 	return (T + 2 * S) * ccch_rach_ratio256 / 256;
 }
 
+/* Maximum age (in TDMA frames) of an AGCH message after the RACH it is the
+ * response to, derived from T3126 (see 3GPP TS 44.018, 3.3.1.1.2 and 11.1.1):
+ * T+2S RACH slots of the MS, but at most 5 seconds.  tx_integer is the value
+ * of the Tx-integer field in SI3 (0..15). */
+uint32_t bts_agch_deadline_fn(unsigned int tx_integer_idx, int bcch_conf)
+{
+	const uint32_t max_fn = 5 * 1000000 / GSM_TDMA_FN_DURATION_uS;
+	int is_ccch_comb = 0;
+	uint32_t slots, fn;
+
+	if (tx_integer_idx >= ARRAY_SIZE(tx_integer))
+		return 0;
+
+	if (bcch_conf == RSL_BCCH_CCCH_CONF_1_C)
+		is_ccch_comb = 1;
+
+	slots = tx_integer[tx_integer_idx] + 2 * s_values[tx_integer_idx % 5][is_ccch_comb];
+
+	/* A non-combined CCCH has a RACH slot in each frame, a combined one
+	 * has 27 RACH slots per 51-multiframe */
+	if (is_ccch_comb)
+		fn = slots * 51 / 27;
+	else
+		fn = slots;
+
+	return fn < max_fn ? fn : max_fn;
+}
+
 static void bts_update_agch_max_queue_length(struct gsm_bts *bts)
 {
 	struct gsm48_system_information_type_3 *si3;
@@ -569,6 +621,9 @@ static void bts_update_agch_max_queue_length(struct gsm_bts *bts)
 	bts->agch_queue.max_length =
 		bts_agch_max_queue_length(si3->rach_control.tx_integer,
 					  si3->control_channel_desc.ccch_conf);
+	bts->agch_queue.deadline_fn =
+		bts_agch_deadline_fn(si3->rach_control.tx_integer,
+				     si3->control_channel_desc.ccch_conf);
 
 	if (bts->agch_queue.max_length != old_max_length)
 		LOGP(DRSL, LOGL_INFO, "Updated AGCH max queue length to %d\n",
@@ -702,10 +757,128 @@ static int try_merge_imm_ass_rej(struct gsm48_imm_ass_rej *old_rej,
 	return 0;
 }
 
+/* Check whether the given IMMEDIATE ASSIGNMENT can be packed into an
+ * IMMEDIATE ASSIGNMENT EXTENDED: it shall assign a dedicated channel without
+ * frequency hopping, without Starting Time and without IA Rest Octets. */
+static bool imm_ass_is_packable(const struct gsm48_imm_ass *ia, unsigned int len)
+{
+	const uint8_t *data = (const uint8_t *) ia;
+	unsigned int i;
+
+	if (len < sizeof(*ia) || len > GSM_MACBLOCK_LEN)
+		return false;
+	if (ia->msg_type != GSM48_MT_RR_IMM_ASS)
+		return false;
+	/* Dedicated mode or TBF (upper nibble) shall be 'dedicated mode' */
+	if (ia->page_mode & 0xf0)
+		return false;
+	if (ia->mob_alloc_len != 0)
+		return false;
+	for (i = sizeof(*ia); i < len; i++) {
+		if (data[i] != GSM_MACBLOCK_PADDING)
+			return false;
+	}
+
+	return true;
+}
+
+/* Try to combine two IMMEDIATE ASSIGNMENTs into one IMMEDIATE ASSIGNMENT
+ * EXTENDED (3GPP TS 44.018 9.1.19), which replaces the message old_msg.
+ * Returns 1 if the messages were merged, 0 otherwise. */
+static int try_merge_imm_ass(struct msgb *old_msg, struct msgb *new_msg)
+{
+	struct gsm48_imm_ass *old_ia = msgb_l3(old_msg);
+	const struct gsm48_imm_ass *new_ia = msgb_l3(new_msg);
+	uint8_t *cur;
+
+	if (!imm_ass_is_packable(old_ia, msgb_l3len(old_msg)))
+		return 0;
+	if (!imm_ass_is_packable(new_ia, msgb_l3len(new_msg)))
+		return 0;
+	/* there is only one Page Mode IE for both assignments */
+	if (old_ia->page_mode != new_ia->page_mode)
+		return 0;
+	if (msgb_l3len(old_msg) + msgb_tailroom(old_msg) < GSM_MACBLOCK_LEN)
+		return 0;
+
+	/* The Channel Description, Request Reference and Timing Advance of
+	 * the first assignment are at the same position in both messages */
+	cur = (uint8_t *) &old_ia->timing_advance + 1;
+	memcpy(cur, &new_ia->chan_desc, sizeof(new_ia->chan_desc));
+	cur += sizeof(new_ia->chan_desc);
+	memcpy(cur, &new_ia->req_ref, sizeof(new_ia->req_ref));
+	cur += sizeof(new_ia->req_ref);
+	*cur++ = new_ia->timing_advance;
+	/* empty Mobile Allocation */
+	*cur++ = 0x00;
+
+	old_msg->l3h[0] = GSM48_LEN2PLEN(cur - old_msg->l3h - 1);
+	old_msg->l3h[2] = GSM48_MT_RR_IMM_ASS_EXT;
+
+	/* Pad the IAX Rest Octets */
+	if (msgb_l3len(old_msg) < GSM_MACBLOCK_LEN)
+		msgb_put(old_msg, GSM_MACBLOCK_LEN - msgb_l3len(old_msg));
+	memset(cur, GSM_MACBLOCK_PADDING, old_msg->l3h + GSM_MACBLOCK_LEN - cur);
+
+	return 1;
+}
+
+/* The Request Reference contains the RACH FN modulo 42432 (T1' has 5 bits) */
+#define REQ_REF_FN_MODULUS	(32 * 26 * 51)
+
+#define AGCH_RING_IDX(bts, n) \
+	(((bts)->agch_queue.head + (n)) % ARRAY_SIZE((bts)->agch_queue.ring))
+
+/* RACH FN (modulo 42432) of the given Request Reference */
+static uint32_t req_ref_fn(const struct gsm48_req_ref *ref)
+{
+	struct gsm_time gt = {
+		.t1 = ref->t1,
+		.t2 = ref->t2,
+		.t3 = (ref->t3_high << 3) | ref->t3_low,
+	};
+
+	return gsm_gsmtime2fn(&gt);
+}
+
+/* RACH FN of the most recent Request Reference in the given AGCH message,
+ * which is the last one of IMM ASS EXT and IMM ASS REJ, GSM_TDMA_HYPERFRAME
+ * if unknown */
+static uint32_t agch_msg_rach_fn(struct msgb *msg)
+{
+	const struct gsm48_imm_ass *ia = msgb_l3(msg);
+	const struct gsm48_imm_ass_rej *rej = msgb_l3(msg);
+	const uint8_t *data = msgb_l3(msg);
+	unsigned int len = msgb_l3len(msg);
+
+	if (len < 3)
+		return GSM_TDMA_HYPERFRAME;
+
+	switch (ia->msg_type) {
+	case GSM48_MT_RR_IMM_ASS:
+		if (len < sizeof(*ia))
+			return GSM_TDMA_HYPERFRAME;
+		return req_ref_fn(&ia->req_ref);
+	case GSM48_MT_RR_IMM_ASS_EXT:
+		/* Request Reference 2 is located at octets 14..16 */
+		if (len < 17)
+			return GSM_TDMA_HYPERFRAME;
+		return req_ref_fn((const struct gsm48_req_ref *) &data[14]);
+	case GSM48_MT_RR_IMM_ASS_REJ:
+		if (len < sizeof(*rej))
+			return GSM_TDMA_HYPERFRAME;
+		return req_ref_fn(&rej->req_ref4);
+	default:
+		return GSM_TDMA_HYPERFRAME;
+	}
+}
+
 int bts_agch_enqueue(struct gsm_bts *bts, struct msgb *msg)
 {
+	/* shall be smaller than BTS_AGCH_QUEUE_SIZE */
 	int hard_limit = 100;
 	struct gsm48_imm_ass_rej *imm_ass_cmd = msgb_l3(msg);
+	unsigned int idx;
 
 	if (bts->agch_queue.length > hard_limit) {
 		LOGP(DSUM, LOGL_ERROR,
@@ -719,33 +892,91 @@ int bts_agch_enqueue(struct gsm_bts *bts, struct msgb *msg)
 	}
 
 	if (bts->agch_queue.length > 0) {
-		struct msgb *last_msg =
-			llist_entry(bts->agch_queue.queue.prev, struct msgb, list);
-		struct gsm48_imm_ass_rej *last_imm_ass_rej = msgb_l3(last_msg);
+		struct msgb *last_msg;
+		struct gsm48_imm_ass_rej *last_imm_ass_rej;
+
+		idx = AGCH_RING_IDX(bts, bts->agch_queue.length - 1);
+		last_msg = bts->agch_queue.ring[idx].msg;
+		last_imm_ass_rej = msgb_l3(last_msg);
 
 		if (try_merge_imm_ass_rej(last_imm_ass_rej, imm_ass_cmd)) {
 			bts->agch_queue.merged_msgs++;
+			bts->agch_queue.ring[idx].rach_fn = agch_msg_rach_fn(last_msg);
+			msgb_free(msg);
+			return 0;
+		}
+
+		if (bts->agch_queue.imm_ass_ext && try_merge_imm_ass(last_msg, msg)) {
+			bts->agch_queue.merged_imm_ass_msgs++;
+			bts->agch_queue.ring[idx].rach_fn = agch_msg_rach_fn(last_msg);
 			msgb_free(msg);
 			return 0;
 		}
 	}
 
-	msgb_enqueue(&bts->agch_queue.queue, msg);
+	idx = AGCH_RING_IDX(bts, bts->agch_queue.length);
+	bts->agch_queue.ring[idx].msg = msg;
+	bts->agch_queue.ring[idx].rach_fn = agch_msg_rach_fn(msg);
 	bts->agch_queue.length++;
 
+	BTS_PROBE2(agch_enqueue, bts->nr, bts->agch_queue.length);
+
 	return 0;
 }
 
 struct msgb *bts_agch_dequeue(struct gsm_bts *bts)
 {
-	struct msgb *msg = msgb_dequeue(&bts->agch_queue.queue);
-	if (!msg)
+	struct msgb *msg;
+
+	if (bts->agch_queue.length == 0)
 		return NULL;
 
+	msg = bts->agch_queue.ring[bts->agch_queue.head].msg;
+	bts->agch_queue.ring[bts->agch_queue.head].msg = NULL;
+	bts->agch_queue.head = AGCH_RING_IDX(bts, 1);
 	bts->agch_queue.length--;
+
 	return msg;
 }
 
+/* Drop the oldest message of the queue and inform the BSC about it */
+static void agch_queue_drop_head(struct gsm_bts *bts)
+{
+	struct msgb *msg = bts_agch_dequeue(bts);
+
+	rsl_tx_delete_ind(bts, msgb_l3(msg), msgb_l3len(msg));
+	rate_ctr_inc2(bts->ctrs, BTS_CTR_AGCH_DELETED);
+	msgb_free(msg);
+
+	bts->agch_queue.dropped_msgs++;
+}
+
+/*
+ * Remove messages from the head of the queue which are older than the
+ * deadline, i.e. which the MS is not waiting for anymore.
+ */
+static void expire_agch_queue(struct gsm_bts *bts, uint32_t fn)
+{
+	if (bts->agch_queue.deadline_fn == 0)
+		return;
+
+	while (bts->agch_queue.length > 0) {
+		uint32_t rach_fn = bts->agch_queue.ring[bts->agch_queue.head].rach_fn;
+		uint32_t age;
+
+		if (rach_fn >= GSM_TDMA_HYPERFRAME)
+			return;
+
+		/* the hyperframe is a multiple of the Request Reference
+		 * modulus, so the difference stays valid across its wrap */
+		age = GSM_TDMA_FN_SUB(fn, rach_fn) % REQ_REF_FN_MODULUS;
+		if (age <= bts->agch_queue.deadline_fn)
+			return;
+
+		agch_queue_drop_head(bts);
+	}
+}
+
 /*
  * Remove lower prio messages if the queue has grown too long.
  *
@@ -754,7 +985,6 @@ struct msgb *bts_agch_dequeue(struct gsm_bts *bts)
  */
 static void compact_agch_queue(struct gsm_bts *bts)
 {
-	struct msgb *msg, *msg2;
 	int max_len, slope, offs;
 	int level_low = bts->agch_queue.low_level;
 	int level_high = bts->agch_queue.high_level;
@@ -782,8 +1012,7 @@ static void compact_agch_queue(struct gsm_bts *bts)
 	else
 		slope = 0x10000 * max_len; /* p_drop >= 1 if len > offs */
 
-	llist_for_each_entry_safe(msg, msg2, &bts->agch_queue.queue, list) {
-		struct gsm48_imm_ass *imm_ass_cmd = msgb_l3(msg);
+	while (bts->agch_queue.length > 0) {
 		int p_drop;
 
 		p_drop = (bts->agch_queue.length - offs) * slope / max_len;
@@ -791,29 +1020,31 @@ static void compact_agch_queue(struct gsm_bts *bts)
 		if ((random() & 0xffff) >= p_drop)
 			return;
 
-		llist_del(&msg->list);
-		bts->agch_queue.length--;
-		rsl_tx_delete_ind(bts, (uint8_t *)imm_ass_cmd, msgb_l3len(msg));
-		rate_ctr_inc2(bts->ctrs, BTS_CTR_AGCH_DELETED);
-		msgb_free(msg);
-
-		bts->agch_queue.dropped_msgs++;
+		agch_queue_drop_head(bts);
 	}
 	return;
 }
 
+/*! Fill a CCCH block with a paging or AGCH message.
+ *  \param[out] dl_lat_ts arrival time of the AGCH message (0 if none, or
+ *                        for paging), may be NULL.
+ *  \returns length of the message, <= 0 if there is nothing to send. */
 int bts_ccch_copy_msg(struct gsm_bts *bts, uint8_t *out_buf, struct gsm_time *gt,
-		      int is_ag_res)
+		      int is_ag_res, uint32_t *dl_lat_ts)
 {
 	struct msgb *msg = NULL;
 	int rc = 0;
 	int is_empty = 1;
 
+	if (dl_lat_ts)
+		*dl_lat_ts = 0;
+
 	/* Do queue house keeping.
 	 * This needs to be done every time a CCCH message is requested, since
 	 * the queue max length is calculated based on the CCCH block rate and
 	 * PCH messages also reduce the drain of the AGCH queue.
 	 */
+	expire_agch_queue(bts, gt->fn);
 	compact_agch_queue(bts);
 
 	/* Check for paging messages first if this is PCH */
@@ -833,6 +1064,8 @@ int bts_ccch_copy_msg(struct gsm_bts *bts, uint8_t *out_buf, struct gsm_time *gt
 	/* Copy AGCH message */
 	memcpy(out_buf, msgb_l3(msg), msgb_l3len(msg));
 	rc = msgb_l3len(msg);
+	if (dl_lat_ts)
+		*dl_lat_ts = msgb_dl_lat_ts(msg);
 	msgb_free(msg);
 
 	if (is_ag_res)
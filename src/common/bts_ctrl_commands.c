@@ -23,6 +23,8 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
+#include <inttypes.h>
 
 #include <osmocom/gsm/protocol/gsm_12_21.h>
 #include <osmocom/ctrl/control_cmd.h>
@@ -33,6 +35,7 @@
 #include <osmo-bts/signal.h>
 #include <osmo-bts/oml.h>
 #include <osmo-bts/bts.h>
+#include <osmo-bts/burst_trace.h>
 
 static struct gsm_bts *g_bts;
 
@@ -84,12 +87,92 @@ static int set_oml_alert(struct ctrl_cmd *cmd, void *data)
 	return CTRL_CMD_REPLY;
 }
 
+CTRL_CMD_DEFINE_WO_NOVRF(burst_trace_dump, "burst-trace-dump");
+static int set_burst_trace_dump(struct ctrl_cmd *cmd, void *data)
+{
+	int rc;
+
+	if (!g_burst_trace) {
+		cmd->reply = "Burst trace is disabled";
+		return CTRL_CMD_ERROR;
+	}
+
+	rc = burst_trace_dump(g_burst_trace, cmd->value);
+	if (rc < 0) {
+		cmd->reply = talloc_asprintf(cmd, "Failed to write %s: %s",
+					     cmd->value, strerror(-rc));
+		return CTRL_CMD_ERROR;
+	}
+
+	cmd->reply = talloc_asprintf(cmd, "%d", rc);
+
+	return CTRL_CMD_REPLY;
+}
+
+/* "<sapi>,<samples>,<avg_us>,<max_us>" for each SAPI, separated by ';'.
+ * The histograms are available as 'bts_dl_lat', 'bts_ul_dec' and
+ * 'bts_ul_queue' rate counters. */
+static char *lat_stats_str(void *ctx, const struct bts_lat_stats *stats)
+{
+	char *str = talloc_strdup(ctx, "");
+	unsigned int i;
+
+	for (i = 0; i < _NUM_BTS_LAT_SAPI; i++) {
+		const struct bts_lat_stats *st = &stats[i];
+
+		str = talloc_asprintf_append(str, "%s%s,%"PRIu64",%"PRIu64",%u",
+					     i ? ";" : "", get_value_string(bts_lat_sapi_names, i),
+					     st->samples, st->samples ? st->sum_us / st->samples : 0,
+					     st->max_us);
+	}
+
+	return str;
+}
+
+CTRL_CMD_DEFINE_RO(dl_latency, "dl-latency");
+static int get_dl_latency(struct ctrl_cmd *cmd, void *data)
+{
+	cmd->reply = lat_stats_str(cmd, g_bts->dl_lat);
+
+	return CTRL_CMD_REPLY;
+}
+
+CTRL_CMD_DEFINE_RO(ul_decode_latency, "ul-decode-latency");
+static int get_ul_decode_latency(struct ctrl_cmd *cmd, void *data)
+{
+	cmd->reply = lat_stats_str(cmd, g_bts->ul_dec);
+
+	return CTRL_CMD_REPLY;
+}
+
+CTRL_CMD_DEFINE_RO(ul_queue_latency, "ul-queue-latency");
+static int get_ul_queue_latency(struct ctrl_cmd *cmd, void *data)
+{
+	cmd->reply = lat_stats_str(cmd, g_bts->ul_queue);
+
+	return CTRL_CMD_REPLY;
+}
+
+/* current level of enum bts_ovld_level, 0 = no overload */
+CTRL_CMD_DEFINE_RO(overload_level, "overload-level");
+static int get_overload_level(struct ctrl_cmd *cmd, void *data)
+{
+	cmd->reply = talloc_asprintf(cmd, "%u", g_bts->ovld.level);
+
+	return CTRL_CMD_REPLY;
+}
+
 int bts_ctrl_cmds_install(struct gsm_bts *bts)
 {
 	int rc = 0;
 
 	rc |= ctrl_cmd_install(CTRL_NODE_TRX, &cmd_therm_att);
 	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_oml_alert);
+	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_burst_trace_dump);
+	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_dl_latency);
+	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_ul_decode_latency);
+	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_ul_queue_latency);
+	rc |= ctrl_cmd_install(CTRL_NODE_ROOT, &cmd_overload_level);
 	g_bts = bts;
 
 	return rc;
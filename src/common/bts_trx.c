@@ -22,6 +22,7 @@
 #include <osmocom/gsm/abis_nm.h>
 
 #include <osmo-bts/logging.h>
+#include <osmo-bts/abis.h>
 #include <osmo-bts/gsm_data.h>
 #include <osmo-bts/bts_trx.h>
 #include <osmo-bts/bts.h>
@@ -34,6 +35,8 @@ static int gsm_bts_trx_talloc_destructor(struct gsm_bts_trx *trx)
 {
 	unsigned int i;
 
+	abis_rsl_tx_discard(trx);
+
 	if (trx->bb_transc.mo.fi) {
 		osmo_fsm_inst_free(trx->bb_transc.mo.fi);
 		trx->bb_transc.mo.fi = NULL;
@@ -130,6 +133,7 @@ struct gsm_bts_trx *gsm_bts_trx_alloc(struct gsm_bts *bts)
 
 	trx->bts = bts;
 	trx->nr = bts->num_trx++;
+	INIT_LLIST_HEAD(&trx->rsl_tx.queue);
 
 	trx->mo.fi = osmo_fsm_inst_alloc(&nm_rcarrier_fsm, trx, trx,
 						  LOGL_INFO, NULL);
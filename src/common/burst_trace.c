@@ -0,0 +1,167 @@
+/* Binary per-burst trace ring */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#include <osmo-bts/burst_trace.h>
+
+/* Largest ring that can be configured, 24 MiB */
+#define BURST_TRACE_MAX_RECS	(1 << 20)
+
+struct burst_trace *g_burst_trace = NULL;
+
+/*! Enable, resize or disable (num_recs == 0) the burst trace.
+ *  \param[in] ctx talloc context.
+ *  \param[in] num_recs number of records, rounded up to a power of two.
+ *  \returns 0 on success, negative errno on error. */
+int burst_trace_set_size(void *ctx, unsigned int num_recs)
+{
+	struct burst_trace *bt = g_burst_trace;
+	unsigned int size = 1;
+
+	if (num_recs > BURST_TRACE_MAX_RECS)
+		return -EINVAL;
+
+	if (num_recs == 0) {
+		if (bt) {
+			g_burst_trace = NULL;
+			talloc_free(bt);
+		}
+		return 0;
+	}
+
+	while (size < num_recs)
+		size <<= 1;
+
+	if (!bt) {
+		bt = talloc_zero(ctx, struct burst_trace);
+		if (!bt)
+			return -ENOMEM;
+	} else if (bt->num_recs == size) {
+		return 0;
+	}
+
+	/* the trace is lost on resize, nobody resizes a trace of interest */
+	talloc_free(bt->recs);
+	bt->recs = talloc_zero_array(bt, struct burst_trace_rec, size);
+	if (!bt->recs) {
+		g_burst_trace = NULL;
+		talloc_free(bt);
+		return -ENOMEM;
+	}
+	bt->num_recs = size;
+	bt->head = 0;
+	g_burst_trace = bt;
+
+	return 0;
+}
+
+void burst_trace_add(struct burst_trace *bt, enum burst_trace_event event,
+		     uint8_t trx, uint32_t fn, uint8_t tn, uint8_t chan,
+		     int8_t rssi, int16_t toa256, int16_t ci_cb,
+		     uint8_t flags, uint16_t arg)
+{
+	struct burst_trace_rec *rec = &bt->recs[bt->head++ & (bt->num_recs - 1)];
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	rec->time_ns = (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+	rec->fn = fn;
+	rec->event = event;
+	rec->trx = trx;
+	rec->tn = tn;
+	rec->chan = chan;
+	rec->toa256 = toa256;
+	rec->ci_cb = ci_cb;
+	rec->rssi = rssi;
+	rec->flags = flags;
+	rec->arg = arg;
+}
+
+static bool write_all(int fd, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+
+	while (len > 0) {
+		ssize_t rc = write(fd, p, len);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0)
+			return false;
+		p += rc;
+		len -= rc;
+	}
+
+	return true;
+}
+
+/*! Write the records of a trace to a file, oldest first.
+ *  Only uses system calls, so that it can be called from a signal handler.
+ *  \returns number of records written, negative errno on error. */
+int burst_trace_dump(const struct burst_trace *bt, const char *path)
+{
+	struct burst_trace_file_hdr hdr = {
+		.magic = BURST_TRACE_MAGIC,
+		.version = BURST_TRACE_VERSION,
+		.rec_len = sizeof(struct burst_trace_rec),
+	};
+	uint32_t num, first;
+	int fd, rc;
+
+	num = OSMO_MIN(bt->head, bt->num_recs);
+	first = (bt->head - num) & (bt->num_recs - 1);
+	hdr.num_recs = num;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -errno;
+
+	/* the ring may wrap, write it in (at most) two parts */
+	errno = 0;
+	if (!write_all(fd, &hdr, sizeof(hdr))
+	    || !write_all(fd, &bt->recs[first],
+			  OSMO_MIN(num, bt->num_recs - first) * sizeof(bt->recs[0]))
+	    || !write_all(fd, &bt->recs[0],
+			  (num - OSMO_MIN(num, bt->num_recs - first)) * sizeof(bt->recs[0])))
+		rc = errno ? -errno : -EIO;
+	else
+		rc = num;
+
+	close(fd);
+	return rc;
+}
+
+/*! Dump the trace to the configured crash dump file, if any. */
+void burst_trace_dump_crash(void)
+{
+	struct burst_trace *bt = g_burst_trace;
+
+	if (bt && bt->crash_path)
+		burst_trace_dump(bt, bt->crash_path);
+}
@@ -0,0 +1,176 @@
+/* Batched GSMTAP Um export */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/gsmtap.h>
+
+#include <osmo-bts/gsmtap_batch.h>
+
+#include "btsconfig.h"
+
+/* Instead of formatting a message buffer and sending it for every frame,
+ * frames are copied into a ring of fixed size records.  The ring is sent once
+ * per TDMA frame with a single sendmmsg().  If the ring is full, frames are
+ * dropped rather than delaying the caller. */
+
+/*! Allocate a GSMTAP batch.
+ *  \param[in] ctx talloc context.
+ *  \param[in] fd connected GSMTAP socket, see gsmtap_inst_fd().
+ *  \param[in] num_recs number of frames that can be queued, power of two.
+ *  \returns the batch, NULL on error. */
+struct gsmtap_batch *gsmtap_batch_alloc(void *ctx, int fd, unsigned int num_recs)
+{
+	struct gsmtap_batch *gb;
+	unsigned int i;
+
+	if (!num_recs || (num_recs & (num_recs - 1)))
+		return NULL;
+
+	gb = talloc_zero(ctx, struct gsmtap_batch);
+	if (!gb)
+		return NULL;
+	gb->fd = fd;
+	gb->num_recs = num_recs;
+	gb->recs = talloc_zero_array(gb, struct gsmtap_batch_rec, num_recs);
+	gb->msgs = talloc_zero_array(gb, struct mmsghdr, num_recs);
+	gb->iov = talloc_zero_array(gb, struct iovec, num_recs);
+	if (!gb->recs || !gb->msgs || !gb->iov) {
+		talloc_free(gb);
+		return NULL;
+	}
+
+	/* the socket is connected, so only the payload is set per message */
+	for (i = 0; i < num_recs; i++) {
+		gb->msgs[i].msg_hdr.msg_iov = &gb->iov[i];
+		gb->msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	return gb;
+}
+
+void gsmtap_batch_free(struct gsmtap_batch *gb)
+{
+	talloc_free(gb);
+}
+
+/*! Queue a GSMTAP Um frame, same arguments as gsmtap_send().
+ *  \returns 0 on success, -ENOSPC if the frame had to be dropped. */
+int gsmtap_batch_enqueue(struct gsmtap_batch *gb, uint16_t arfcn, uint8_t ts,
+			 uint8_t chan_type, uint8_t ss, uint32_t fn,
+			 int8_t signal_dbm, int8_t snr,
+			 const uint8_t *data, unsigned int len)
+{
+	struct gsmtap_batch_rec *rec;
+
+	if (gb->head - gb->tail >= gb->num_recs || len > sizeof(rec->data))
+		return -ENOSPC;
+
+	rec = &gb->recs[gb->head & (gb->num_recs - 1)];
+	rec->hdr = (struct gsmtap_hdr) {
+		.version = GSMTAP_VERSION,
+		.hdr_len = sizeof(rec->hdr) / 4,
+		.type = GSMTAP_TYPE_UM,
+		.timeslot = ts,
+		.arfcn = htons(arfcn),
+		.signal_dbm = signal_dbm,
+		.snr_db = snr,
+		.frame_number = htonl(fn),
+		.sub_type = chan_type,
+		.sub_slot = ss,
+	};
+	memcpy(rec->data, data, len);
+	rec->len = len;
+	gb->head++;
+
+	return 0;
+}
+
+/* Send a contiguous part of the ring, returns number of frames sent */
+static int gsmtap_batch_send(struct gsmtap_batch *gb, unsigned int first, unsigned int num)
+{
+	unsigned int i;
+	int rc;
+
+	for (i = first; i < first + num; i++) {
+		struct gsmtap_batch_rec *rec = &gb->recs[i];
+
+		/* header and payload are adjacent */
+		gb->iov[i].iov_base = &rec->hdr;
+		gb->iov[i].iov_len = sizeof(rec->hdr) + rec->len;
+	}
+
+#ifdef HAVE_SENDMMSG
+	rc = sendmmsg(gb->fd, &gb->msgs[first], num, MSG_DONTWAIT);
+	if (rc < 0)
+		return -errno;
+#else
+	for (rc = 0; (unsigned int) rc < num; rc++) {
+		if (sendmsg(gb->fd, &gb->msgs[first + rc].msg_hdr, MSG_DONTWAIT) < 0) {
+			if (rc == 0)
+				return -errno;
+			break;
+		}
+	}
+#endif
+
+	return rc;
+}
+
+/*! Send all queued frames.
+ *  \returns number of frames sent, negative errno on error.  If the socket
+ *	     is busy, the frames remain queued. */
+int gsmtap_batch_flush(struct gsmtap_batch *gb)
+{
+	int sent = 0;
+
+	osmo_static_assert(offsetof(struct gsmtap_batch_rec, data) == sizeof(struct gsmtap_hdr),
+			   gsmtap_batch_rec_adjacent);
+
+	while (gb->head != gb->tail) {
+		unsigned int first = gb->tail & (gb->num_recs - 1);
+		unsigned int num = OSMO_MIN(gb->head - gb->tail, gb->num_recs - first);
+		int rc;
+
+		rc = gsmtap_batch_send(gb, first, num);
+		if (rc < 0) {
+			/* e.g. ICMP port unreachable on the connected socket,
+			 * don't let the frame block the ring forever */
+			if (rc != -EAGAIN && rc != -ENOBUFS)
+				gb->tail++;
+			return rc;
+		}
+
+		gb->tail += rc;
+		sent += rc;
+		if ((unsigned int) rc < num)
+			break;
+	}
+
+	return sent;
+}
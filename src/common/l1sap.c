@@ -57,6 +57,8 @@
 #include <osmo-bts/msg_utils.h>
 #include <osmo-bts/pcuif_proto.h>
 #include <osmo-bts/cbch.h>
+#include <osmo-bts/gsmtap_batch.h>
+#include <osmo-bts/probes.h>
 
 
 #define CB_FCCH		-1
@@ -132,6 +134,39 @@ get_active_lchan_by_chan_nr(struct gsm_bts_trx *trx, unsigned int chan_nr)
 
 static int l1sap_down(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap);
 
+/* chan_nr and fn of data/TCH/RACH primitives, for the USDT probes */
+static inline uint8_t l1sap_probe_chan_nr(const struct osmo_phsap_prim *l1sap)
+{
+	switch (l1sap->oph.primitive) {
+	case PRIM_PH_DATA:
+	case PRIM_PH_RTS:
+		return l1sap->u.data.chan_nr;
+	case PRIM_TCH:
+	case PRIM_TCH_RTS:
+		return l1sap->u.tch.chan_nr;
+	case PRIM_PH_RACH:
+		return l1sap->u.rach_ind.chan_nr;
+	default:
+		return 0;
+	}
+}
+
+static inline uint32_t l1sap_probe_fn(const struct osmo_phsap_prim *l1sap)
+{
+	switch (l1sap->oph.primitive) {
+	case PRIM_PH_DATA:
+	case PRIM_PH_RTS:
+		return l1sap->u.data.fn;
+	case PRIM_TCH:
+	case PRIM_TCH_RTS:
+		return l1sap->u.tch.fn;
+	case PRIM_PH_RACH:
+		return l1sap->u.rach_ind.fn;
+	default:
+		return 0;
+	}
+}
+
 static uint32_t fn_ms_adj(uint32_t fn, const struct gsm_lchan *lchan)
 {
 	uint32_t samples_passed, r;
@@ -491,6 +526,24 @@ static bool is_fill_frame(uint8_t chan_type, const uint8_t *data, unsigned int l
 	return false;
 }
 
+/* Number of GSMTAP frames that can be queued between two TDMA frames */
+#define GSMTAP_BATCH_NUM_RECS	256
+
+static struct gsmtap_batch *gsmtap_batch_get(struct gsm_bts *bts)
+{
+	if (!bts->gsmtap.batch) {
+		bts->gsmtap.batch = gsmtap_batch_alloc(bts, gsmtap_inst_fd(bts->gsmtap.inst),
+						       GSMTAP_BATCH_NUM_RECS);
+		if (!bts->gsmtap.batch) {
+			LOGP(DL1C, LOGL_ERROR, "Failed to set up batched GSMTAP, "
+			     "sending frames one by one\n");
+			bts->gsmtap.batched = false;
+		}
+	}
+
+	return bts->gsmtap.batch;
+}
+
 static int to_gsmtap(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 {
 	uint8_t *data;
@@ -504,6 +557,8 @@ static int to_gsmtap(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 	struct gsmtap_inst *inst = trx->bts->gsmtap.inst;
 	if (!inst)
 		return 0;
+	if (trx->bts->ovld.level >= BTS_OVLD_L_GSMTAP)
+		return 0;
 
 	switch (OSMO_PRIM_HDR(&l1sap->oph)) {
 	case OSMO_PRIM(PRIM_PH_DATA, PRIM_OP_REQUEST):
@@ -534,6 +589,8 @@ static int to_gsmtap(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 
 	if (len == 0)
 		return 0;
+	if (!(trx->bts->gsmtap.ts_mask & (1 << tn)))
+		return 0;
 	if ((chan_type & GSMTAP_CHANNEL_ACCH)) {
 		if (!trx->bts->gsmtap.sapi_acch)
 			return 0;
@@ -547,6 +604,22 @@ static int to_gsmtap(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 	if (is_fill_frame(chan_type, data, len))
 		return 0;
 
+	if (trx->bts->gsmtap.sample_rate > 1) {
+		if (++trx->bts->gsmtap.sample_cnt < trx->bts->gsmtap.sample_rate)
+			return 0;
+		trx->bts->gsmtap.sample_cnt = 0;
+	}
+
+	if (trx->bts->gsmtap.batched) {
+		struct gsmtap_batch *gb = gsmtap_batch_get(trx->bts);
+		if (gb) {
+			if (gsmtap_batch_enqueue(gb, trx->arfcn | uplink, tn, chan_type, ss, fn,
+						 signal_dbm, 0 /* TODO: SNR */, data, len) < 0)
+				rate_ctr_inc2(trx->bts->ctrs, BTS_CTR_GSMTAP_DROPPED);
+			return 0;
+		}
+	}
+
 	gsmtap_send(inst, trx->arfcn | uplink, tn, chan_type, ss, fn,
 		    signal_dbm, 0 /* TODO: SNR */, data, len);
 
@@ -632,6 +705,10 @@ static int l1sap_info_time_ind(struct gsm_bts *bts,
 	/* Update time on PCU interface */
 	pcu_tx_time_ind(info_time_ind->fn);
 
+	/* Send the GSMTAP frames queued during the last frame */
+	if (bts->gsmtap.batch)
+		gsmtap_batch_flush(bts->gsmtap.batch);
+
 	/* increment number of RACH slots that have passed by since the
 	 * last time indication */
 	for (i = 0; i < frames_expired; i++) {
@@ -1125,6 +1202,7 @@ static int l1sap_ph_rts_ind(struct gsm_bts_trx *trx,
 	struct lapdm_entity *le;
 	struct msgb *pp_msg;
 	bool dtxd_facch = false;
+	uint32_t dl_lat_ts;
 	int rc;
 	int is_ag_res;
 
@@ -1241,24 +1319,30 @@ static int l1sap_ph_rts_ind(struct gsm_bts_trx *trx,
 			} /* else the message remains empty, so TCH frames are sent */
 		} else {
 			/* The +2 is empty space where the DSP inserts the L1 hdr */
-			if (L1SAP_IS_LINK_SACCH(link_id))
+			if (L1SAP_IS_LINK_SACCH(link_id)) {
 				memcpy(p + 2, pp_msg->data + 2, GSM_MACBLOCK_LEN - 2);
-			else {
+				bts_dl_lat_rll_pop(lchan, pp_msg->data + 2, pp_msg->len - 2, true, msg);
+			} else {
 				p = msgb_put(msg, GSM_MACBLOCK_LEN);
 				memcpy(p, pp_msg->data, GSM_MACBLOCK_LEN);
 				/* check if it is a RR CIPH MODE CMD. if yes, enable RX ciphering */
 				check_for_ciph_cmd(pp_msg, lchan, chan_nr);
 				if (dtxd_facch)
 					dtx_dispatch(lchan, E_FACCH);
+				bts_dl_lat_rll_pop(lchan, pp_msg->data, pp_msg->len, false, msg);
 			}
 			msgb_free(pp_msg);
 		}
 	} else if (L1SAP_IS_CHAN_AGCH_PCH(chan_nr)) {
 		p = msgb_put(msg, GSM_MACBLOCK_LEN);
 		is_ag_res = is_ccch_for_agch(trx, fn);
-		rc = bts_ccch_copy_msg(trx->bts, p, &g_time, is_ag_res);
+		rc = bts_ccch_copy_msg(trx->bts, p, &g_time, is_ag_res, &dl_lat_ts);
 		if (rc <= 0)
 			memcpy(p, fill_frame, GSM_MACBLOCK_LEN);
+		else if (dl_lat_ts) {
+			msgb_dl_lat_ts(msg) = dl_lat_ts;
+			msgb_dl_lat_sapi(msg) = BTS_LAT_SAPI_CCCH;
+		}
 	}
 
 	DEBUGPGT(DL1P, &g_time, "Tx PH-DATA.req chan_nr=%s link_id=0x%02x\n", rsl_chan_nr_str(chan_nr), link_id);
@@ -1718,9 +1802,11 @@ static int l1sap_tch_ind(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap,
 	 * good enough. */
 	if (msg->len && tch_ind->lqual_cb >= bts->min_qual_norm) {
 		/* hand msg to RTP code for transmission */
-		if (lchan->abis_ip.rtp_socket)
+		if (lchan->abis_ip.rtp_socket) {
 			osmo_rtp_send_frame_ext(lchan->abis_ip.rtp_socket,
 				msg->data, msg->len, fn_ms_adj(fn, lchan), lchan->rtp_tx_marker);
+			bts_ul_lat_sent(bts);
+		}
 		/* if loopback is enabled, also queue received RTP data */
 		if (lchan->loopback) {
 			/* make sure the queue doesn't get too long */
@@ -1902,6 +1988,9 @@ int l1sap_up(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 	struct msgb *msg = l1sap->oph.msg;
 	int rc = 0;
 
+	BTS_PROBE5(l1sap_up, trx->nr, l1sap->oph.primitive, l1sap->oph.operation,
+		   l1sap_probe_chan_nr(l1sap), l1sap_probe_fn(l1sap));
+
 	switch (OSMO_PRIM_HDR(&l1sap->oph)) {
 	case OSMO_PRIM(PRIM_MPH_INFO, PRIM_OP_INDICATION):
 		rc = l1sap_mph_info_ind(trx, l1sap, &l1sap->u.info);
@@ -1946,6 +2035,9 @@ int l1sap_up(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 /* any L1 prim sent to bts model */
 static int l1sap_down(struct gsm_bts_trx *trx, struct osmo_phsap_prim *l1sap)
 {
+	BTS_PROBE5(l1sap_down, trx->nr, l1sap->oph.primitive, l1sap->oph.operation,
+		   l1sap_probe_chan_nr(l1sap), l1sap_probe_fn(l1sap));
+
 	l1sap_log_ctx_sapi = get_common_sapi_by_trx_prim(trx, l1sap);
 	log_set_context(LOG_CTX_L1_SAPI, &l1sap_log_ctx_sapi);
 
@@ -1977,6 +2069,8 @@ int l1sap_pdch_req(struct gsm_bts_trx_ts *ts, int is_ptcch, uint32_t fn,
 	l1sap->u.data.chan_nr = RSL_CHAN_OSMO_PDCH | ts->nr;
 	l1sap->u.data.link_id = 0x00;
 	l1sap->u.data.fn = fn;
+	/* called synchronously from pcu_rx_data_req() */
+	bts_dl_lat_stamp(msg, BTS_LAT_SAPI_PDTCH);
 	if (len) {
 		msg->l2h = msgb_put(msg, len);
 		memcpy(msg->l2h, data, len);
@@ -2014,6 +2108,8 @@ void l1sap_rtp_rx_cb(struct osmo_rtp_socket *rs, const uint8_t *rtp_pl,
 	/* Store RTP header Timestamp in control buffer */
 	rtpmsg_ts(msg) = timestamp;
 
+	bts_dl_lat_stamp(msg, BTS_LAT_SAPI_TCH);
+
 	/* make sure the queue doesn't get too long */
 	queue_limit_to(gsm_lchan_name(lchan), &lchan->dl_tch_queue, 1);
 
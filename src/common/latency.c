@@ -0,0 +1,366 @@
+/* End-to-end latency through the BTS, per SAPI */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stats.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/bts.h>
+#include <osmo-bts/latency.h>
+
+const struct value_string bts_lat_sapi_names[] = {
+	{ BTS_LAT_SAPI_CCCH,	"ccch" },
+	{ BTS_LAT_SAPI_DCCH,	"dcch" },
+	{ BTS_LAT_SAPI_SACCH,	"sacch" },
+	{ BTS_LAT_SAPI_SAPI3,	"sapi3" },
+	{ BTS_LAT_SAPI_TCH,	"tch" },
+	{ BTS_LAT_SAPI_PDTCH,	"pdtch" },
+	{ 0, NULL }
+};
+
+/* Downlink: dominated by rts-advance and clock-advance (several frames) */
+static const uint32_t bts_dl_lat_bucket_us[BTS_LAT_NUM_BUCKETS - 1] = {
+	10000, 20000, 30000, 40000, 60000, 80000, 120000,
+};
+
+static const struct rate_ctr_desc bts_dl_lat_ctr_desc[BTS_LAT_NUM_BUCKETS] = {
+	{ "lat:10ms", "Downlink latency below 10 ms" },
+	{ "lat:20ms", "Downlink latency below 20 ms" },
+	{ "lat:30ms", "Downlink latency below 30 ms" },
+	{ "lat:40ms", "Downlink latency below 40 ms" },
+	{ "lat:60ms", "Downlink latency below 60 ms" },
+	{ "lat:80ms", "Downlink latency below 80 ms" },
+	{ "lat:120ms", "Downlink latency below 120 ms" },
+	{ "lat:more", "Downlink latency of 120 ms or more" },
+};
+
+/* Uplink: processing within the main loop, no scheduling delay */
+static const uint32_t bts_ul_lat_bucket_us[BTS_LAT_NUM_BUCKETS - 1] = {
+	100, 250, 500, 1000, 2000, 5000, 10000,
+};
+
+static const struct rate_ctr_desc bts_ul_lat_ctr_desc[BTS_LAT_NUM_BUCKETS] = {
+	{ "lat:100us", "Uplink latency below 100 us" },
+	{ "lat:250us", "Uplink latency below 250 us" },
+	{ "lat:500us", "Uplink latency below 500 us" },
+	{ "lat:1ms", "Uplink latency below 1 ms" },
+	{ "lat:2ms", "Uplink latency below 2 ms" },
+	{ "lat:5ms", "Uplink latency below 5 ms" },
+	{ "lat:10ms", "Uplink latency below 10 ms" },
+	{ "lat:more", "Uplink latency of 10 ms or more" },
+};
+
+/* one group per SAPI, the group index is enum bts_lat_sapi */
+static const struct rate_ctr_group_desc bts_dl_lat_ctrg_desc = {
+	"bts_dl_lat",
+	"BTS downlink latency, arrival to first burst (ccch, dcch, sacch, sapi3, tch, pdtch)",
+	OSMO_STATS_CLASS_GLOBAL,
+	ARRAY_SIZE(bts_dl_lat_ctr_desc),
+	bts_dl_lat_ctr_desc
+};
+static const struct rate_ctr_group_desc bts_ul_dec_ctrg_desc = {
+	"bts_ul_dec",
+	"BTS uplink decode time, last burst received to block decoded (ccch, dcch, sacch, sapi3, tch, pdtch)",
+	OSMO_STATS_CLASS_GLOBAL,
+	ARRAY_SIZE(bts_ul_lat_ctr_desc),
+	bts_ul_lat_ctr_desc
+};
+static const struct rate_ctr_group_desc bts_ul_queue_ctrg_desc = {
+	"bts_ul_queue",
+	"BTS uplink queue time, block decoded to Abis/RTP/PCU (ccch, dcch, sacch, sapi3, tch, pdtch)",
+	OSMO_STATS_CLASS_GLOBAL,
+	ARRAY_SIZE(bts_ul_lat_ctr_desc),
+	bts_ul_lat_ctr_desc
+};
+
+/* Uplink block being passed up, see bts_ul_lat_decoded() */
+static struct {
+	uint32_t rx_ts_us;	/* reception of the current TRXD PDU, 0 if none */
+	uint32_t dec_ts_us;	/* decoding of the current block, 0 if none */
+	enum bts_lat_sapi sapi;
+} ul_lat;
+
+uint32_t bts_lat_now_us(void)
+{
+	struct timespec ts;
+	uint32_t now_us;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now_us = (uint32_t) ((uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+
+	/* 0 means "not stamped" */
+	return now_us ? now_us : 1;
+}
+
+static int lat_stats_init(void *ctx, struct bts_lat_stats *stats,
+			  const struct rate_ctr_group_desc *desc, const uint32_t *bucket_us)
+{
+	unsigned int i;
+
+	for (i = 0; i < _NUM_BTS_LAT_SAPI; i++) {
+		stats[i].ctrs = rate_ctr_group_alloc(ctx, desc, i);
+		if (!stats[i].ctrs)
+			return -1;
+		stats[i].bucket_us = bucket_us;
+	}
+
+	return 0;
+}
+
+int bts_lat_init(struct gsm_bts *bts)
+{
+	if (lat_stats_init(bts, bts->dl_lat, &bts_dl_lat_ctrg_desc, bts_dl_lat_bucket_us) < 0)
+		return -1;
+	if (lat_stats_init(bts, bts->ul_dec, &bts_ul_dec_ctrg_desc, bts_ul_lat_bucket_us) < 0)
+		return -1;
+	if (lat_stats_init(bts, bts->ul_queue, &bts_ul_queue_ctrg_desc, bts_ul_lat_bucket_us) < 0)
+		return -1;
+
+	return 0;
+}
+
+void bts_lat_stats_add(struct bts_lat_stats *st, uint32_t lat_us)
+{
+	unsigned int i;
+
+	for (i = 0; i < BTS_LAT_NUM_BUCKETS - 1; i++) {
+		if (lat_us < st->bucket_us[i])
+			break;
+	}
+	rate_ctr_inc(rate_ctr_group_get_ctr(st->ctrs, i));
+
+	st->samples++;
+	st->sum_us += lat_us;
+	if (lat_us > st->max_us)
+		st->max_us = lat_us;
+}
+
+/*! Stamp a Downlink message with its arrival time */
+void bts_dl_lat_stamp(struct msgb *msg, enum bts_lat_sapi sapi)
+{
+	msgb_dl_lat_ts(msg) = bts_lat_now_us();
+	msgb_dl_lat_sapi(msg) = sapi;
+}
+
+/*! Account the latency of a stamped PH-DATA.req or TCH.req message */
+void bts_dl_lat_account(struct gsm_bts *bts, const struct msgb *msg)
+{
+	uint32_t ts_us = msgb_dl_lat_ts(msg);
+
+	if (ts_us == 0)
+		return;
+	OSMO_ASSERT(msgb_dl_lat_sapi(msg) < _NUM_BTS_LAT_SAPI);
+
+	bts_lat_stats_add(&bts->dl_lat[msgb_dl_lat_sapi(msg)], bts_lat_now_us() - ts_us);
+}
+
+static struct bts_dl_lat_rll *dl_lat_rll(struct gsm_lchan *lchan, bool sacch, uint8_t sapi)
+{
+	if (sapi != 0 && sapi != 3)
+		return NULL;
+	return &lchan->dl_lat_rll[sacch][sapi == 3];
+}
+
+/*! Forget the arrival times of RLL messages, e.g. on (re)activation */
+void bts_dl_lat_rll_reset(struct gsm_lchan *lchan)
+{
+	unsigned int i, j;
+
+	memset(lchan->dl_lat_rll, 0, sizeof(lchan->dl_lat_rll));
+	for (i = 0; i < ARRAY_SIZE(lchan->dl_lat_rll); i++) {
+		for (j = 0; j < ARRAY_SIZE(lchan->dl_lat_rll[i]); j++)
+			lchan->dl_lat_rll[i][j].last_ns = -1;
+	}
+}
+
+/*! Forget the arrival times of RLL messages of one LAPDm entity and SAPI,
+ *  when its data link is (re)established or released */
+void bts_dl_lat_rll_reset_sapi(struct gsm_lchan *lchan, bool sacch, uint8_t sapi)
+{
+	struct bts_dl_lat_rll *rll = dl_lat_rll(lchan, sacch, sapi);
+
+	if (!rll)
+		return;
+	memset(rll, 0, sizeof(*rll));
+	rll->last_ns = -1;
+}
+
+/*! Remember the arrival time of an RLL DATA/UNIT DATA REQ accepted by LAPDm
+ *  \param[in] sacch whether the message is sent on the SACCH.
+ *  \param[in] sapi SAPI of the message.
+ *  \param[in] ts_us arrival time, 0 if the message was not stamped. */
+void bts_dl_lat_rll_push(struct gsm_lchan *lchan, bool sacch, uint8_t sapi, uint32_t ts_us)
+{
+	struct bts_dl_lat_rll *rll;
+
+	if (ts_us == 0)
+		return;
+
+	rll = dl_lat_rll(lchan, sacch, sapi);
+	if (!rll)
+		return;
+
+	/* FIFO full: drop the oldest entry */
+	if (rll->len == BTS_DL_LAT_RLL_DEPTH) {
+		rll->head = (rll->head + 1) % BTS_DL_LAT_RLL_DEPTH;
+		rll->len--;
+	}
+
+	rll->ts_us[(rll->head + rll->len) % BTS_DL_LAT_RLL_DEPTH] = ts_us;
+	rll->len++;
+}
+
+/*! Stamp a PH-DATA.req with the arrival time of the RLL message whose
+ *  transmission is completed by the given LAPDm frame (if any).
+ *  \param[in] frame LAPDm frame (without the L1 header on SACCH).
+ *  \param[in] sacch whether the frame is sent on the SACCH.
+ *  \param[out] msg the PH-DATA.req carrying the frame. */
+void bts_dl_lat_rll_pop(struct gsm_lchan *lchan, const uint8_t *frame, unsigned int len,
+			bool sacch, struct msgb *msg)
+{
+	struct bts_dl_lat_rll *rll;
+	uint8_t sapi, ns;
+
+	/* address, control and length octets */
+	if (len < 3)
+		return;
+
+	sapi = (frame[0] >> 2) & 0x07;
+	rll = dl_lat_rll(lchan, sacch, sapi);
+	if (!rll)
+		return;
+
+	if ((frame[1] & 0x01) == 0) {
+		/* I frame: with a window size of 1, a retransmission repeats
+		 * the N(S) of the previous I frame.  A message is sent when
+		 * its last segment (M bit cleared) is sent for the first time. */
+		ns = (frame[1] >> 1) & 0x07;
+		if (ns == rll->last_ns)
+			return;
+		rll->last_ns = ns;
+		if (frame[2] & 0x02)
+			return;
+	} else if ((frame[1] & 0xef) != 0x03) {
+		/* neither I nor UI frame */
+		return;
+	} else if ((frame[2] >> 2) == 0) {
+		/* UI frame without information, e.g. a fill frame */
+		return;
+	}
+
+	if (rll->len == 0)
+		return;
+
+	msgb_dl_lat_ts(msg) = rll->ts_us[rll->head];
+	if (sapi == 3)
+		msgb_dl_lat_sapi(msg) = BTS_LAT_SAPI_SAPI3;
+	else
+		msgb_dl_lat_sapi(msg) = sacch ? BTS_LAT_SAPI_SACCH : BTS_LAT_SAPI_DCCH;
+
+	rll->head = (rll->head + 1) % BTS_DL_LAT_RLL_DEPTH;
+	rll->len--;
+}
+
+/*! Note the reception time of the TRXD PDU being processed, 0 when done */
+void bts_ul_lat_set_rx(uint32_t rx_ts_us)
+{
+	ul_lat.rx_ts_us = rx_ts_us;
+}
+
+/*! Account the decode time of an Uplink block, which becomes the current
+ *  Uplink context until bts_ul_lat_done() */
+void bts_ul_lat_decoded(struct gsm_bts *bts, enum bts_lat_sapi sapi)
+{
+	uint32_t now_us;
+
+	if (ul_lat.rx_ts_us == 0)
+		return;
+
+	now_us = bts_lat_now_us();
+	bts_lat_stats_add(&bts->ul_dec[sapi], now_us - ul_lat.rx_ts_us);
+	ul_lat.dec_ts_us = now_us;
+	ul_lat.sapi = sapi;
+}
+
+void bts_ul_lat_done(void)
+{
+	ul_lat.dec_ts_us = 0;
+}
+
+/*! Account the queue time of the current Uplink block (if any), to be
+ *  called when its result (RTP frame, PCU DATA.ind) leaves the BTS */
+void bts_ul_lat_sent(struct gsm_bts *bts)
+{
+	if (ul_lat.dec_ts_us == 0)
+		return;
+
+	bts_lat_stats_add(&bts->ul_queue[ul_lat.sapi], bts_lat_now_us() - ul_lat.dec_ts_us);
+}
+
+/*! Stamp an RSL message to the BSC with the decode time of the current
+ *  Uplink block, if it is a DATA/UNIT DATA IND or MEAS RES */
+void bts_ul_lat_rsl_stamp(struct msgb *msg)
+{
+	const struct abis_rsl_common_hdr *rh = (const struct abis_rsl_common_hdr *) msg->data;
+
+	/* the msgb may have been reused from a stamped Downlink message */
+	msgb_ul_lat_ts(msg) = 0;
+
+	if (ul_lat.dec_ts_us == 0)
+		return;
+	if (msgb_length(msg) < sizeof(*rh))
+		return;
+
+	switch (rh->msg_discr & 0xfe) {
+	case ABIS_RSL_MDISC_RLL:
+		if (rh->msg_type != RSL_MT_DATA_IND && rh->msg_type != RSL_MT_UNIT_DATA_IND)
+			return;
+		break;
+	case ABIS_RSL_MDISC_DED_CHAN:
+		if (rh->msg_type != RSL_MT_MEAS_RES)
+			return;
+		break;
+	default:
+		return;
+	}
+
+	msgb_ul_lat_ts(msg) = ul_lat.dec_ts_us;
+	msgb_ul_lat_sapi(msg) = ul_lat.sapi;
+}
+
+/*! Account the queue time of a stamped RSL message, to be called when it
+ *  is handed to libosmo-abis */
+void bts_ul_lat_rsl_sent(struct gsm_bts *bts, const struct msgb *msg)
+{
+	uint32_t ts_us = msgb_ul_lat_ts(msg);
+
+	if (ts_us == 0)
+		return;
+	OSMO_ASSERT(msgb_ul_lat_sapi(msg) < _NUM_BTS_LAT_SAPI);
+
+	bts_lat_stats_add(&bts->ul_queue[msgb_ul_lat_sapi(msg)], bts_lat_now_us() - ts_us);
+}
@@ -24,6 +24,7 @@
 #include <osmo-bts/gsm_data.h>
 #include <osmo-bts/bts.h>
 #include <osmo-bts/rsl.h>
+#include <osmo-bts/overload.h>
 
 void early_rr_ia_delay_cb(void *data)
 {
@@ -60,6 +61,14 @@ void lchan_set_state(struct gsm_lchan *lchan, enum gsm_lchan_state state)
 	       gsm_lchans_name(state));
 	lchan->state = state;
 
+	if (state == LCHAN_S_NONE) {
+		/* the shared SACCH SI buffers are set up again on activation */
+		lchan_sacch_si_release(lchan);
+		/* MEAS RES deferred under overload must not reach the BSC after
+		 * the release, nor be taken for those of the next activation */
+		bts_ovld_meas_res_purge(lchan);
+	}
+
 	/* Early Immediate Assignment: if we have a cached early IA pending, send it upon becoming active, or discard it
 	 * when releasing. */
 	if (lchan->early_rr_ia) {
@@ -54,6 +54,7 @@
 #include <osmo-bts/bts_model.h>
 #include <osmo-bts/pcu_if.h>
 #include <osmo-bts/control_if.h>
+#include <osmo-bts/burst_trace.h>
 #include <osmocom/ctrl/control_if.h>
 #include <osmocom/ctrl/ports.h>
 #include <osmocom/ctrl/control_vty.h>
@@ -244,6 +245,7 @@ static void signal_handler(int signum)
 		 * return, but program wouldn't exit if an external SIGABRT is
 		 * received.
 		 */
+		burst_trace_dump_crash();
 		talloc_report_full(tall_bts_ctx, stderr);
 		signal(SIGABRT, SIG_DFL);
 		raise(SIGABRT);
@@ -310,6 +310,33 @@ static uint8_t modulus_by_lchan(struct gsm_lchan *lchan)
 	}
 }
 
+/* add a measurement to the running sums of a measurement period */
+static void ul_meas_sum_add(struct bts_ul_meas_sum *sum, const struct bts_ul_meas *m, bool first)
+{
+	if (first) {
+		sum->toa256_min = m->ta_offs_256bits;
+		sum->toa256_max = m->ta_offs_256bits;
+	} else {
+		if (m->ta_offs_256bits < sum->toa256_min)
+			sum->toa256_min = m->ta_offs_256bits;
+		if (m->ta_offs_256bits > sum->toa256_max)
+			sum->toa256_max = m->ta_offs_256bits;
+	}
+
+	sum->ber10k_full += m->ber10k;
+	sum->inv_rssi_full += m->inv_rssi;
+	sum->ci_full += m->c_i;
+	sum->toa256 += m->ta_offs_256bits;
+	sum->toa256_sq += (int32_t)m->ta_offs_256bits * m->ta_offs_256bits;
+
+	if (m->is_sub) {
+		sum->ber10k_sub += m->ber10k;
+		sum->inv_rssi_sub += m->inv_rssi;
+		sum->ci_sub += m->c_i;
+		sum->num_sub++;
+	}
+}
+
 /* receive a L1 uplink measurement from L1 (this function is only used
  * internally, it is public to call it from unit-tests)  */
 int lchan_new_ul_meas(struct gsm_lchan *lchan,
@@ -326,14 +353,14 @@ int lchan_new_ul_meas(struct gsm_lchan *lchan,
 		       lchan->meas.num_ul_meas, fn_mod);
 	}
 
-	if (lchan->meas.num_ul_meas >= ARRAY_SIZE(lchan->meas.uplink)) {
+	if (lchan->meas.num_ul_meas >= MAX_NUM_UL_MEAS) {
 		LOGPFN(DMEAS, LOGL_NOTICE, fn,
 		       "%s no space for uplink measurement, num_ul_meas=%d, fn_mod=%u\n",
 		       gsm_lchan_name(lchan), lchan->meas.num_ul_meas, fn_mod);
 		return -ENOSPC;
 	}
 
-	dest = &lchan->meas.uplink[lchan->meas.num_ul_meas++];
+	dest = &lchan->meas.uplink_last[lchan->meas.num_ul_meas % MAX_NUM_UL_MEAS_LAST];
 	memcpy(dest, ulm, sizeof(*ulm));
 
 	/* We expect the lower layers to mark AMR SID_UPDATE frames already as such.
@@ -341,6 +368,9 @@ int lchan_new_ul_meas(struct gsm_lchan *lchan,
 	if (!ulm->is_sub)
 		dest->is_sub = ts45008_83_is_sub(lchan, fn);
 
+	ul_meas_sum_add(&lchan->meas.ul_sum, dest, lchan->meas.num_ul_meas == 0);
+	lchan->meas.num_ul_meas++;
+
 	DEBUGPFN(DMEAS, fn, "%s adding measurement (ber10k=%u, ta_offs=%d, ci_cB=%d, is_sub=%u, rssi=-%u), num_ul_meas=%d, fn_mod=%u\n",
 		 gsm_lchan_name(lchan), ulm->ber10k, ulm->ta_offs_256bits,
 		 ulm->c_i, dest->is_sub, ulm->inv_rssi, lchan->meas.num_ul_meas,
@@ -471,20 +501,15 @@ static unsigned int lchan_meas_sub_num_expected(const struct gsm_lchan *lchan)
  *     of fractional fixed-point number.
  */
 
-/* compute Osmocom extended measurements for the given lchan */
-static void lchan_meas_compute_extended(struct gsm_lchan *lchan)
+/* compute Osmocom extended measurements for the given lchan from the sums
+ * over the num_ul_meas measurements of the period */
+static void lchan_meas_compute_extended(struct gsm_lchan *lchan, const struct bts_ul_meas_sum *sum,
+					unsigned int num_ul_meas)
 {
-	unsigned int num_ul_meas;
-	unsigned int num_ul_meas_excess = 0;
-        unsigned int num_ul_meas_expect;
-
 	/* we assume that lchan_meas_check_compute() has already computed the mean value
-	 * and we can compute the min/max/variance/stddev from this */
-	int i;
-
-	/* each measurement is an int32_t, so the squared difference value must fit in 32bits */
-	/* the sum of the squared values (each up to 32bit) can very easily exceed 32 bits */
-	uint64_t sq_diff_sum = 0;
+	 * and we can compute the variance/stddev from this */
+	int64_t mean = lchan->meas.ms_toa256;
+	uint64_t sq_diff_sum;
 
 	/* In case we do not have any measurement values collected there is no
 	 * computation possible. We just skip the whole computation here, the
@@ -496,50 +521,23 @@ static void lchan_meas_compute_extended(struct gsm_lchan *lchan)
 	if (!lchan->meas.num_ul_meas)
 		return;
 
-	/* initialize min/max values with their counterpart */
-	lchan->meas.ext.toa256_min = INT16_MAX;
-	lchan->meas.ext.toa256_max = INT16_MIN;
-
-	/* Determine the number of measurement values we need to take into the
-	 * computation. In this case we only compute over the measurements we
-	 * have indeed received. Since this computation is about timing
-	 * information it does not make sense to approach missing measurement
-	 * samples the TOA with 0. This would bend the average towards 0. What
-	 * counts is the average TOA of the properly received blocks so that
-	 * the TA logic can make a proper decision. */
-        num_ul_meas_expect = lchan_meas_num_expected(lchan);
-	if (lchan->meas.num_ul_meas > num_ul_meas_expect) {
-		num_ul_meas = num_ul_meas_expect;
-		num_ul_meas_excess = lchan->meas.num_ul_meas - num_ul_meas_expect;
-	}
-	else
-		num_ul_meas = lchan->meas.num_ul_meas;
+	/* The sums only include the measurements we have indeed received.
+	 * Since this computation is about timing information it does not
+	 * make sense to approach missing measurement samples the TOA with 0.
+	 * This would bend the average towards 0. What counts is the average
+	 * TOA of the properly received blocks so that the TA logic can make a
+	 * proper decision. */
+	lchan->meas.ext.toa256_min = sum->toa256_min;
+	lchan->meas.ext.toa256_max = sum->toa256_max;
 
 	/* all computations are done on the relative arrival time of the burst, relative to the
 	 * beginning of its slot. This is of course excluding the TA value that the MS has already
 	 * compensated/pre-empted its transmission */
 
-	/* step 1: compute the sum of the squared difference of each value to mean */
-	for (i = 0; i < num_ul_meas; i++) {
-		const struct bts_ul_meas *m;
-
-		OSMO_ASSERT(i < lchan->meas.num_ul_meas);
-		m = &lchan->meas.uplink[i+num_ul_meas_excess];
-
-		int32_t diff = (int32_t)m->ta_offs_256bits - (int32_t)lchan->meas.ms_toa256;
-		/* diff can now be any value of +65535 to -65535, so we can safely square it,
-		 * but only in unsigned math.  As squaring looses the sign, we can simply drop
-		 * it before squaring, too. */
-		uint32_t diff_abs = labs(diff);
-		uint32_t diff_squared = diff_abs * diff_abs;
-		sq_diff_sum += diff_squared;
-
-		/* also use this loop iteration to compute min/max values */
-		if (m->ta_offs_256bits > lchan->meas.ext.toa256_max)
-			lchan->meas.ext.toa256_max = m->ta_offs_256bits;
-		if (m->ta_offs_256bits < lchan->meas.ext.toa256_min)
-			lchan->meas.ext.toa256_min = m->ta_offs_256bits;
-	}
+	/* step 1: compute the sum of the squared difference of each value to mean,
+	 * sum((x - mean)^2) = sum(x^2) - 2 * mean * sum(x) + n * mean^2, which is
+	 * exact in integer arithmetic */
+	sq_diff_sum = sum->toa256_sq - 2 * mean * sum->toa256 + (int64_t)num_ul_meas * mean * mean;
 	/* step 2: compute the variance (mean of sum of squared differences) */
 	sq_diff_sum = sq_diff_sum / num_ul_meas;
 	/* as the individual summed values can each not exceed 2^32, and we're
@@ -553,23 +551,25 @@ static void lchan_meas_compute_extended(struct gsm_lchan *lchan)
 int lchan_meas_check_compute(struct gsm_lchan *lchan, uint32_t fn)
 {
 	struct gsm_meas_rep_unidir *mru;
-	uint32_t ber_full_sum = 0;
-	uint32_t irssi_full_sum = 0;
-	int32_t ci_full_sum = 0;
-	uint32_t ber_sub_sum = 0;
-	uint32_t irssi_sub_sum = 0;
-	int32_t ci_sub_sum = 0;
-	int32_t ta256b_sum = 0;
-	unsigned int num_meas_sub = 0;
-	unsigned int num_meas_sub_actual = 0;
+	struct bts_ul_meas_sum excess_sum;
+	const struct bts_ul_meas_sum *sum = &lchan->meas.ul_sum;
+	uint32_t ber_full_sum;
+	uint32_t irssi_full_sum;
+	int32_t ci_full_sum;
+	uint32_t ber_sub_sum;
+	uint32_t irssi_sub_sum;
+	int32_t ci_sub_sum;
+	int32_t ta256b_sum;
+	unsigned int num_meas_sub;
+	unsigned int num_meas_sub_actual;
 	unsigned int num_meas_sub_subst = 0;
 	unsigned int num_meas_sub_expect;
 	unsigned int num_ul_meas;
-	unsigned int num_ul_meas_actual = 0;
-	unsigned int num_ul_meas_subst = 0;
+	unsigned int num_ul_meas_actual;
+	unsigned int num_ul_meas_subst;
 	unsigned int num_ul_meas_expect;
 	unsigned int num_ul_meas_excess = 0;
-	int i;
+	unsigned int i;
 
 	/* if measurement period is not complete, abort */
 	if (!is_meas_complete(lchan, fn))
@@ -604,61 +604,50 @@ int lchan_meas_check_compute(struct gsm_lchan *lchan, uint32_t fn)
 		LOGPLCHAN(lchan, DMEAS, LOGL_DEBUG, "Received %u excess UL measurements\n",
 			  num_ul_meas_excess);
 
-	/* Measurement computation step 1: add up */
-	for (i = 0; i < num_ul_meas; i++) {
-		const struct bts_ul_meas *m;
-		bool is_sub = false;
-
-		/* Note: We will always compute over a full measurement,
-		 * interval even when not enough measurement samples are in
-		 * the buffer. As soon as we run out of measurement values
-		 * we continue the calculation using dummy values. This works
-		 * well for the BER, since there we can safely assume 100%
-		 * since a missing measurement means that the data (block)
-		 * is lost as well (some phys do not give us measurement
-		 * reports for lost blocks or blocks that are spaced out for
-		 * DTX). However, for RSSI and TA this does not work since
-		 * there we would distort the calculation if we would replace
-		 * them with a made up number. This means for those values we
-		 * only compute over the data we have actually received. */
-
-		if (i < lchan->meas.num_ul_meas) {
-			m = &lchan->meas.uplink[i + num_ul_meas_excess];
-			if (m->is_sub) {
-				irssi_sub_sum += m->inv_rssi;
-				ci_sub_sum += m->c_i;
-				num_meas_sub_actual++;
-				is_sub = true;
-			}
-			irssi_full_sum += m->inv_rssi;
-			ta256b_sum += m->ta_offs_256bits;
-			ci_full_sum += m->c_i;
-
-			num_ul_meas_actual++;
-		} else {
-			m = &measurement_dummy;
-
-			/* For AMR the amount of SUB frames is defined by the
-			 * the occurrence of DTX periods, which are dynamically
-			 * negotiated in AMR, so we can not know if and how many
-			 * SUB frames are missing. */
-			if (lchan->tch_mode != GSM48_CMODE_SPEECH_AMR) {
-				if (num_meas_sub <= i) {
-					num_meas_sub_subst++;
-					is_sub = true;
-				}
-			}
-
-			num_ul_meas_subst++;
-		}
-
-		ber_full_sum += m->ber10k;
-		if (is_sub) {
-			num_meas_sub++;
-			ber_sub_sum += m->ber10k;
+	/* Only the most recent measurements are taken into account if we
+	 * received more than expected, sum them up again */
+	if (num_ul_meas_excess) {
+		OSMO_ASSERT(num_ul_meas_expect <= MAX_NUM_UL_MEAS_LAST);
+		memset(&excess_sum, 0, sizeof(excess_sum));
+		for (i = num_ul_meas_excess; i < lchan->meas.num_ul_meas; i++) {
+			ul_meas_sum_add(&excess_sum, &lchan->meas.uplink_last[i % MAX_NUM_UL_MEAS_LAST],
+					i == num_ul_meas_excess);
 		}
+		sum = &excess_sum;
 	}
 
+	/* Measurement computation step 1: add up
+	 *
+	 * Note: We will always compute over a full measurement interval,
+	 * even when not enough measurement samples were received. The
+	 * missing measurements are replaced with dummy values. This works
+	 * well for the BER, since there we can safely assume 100% since a
+	 * missing measurement means that the data (block) is lost as well
+	 * (some phys do not give us measurement reports for lost blocks or
+	 * blocks that are spaced out for DTX). However, for RSSI and TA this
+	 * does not work since there we would distort the calculation if we
+	 * would replace them with a made up number. This means for those
+	 * values we only compute over the data we have actually received. */
+	num_ul_meas_actual = lchan->meas.num_ul_meas - num_ul_meas_excess;
+	num_ul_meas_subst = num_ul_meas - num_ul_meas_actual;
+	num_meas_sub_actual = sum->num_sub;
+
+	/* For AMR the amount of SUB frames is defined by the the occurrence
+	 * of DTX periods, which are dynamically negotiated in AMR, so we can
+	 * not know if and how many SUB frames are missing. Otherwise all the
+	 * missing measurements are counted as SUB measurements. */
+	if (lchan->tch_mode != GSM48_CMODE_SPEECH_AMR)
+		num_meas_sub_subst = num_ul_meas_subst;
+	num_meas_sub = num_meas_sub_actual + num_meas_sub_subst;
+
+	ber_full_sum = sum->ber10k_full + num_ul_meas_subst * measurement_dummy.ber10k;
+	ber_sub_sum = sum->ber10k_sub + num_meas_sub_subst * measurement_dummy.ber10k;
+	irssi_full_sum = sum->inv_rssi_full;
+	irssi_sub_sum = sum->inv_rssi_sub;
+	ci_full_sum = sum->ci_full;
+	ci_sub_sum = sum->ci_sub;
+	ta256b_sum = sum->toa256;
+
 	if (lchan->tch_mode != GSM48_CMODE_SPEECH_AMR) {
 		LOGPLCHAN(lchan, DMEAS, LOGL_DEBUG,
 			  "Received UL measurements contain %u SUB measurements, expected %u\n",
@@ -747,9 +736,10 @@ int lchan_meas_check_compute(struct gsm_lchan *lchan, uint32_t fn)
 
 	lchan->meas.flags |= LC_UL_M_F_RES_VALID;
 
-	lchan_meas_compute_extended(lchan);
+	lchan_meas_compute_extended(lchan, sum, num_ul_meas_actual);
 
 	lchan->meas.num_ul_meas = 0;
+	memset(&lchan->meas.ul_sum, 0, sizeof(lchan->meas.ul_sum));
 
 	/* return 1 to indicate that the computation has been done and the next
 	 * interval begins. */
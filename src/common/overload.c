@@ -0,0 +1,270 @@
+/* Shedding of non-essential work when the main loop falls behind */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <limits.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/gsm0502.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/bts.h>
+#include <osmo-bts/abis.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/overload.h>
+
+/* consecutive frames above the high threshold before raising the level */
+#define OVLD_RAISE_FN		26
+/* consecutive frames below the low threshold before lowering the level */
+#define OVLD_LOWER_FN		217
+/* weight of a new sample in the moving average: 1/OVLD_AVG_WEIGHT */
+#define OVLD_AVG_WEIGHT		16
+
+/* deferred MEAS RES sent per frame, and the maximum number queued */
+#define OVLD_MEAS_RES_PER_FN	4
+#define OVLD_MEAS_RES_QUEUE_MAX	256
+
+const struct value_string bts_ovld_level_names[] = {
+	{ BTS_OVLD_L_NONE,	"none" },
+	{ BTS_OVLD_L_GSMTAP,	"gsmtap" },
+	{ BTS_OVLD_L_LOGGING,	"logging" },
+	{ BTS_OVLD_L_INTERF,	"interference" },
+	{ BTS_OVLD_L_MEAS_RES,	"meas-res" },
+	{ 0, NULL }
+};
+
+/* target wide log level while the logging is shed */
+#define OVLD_LOGL		LOGL_NOTICE
+
+/* Log levels of the log targets whose level was raised when the logging
+ * was shed.  Logging is process wide, not per BTS. */
+static struct {
+	struct ovld_log_tgt {
+		const struct log_target *tgt;
+		enum log_target_type type;
+		uint8_t loglevel;
+	} *tgts;
+	unsigned int num_tgts;
+} ovld_log;
+
+static void ovld_log_shed(void)
+{
+	struct log_target *tgt;
+	unsigned int num = 0;
+
+	llist_for_each_entry(tgt, &osmo_log_target_list, entry)
+		num++;
+
+	ovld_log.tgts = talloc_zero_array(tall_bts_ctx, struct ovld_log_tgt, num);
+	if (!ovld_log.tgts)
+		return;
+
+	llist_for_each_entry(tgt, &osmo_log_target_list, entry) {
+		/* the target wide level overrides the per category levels */
+		if (tgt->loglevel >= OVLD_LOGL)
+			continue;
+		ovld_log.tgts[ovld_log.num_tgts].tgt = tgt;
+		ovld_log.tgts[ovld_log.num_tgts].type = tgt->type;
+		ovld_log.tgts[ovld_log.num_tgts].loglevel = tgt->loglevel;
+		ovld_log.num_tgts++;
+		log_set_log_level(tgt, OVLD_LOGL);
+	}
+}
+
+static void ovld_log_restore(void)
+{
+	struct log_target *tgt;
+	unsigned int i;
+
+	if (!ovld_log.tgts)
+		return;
+
+	/* Targets may have been removed meanwhile (VTY sessions) and a new one
+	 * allocated at the same address, or the level of a target may have
+	 * been changed on the VTY.  Only a target which still has the level
+	 * set by ovld_log_shed() gets its old level back. */
+	llist_for_each_entry(tgt, &osmo_log_target_list, entry) {
+		for (i = 0; i < ovld_log.num_tgts; i++) {
+			if (ovld_log.tgts[i].tgt != tgt || ovld_log.tgts[i].type != tgt->type)
+				continue;
+			if (tgt->loglevel == OVLD_LOGL)
+				log_set_log_level(tgt, ovld_log.tgts[i].loglevel);
+			break;
+		}
+	}
+
+	TALLOC_FREE(ovld_log.tgts);
+	ovld_log.num_tgts = 0;
+}
+
+static void ovld_meas_res_flush(struct gsm_bts *bts, unsigned int max)
+{
+	struct msgb *msg;
+
+	while (max-- > 0 && !llist_empty(&bts->ovld.meas_res_queue)) {
+		msg = llist_first_entry(&bts->ovld.meas_res_queue, struct msgb, list);
+		llist_del(&msg->list);
+		bts->ovld.meas_res_queue_len--;
+		abis_bts_rsl_sendmsg(msg);
+	}
+}
+
+static void ovld_log_level(const struct gsm_bts *bts, enum bts_ovld_level old,
+			   enum bts_ovld_level level)
+{
+	LOGP(DL1C, LOGL_NOTICE, "Overload: average frame processing time %u us, "
+	     "shedding level %s -> %s\n", bts->ovld.avg_us,
+	     get_value_string(bts_ovld_level_names, old),
+	     get_value_string(bts_ovld_level_names, level));
+}
+
+static void ovld_set_level(struct gsm_bts *bts, enum bts_ovld_level level)
+{
+	enum bts_ovld_level old = bts->ovld.level;
+
+	if (level == old)
+		return;
+
+	/* log while the logging is still (or again) enabled */
+	if (level > old)
+		ovld_log_level(bts, old, level);
+
+	if (old < BTS_OVLD_L_LOGGING && level >= BTS_OVLD_L_LOGGING)
+		ovld_log_shed();
+	else if (old >= BTS_OVLD_L_LOGGING && level < BTS_OVLD_L_LOGGING)
+		ovld_log_restore();
+
+	bts->ovld.level = level;
+
+	if (level < old)
+		ovld_log_level(bts, old, level);
+}
+
+void bts_ovld_init(struct gsm_bts *bts)
+{
+	bts->ovld.high_pct = 75;
+	bts->ovld.low_pct = 40;
+	INIT_LLIST_HEAD(&bts->ovld.meas_res_queue);
+}
+
+/*! Return to normal operation, e.g. when the controller is disabled or the
+ *  PHY stops feeding it */
+void bts_ovld_reset(struct gsm_bts *bts)
+{
+	ovld_set_level(bts, BTS_OVLD_L_NONE);
+	ovld_meas_res_flush(bts, UINT_MAX);
+	bts->ovld.avg_us = 0;
+	bts->ovld.hot_fn = 0;
+	bts->ovld.calm_fn = 0;
+}
+
+/*! Feed the controller with the processing time of one frame clock tick.
+ *  \param[in] bts BTS whose frames were scheduled
+ *  \param[in] proc_us time from the nominal frame start until done (us)
+ *  \param[in] missed_fn number of frame clock ticks which were missed */
+void bts_ovld_fn(struct gsm_bts *bts, uint32_t proc_us, unsigned int missed_fn)
+{
+	struct bts_ovld *ovld = &bts->ovld;
+	uint32_t high_us = GSM_TDMA_FN_DURATION_uS * ovld->high_pct / 100;
+	uint32_t low_us = GSM_TDMA_FN_DURATION_uS * ovld->low_pct / 100;
+
+	if (!ovld->enabled)
+		return;
+
+	/* a missed tick counts as a whole frame of processing time */
+	if (missed_fn > 0)
+		proc_us = GSM_TDMA_FN_DURATION_uS * (missed_fn + 1);
+	ovld->avg_us = (ovld->avg_us * (OVLD_AVG_WEIGHT - 1) + proc_us) / OVLD_AVG_WEIGHT;
+
+	if (missed_fn > 0 || ovld->avg_us > high_us) {
+		ovld->calm_fn = 0;
+		/* a missed tick escalates at once */
+		if ((missed_fn > 0 || ++ovld->hot_fn >= OVLD_RAISE_FN) &&
+		    ovld->level < _NUM_BTS_OVLD_L - 1) {
+			ovld_set_level(bts, ovld->level + 1);
+			ovld->hot_fn = 0;
+		}
+	} else if (ovld->avg_us < low_us) {
+		ovld->hot_fn = 0;
+		if (++ovld->calm_fn >= OVLD_LOWER_FN && ovld->level > BTS_OVLD_L_NONE) {
+			ovld_set_level(bts, ovld->level - 1);
+			ovld->calm_fn = 0;
+		}
+	} else {
+		ovld->hot_fn = 0;
+		ovld->calm_fn = 0;
+	}
+
+	if (ovld->level > BTS_OVLD_L_NONE)
+		rate_ctr_inc2(bts->ctrs, BTS_CTR_OVLD_GSMTAP + ovld->level - 1);
+
+	if (ovld->level >= BTS_OVLD_L_MEAS_RES)
+		ovld_meas_res_flush(bts, OVLD_MEAS_RES_PER_FN);
+	else
+		ovld_meas_res_flush(bts, UINT_MAX);
+}
+
+/*! Queue a MEAS RES instead of sending it right away, takes ownership of msg */
+int bts_ovld_meas_res_defer(struct gsm_bts *bts, struct msgb *msg)
+{
+	struct msgb *old;
+
+	if (bts->ovld.meas_res_queue_len >= OVLD_MEAS_RES_QUEUE_MAX) {
+		old = llist_first_entry(&bts->ovld.meas_res_queue, struct msgb, list);
+		llist_del(&old->list);
+		bts->ovld.meas_res_queue_len--;
+		msgb_free(old);
+		rate_ctr_inc2(bts->ctrs, BTS_CTR_OVLD_MEAS_RES_DROP);
+	}
+
+	msgb_enqueue(&bts->ovld.meas_res_queue, msg);
+	bts->ovld.meas_res_queue_len++;
+
+	return 0;
+}
+
+/*! Drop the queued MEAS RES of an lchan, e.g. when it is deactivated */
+void bts_ovld_meas_res_purge(struct gsm_lchan *lchan)
+{
+	struct gsm_bts_trx *trx = lchan->ts->trx;
+	struct gsm_bts *bts = trx->bts;
+	const struct abis_rsl_dchan_hdr *dch;
+	struct msgb *msg, *msg2;
+	uint8_t chan_nr;
+
+	if (llist_empty(&bts->ovld.meas_res_queue))
+		return;
+
+	chan_nr = gsm_lchan2chan_nr(lchan);
+	llist_for_each_entry_safe(msg, msg2, &bts->ovld.meas_res_queue, list) {
+		dch = (const struct abis_rsl_dchan_hdr *) msg->data;
+		if (msg->trx != trx || dch->chan_nr != chan_nr)
+			continue;
+		llist_del(&msg->list);
+		bts->ovld.meas_res_queue_len--;
+		msgb_free(msg);
+	}
+}
@@ -28,7 +28,6 @@
 #include <stdint.h>
 #include <errno.h>
 #include <string.h>
-#include <time.h>
 
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/linuxlist.h>
@@ -43,10 +42,27 @@
 #include <osmo-bts/paging.h>
 #include <osmo-bts/signal.h>
 #include <osmo-bts/pcu_if.h>
+#include <osmo-bts/probes.h>
 
 #define MAX_PAGING_BLOCKS_CCCH	9
 #define MAX_BS_PA_MFRMS		9
 
+/* Paging records are expired by a hierarchical timing wheel which is driven
+ * by the TDMA frame number of the PCH blocks.  One tick of the wheel is one
+ * 51-multiframe (~235 ms), level 0 covers 64 ticks (~15 s) and level 1
+ * covers 64 level 0 revolutions (~16 min). */
+#define PAGING_WHEEL_TICK_FN	51
+#define PAGING_WHEEL_BITS	6
+#define PAGING_WHEEL_SLOTS	(1 << PAGING_WHEEL_BITS)
+#define PAGING_WHEEL_MASK	(PAGING_WHEEL_SLOTS - 1)
+
+/* maximum number of records of a paging group considered for one PCH block */
+#define PAGING_PACK_WINDOW	8
+
+/* maximum number of consecutive PCH blocks of a paging group given to the
+ * AGCH while it holds repeated paging records ('pch-preempt') */
+#define PAGING_MAX_YIELD	2
+
 enum paging_record_type {
 	PAGING_RECORD_PAGING,
 	PAGING_RECORD_IMM_ASS
@@ -57,7 +73,13 @@ struct paging_record {
 	enum paging_record_type type;
 	union {
 		struct {
-			time_t expiration_time;
+			/* entry in the expiry timing wheel (empty if not scheduled) */
+			struct llist_head wheel_list;
+			uint32_t expiration_tick;
+			/* lifetime is over, free as soon as it was sent once */
+			bool expired;
+			/* has been sent on the PCH at least once */
+			bool sent;
 			uint8_t chan_needed;
 			uint8_t identity_lv[9];
 		} paging;
@@ -80,6 +102,20 @@ struct paging_state {
 	/* total number of currently active paging records in queue */
 	unsigned int num_paging;
 	struct llist_head paging_queue[MAX_PAGING_BLOCKS_CCCH*MAX_BS_PA_MFRMS];
+	/* per paging group: number of records which are not repetitions,
+	 * i.e. IMM.ASS and paging records which have not been sent yet */
+	uint16_t num_fresh[MAX_PAGING_BLOCKS_CCCH*MAX_BS_PA_MFRMS];
+	/* per paging group: consecutive PCH blocks given to the AGCH */
+	uint8_t num_yield[MAX_PAGING_BLOCKS_CCCH*MAX_BS_PA_MFRMS];
+
+	/* timing wheel for the expiration of paging records */
+	struct {
+		uint32_t now;		/* current tick */
+		uint32_t last_fn;	/* last frame number seen */
+		bool last_fn_valid;
+		unsigned int fn_rem;	/* frames not yet accounted in 'now' */
+		struct llist_head level[2][PAGING_WHEEL_SLOTS];
+	} wheel;
 
 	/* prioritization of cs pagings will automatically become
 	 * active on congestions (queue almost full) */
@@ -131,6 +167,152 @@ void paging_set_queue_max(struct paging_state *ps, unsigned int queue_max)
 	ps->num_paging_max = queue_max;
 }
 
+/* convert the configured paging lifetime (seconds) into wheel ticks */
+static uint32_t paging_lifetime_ticks(const struct paging_state *ps)
+{
+	uint64_t lifetime_fn = (uint64_t)ps->paging_lifetime * 1000000 / GSM_TDMA_FN_DURATION_uS;
+
+	return (lifetime_fn + PAGING_WHEEL_TICK_FN - 1) / PAGING_WHEEL_TICK_FN;
+}
+
+static void wheel_insert(struct paging_state *ps, struct paging_record *pr)
+{
+	uint32_t expiry = pr->u.paging.expiration_tick;
+	uint32_t delta = expiry - ps->wheel.now;
+	struct llist_head *slot;
+
+	if (delta < PAGING_WHEEL_SLOTS)
+		slot = &ps->wheel.level[0][expiry & PAGING_WHEEL_MASK];
+	else {
+		/* records beyond the range of level 1 are parked in its last
+		 * slot and will be re-inserted when it is cascaded */
+		if (delta >= PAGING_WHEEL_SLOTS * PAGING_WHEEL_SLOTS)
+			expiry = ps->wheel.now + PAGING_WHEEL_SLOTS * PAGING_WHEEL_SLOTS - 1;
+		slot = &ps->wheel.level[1][(expiry >> PAGING_WHEEL_BITS) & PAGING_WHEEL_MASK];
+	}
+
+	llist_add_tail(&pr->u.paging.wheel_list, slot);
+}
+
+/* (re)start the lifetime of a paging record */
+static void paging_record_arm(struct paging_state *ps, struct paging_record *pr)
+{
+	uint32_t lifetime = paging_lifetime_ticks(ps);
+
+	llist_del_init(&pr->u.paging.wheel_list);
+	pr->u.paging.expiration_tick = ps->wheel.now + lifetime;
+	pr->u.paging.expired = (lifetime == 0);
+	if (!pr->u.paging.expired)
+		wheel_insert(ps, pr);
+}
+
+/* only used for records which have been sent (or by paging_reset()), so
+ * num_fresh of the paging group is not affected */
+static void paging_record_free(struct paging_state *ps, struct paging_record *pr)
+{
+	llist_del(&pr->list);
+	if (pr->type == PAGING_RECORD_PAGING) {
+		llist_del(&pr->u.paging.wheel_list);
+		ps->num_paging--;
+	}
+	talloc_free(pr);
+}
+
+/* lifetime of a paging record is over: free it right away unless it has
+ * never been sent, in which case it is freed after its first transmission */
+static void paging_record_expire(struct paging_state *ps, struct paging_record *pr)
+{
+	llist_del_init(&pr->u.paging.wheel_list);
+	pr->u.paging.expired = true;
+
+	if (!pr->u.paging.sent)
+		return;
+
+	paging_record_free(ps, pr);
+	LOGP(DPAG, LOGL_INFO, "Expired paging record, queue_len=%u\n", ps->num_paging);
+}
+
+static void wheel_tick(struct paging_state *ps)
+{
+	struct paging_record *pr, *pr2;
+	struct llist_head *slot;
+	uint32_t now = ++ps->wheel.now;
+
+	/* cascade the records of the next level 1 slot down to level 0 */
+	if ((now & PAGING_WHEEL_MASK) == 0) {
+		LLIST_HEAD(cascade);
+
+		slot = &ps->wheel.level[1][(now >> PAGING_WHEEL_BITS) & PAGING_WHEEL_MASK];
+		llist_splice_init(slot, &cascade);
+		llist_for_each_entry_safe(pr, pr2, &cascade, u.paging.wheel_list) {
+			llist_del_init(&pr->u.paging.wheel_list);
+			if (pr->u.paging.expiration_tick == now)
+				paging_record_expire(ps, pr);
+			else
+				wheel_insert(ps, pr);
+		}
+	}
+
+	slot = &ps->wheel.level[0][now & PAGING_WHEEL_MASK];
+	llist_for_each_entry_safe(pr, pr2, slot, u.paging.wheel_list)
+		paging_record_expire(ps, pr);
+}
+
+/* the lifetime of all records is over, e.g. after a jump of the clock */
+static void wheel_expire_all(struct paging_state *ps)
+{
+	struct paging_record *pr, *pr2;
+	unsigned int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(ps->wheel.level); i++) {
+		for (j = 0; j < ARRAY_SIZE(ps->wheel.level[i]); j++) {
+			llist_for_each_entry_safe(pr, pr2, &ps->wheel.level[i][j], u.paging.wheel_list)
+				paging_record_expire(ps, pr);
+		}
+	}
+}
+
+/* advance the timing wheel up to the given frame number */
+static void paging_wheel_advance(struct paging_state *ps, uint32_t fn)
+{
+	uint32_t elapsed_fn;
+
+	if (!ps->wheel.last_fn_valid) {
+		ps->wheel.last_fn = fn;
+		ps->wheel.last_fn_valid = true;
+		return;
+	}
+
+	elapsed_fn = GSM_TDMA_FN_SUB(fn, ps->wheel.last_fn);
+	ps->wheel.last_fn = fn;
+
+	/* The frame number went backwards, e.g. because the clock of the
+	 * transceiver was reset: resynchronize.  The lifetime of the records
+	 * is kept in ticks, so they just continue from here. */
+	if (elapsed_fn >= GSM_TDMA_HYPERFRAME / 2) {
+		LOGP(DPAG, LOGL_NOTICE, "Frame number jumped back to %u, "
+		     "resynchronizing paging expiry\n", fn);
+		ps->wheel.fn_rem = 0;
+		return;
+	}
+
+	/* Jump beyond the span of the wheel: no need to tick through it */
+	if (elapsed_fn >= PAGING_WHEEL_TICK_FN * PAGING_WHEEL_SLOTS * PAGING_WHEEL_SLOTS) {
+		LOGP(DPAG, LOGL_NOTICE, "Frame number jumped forward to %u, "
+		     "expiring all paging records\n", fn);
+		wheel_expire_all(ps);
+		ps->wheel.now += elapsed_fn / PAGING_WHEEL_TICK_FN;
+		ps->wheel.fn_rem = elapsed_fn % PAGING_WHEEL_TICK_FN;
+		return;
+	}
+
+	ps->wheel.fn_rem += elapsed_fn;
+	while (ps->wheel.fn_rem >= PAGING_WHEEL_TICK_FN) {
+		ps->wheel.fn_rem -= PAGING_WHEEL_TICK_FN;
+		wheel_tick(ps);
+	}
+}
+
 static int tmsi_mi_to_uint(uint32_t *out, const uint8_t *tmsi_lv)
 {
 	if (tmsi_lv[0] < 5)
@@ -236,8 +418,7 @@ int paging_add_identity(struct paging_state *ps, uint8_t paging_group,
 		    !memcmp(identity_lv+1, pr->u.paging.identity_lv+1,
 							identity_lv[0])) {
 			LOGP(DPAG, LOGL_INFO, "Ignoring duplicate paging\n");
-			pr->u.paging.expiration_time =
-					time(NULL) + ps->paging_lifetime;
+			paging_record_arm(ps, pr);
 			return -EEXIST;
 		}
 	}
@@ -246,6 +427,7 @@ int paging_add_identity(struct paging_state *ps, uint8_t paging_group,
 	if (!pr)
 		return -ENOMEM;
 	pr->type = PAGING_RECORD_PAGING;
+	INIT_LLIST_HEAD(&pr->u.paging.wheel_list);
 
 	if (*identity_lv + 1 > sizeof(pr->u.paging.identity_lv)) {
 		talloc_free(pr);
@@ -255,7 +437,7 @@ int paging_add_identity(struct paging_state *ps, uint8_t paging_group,
 	LOGP(DPAG, LOGL_INFO, "Add paging to queue (group=%u, queue_len=%u)\n",
 		paging_group, ps->num_paging+1);
 
-	pr->u.paging.expiration_time = time(NULL) + ps->paging_lifetime;
+	paging_record_arm(ps, pr);
 	pr->u.paging.chan_needed = chan_needed;
 	memcpy(&pr->u.paging.identity_lv, identity_lv, identity_lv[0]+1);
 
@@ -263,6 +445,7 @@ int paging_add_identity(struct paging_state *ps, uint8_t paging_group,
 	 * to ensure it will be paged quickly at least once.  */
 	llist_add(&pr->list, group_q);
 	ps->num_paging++;
+	ps->num_fresh[paging_group]++;
 
 	return 0;
 }
@@ -308,6 +491,7 @@ int paging_add_imm_ass(struct paging_state *ps, const uint8_t *data,
 
 	/* enqueue the new message to the HEAD of the queue */
 	llist_add(&pr->list, group_q);
+	ps->num_fresh[paging_group]++;
 
 	return 0;
 }
@@ -507,32 +691,67 @@ static struct paging_record *dequeue_pr(struct llist_head *group_q)
 	return pr;
 }
 
-static int pr_is_imsi(struct paging_record *pr)
+static bool pr_is_tmsi(const struct paging_record *pr)
 {
-	if ((pr->u.paging.identity_lv[1] & 7) == GSM_MI_TYPE_IMSI)
-		return 1;
-	else
-		return 0;
+	return (pr->u.paging.identity_lv[1] & 7) == GSM_MI_TYPE_TMSI;
 }
 
-static void sort_pr_tmsi_imsi(struct paging_record *pr[], unsigned int n)
+/* take pr[idx] out of the window and append it to the selection */
+static void select_pr(struct paging_record *pr[], unsigned int idx,
+		      struct paging_record *sel[], unsigned int *num_sel)
 {
-	int i, j;
-	struct paging_record *t;
+	sel[(*num_sel)++] = pr[idx];
+	pr[idx] = NULL;
+}
 
-	if (n < 2)
-		return;
+/* Pick the combination of paging records from the window pr[] which carries
+ * the highest number of identities in one PCH block:
+ *
+ *   4 selected: PAGING REQUEST TYPE 3 (4 TMSI)
+ *   3 selected: PAGING REQUEST TYPE 2 (2 TMSI, 1 xMSI)
+ *   1..2 selected: PAGING REQUEST TYPE 1 (1..2 xMSI)
+ *
+ * The first (oldest) record of the window is always selected, the remaining
+ * ones are taken in queue order.  Selected records are removed from pr[] (set
+ * to NULL) and stored in sel[], TMSIs first.  Returns the number of selected
+ * records. */
+static unsigned int pack_paging_records(struct paging_record *pr[], unsigned int num_pr,
+					struct paging_record *sel[4])
+{
+	unsigned int i, num_tmsi = 0, num_sel = 0;
 
-	/* simple bubble sort */
-	for (i = n-2; i >= 0; i--) {
-		for (j=0; j<=i ; j++) {
-			if (pr_is_imsi(pr[j]) > pr_is_imsi(pr[j+1])) {
-				t = pr[j];
-				pr[j] = pr[j+1];
-				pr[j+1] = t;
+	OSMO_ASSERT(num_pr > 0);
+
+	for (i = 0; i < num_pr; i++) {
+		if (pr_is_tmsi(pr[i]))
+			num_tmsi++;
+	}
+
+	if (pr_is_tmsi(pr[0]) && num_tmsi >= 4) {
+		/* TYPE 3: the four oldest TMSIs */
+		for (i = 0; i < num_pr && num_sel < 4; i++) {
+			if (pr_is_tmsi(pr[i]))
+				select_pr(pr, i, sel, &num_sel);
+		}
+	} else if (num_tmsi >= 2 && num_pr >= 3) {
+		/* TYPE 2: the two oldest TMSIs, plus the oldest other record */
+		for (i = 0; i < num_pr && num_sel < 2; i++) {
+			if (pr_is_tmsi(pr[i]))
+				select_pr(pr, i, sel, &num_sel);
+		}
+		for (i = 0; i < num_pr; i++) {
+			if (pr[i] != NULL) {
+				select_pr(pr, i, sel, &num_sel);
+				break;
 			}
 		}
+	} else {
+		/* TYPE 1: the two oldest records of any identity type */
+		for (i = 0; i < num_pr && num_sel < 2; i++)
+			select_pr(pr, i, sel, &num_sel);
 	}
+
+	return num_sel;
 }
 
 static void build_p1_rest_octets(struct p1_rest_octets *p1ro, struct gsm_bts *bts)
@@ -561,6 +780,26 @@ static void build_p1_rest_octets(struct p1_rest_octets *p1ro, struct gsm_bts *bt
 	bts->etws.next_page = (bts->etws.next_page + 1) % bts->etws.num_pages;
 }
 
+/* Check whether the PCH block of the given paging group may be given to the
+ * AGCH: this is the case if enabled, if the AGCH queue is not empty and if the
+ * paging group only contains records which have been sent at least once.
+ * After PAGING_MAX_YIELD consecutive blocks, one is used for paging again so
+ * that repetitions are not starved by a RACH storm. */
+static bool paging_yield_to_agch(struct paging_state *ps, int group)
+{
+	if (!ps->bts->agch_queue.pch_preempt)
+		return false;
+	if (ps->bts->agch_queue.length == 0)
+		return false;
+	if (ps->num_fresh[group] > 0)
+		return false;
+	if (ps->num_yield[group] >= PAGING_MAX_YIELD)
+		return false;
+
+	ps->num_yield[group]++;
+	return true;
+}
+
 /* generate paging message for given gsm time */
 int paging_gen_msg(struct paging_state *ps, uint8_t *out_buf, struct gsm_time *gt,
 		   int *is_empty)
@@ -572,6 +811,8 @@ int paging_gen_msg(struct paging_state *ps, uint8_t *out_buf, struct gsm_time *g
 
 	/* This will have no effect on behavior of this function, we just need
 	 * need to check the congestion status of the queue from time to time. */
+	paging_wheel_advance(ps, gt->fn);
+
 	check_congestion(ps);
 
 	*is_empty = 0;
@@ -591,21 +832,22 @@ int paging_gen_msg(struct paging_state *ps, uint8_t *out_buf, struct gsm_time *g
 		struct p1_rest_octets p1ro;
 		build_p1_rest_octets(&p1ro, bts);
 		len = fill_paging_type_1(out_buf, empty_id_lv, 0, NULL, 0, &p1ro);
-	} else if (llist_empty(group_q)) {
+	} else if (llist_empty(group_q) || paging_yield_to_agch(ps, group)) {
 		/* There is nobody to be paged, send Type1 with two empty ID */
 		//DEBUGP(DPAG, "Tx PAGING TYPE 1 (empty)\n");
 		len = fill_paging_type_1(out_buf, empty_id_lv, 0,
 					 NULL, 0, NULL);
 		*is_empty = 1;
 	} else {
-		struct paging_record *pr[4];
-		unsigned int num_pr = 0, imm_ass = 0;
-		time_t now = time(NULL);
-		unsigned int i, num_imsi = 0;
+		struct paging_record *pr[PAGING_PACK_WINDOW];
+		struct paging_record *sel[4];
+		unsigned int num_pr = 0, num_sel, imm_ass = 0;
+		unsigned int i;
 
 		bts->load.ccch.pch_used += 1;
+		ps->num_yield[group] = 0;
 
-		/* get (if we have) up to four paging records */
+		/* get (if we have) up to PAGING_PACK_WINDOW paging records */
 		for (i = 0; i < ARRAY_SIZE(pr); i++) {
 			if (llist_empty(group_q))
 				break;
@@ -613,22 +855,23 @@ int paging_gen_msg(struct paging_state *ps, uint8_t *out_buf, struct gsm_time *g
 
 			/* check for IMM.ASS */
 			if (pr[i]->type == PAGING_RECORD_IMM_ASS) {
-				imm_ass = 1;
+				/* an IMM.ASS among the first four records is
+				 * sent right away, later ones end the window */
+				if (i < 4)
+					imm_ass = 1;
+				else
+					llist_add(&pr[i]->list, group_q);
 				break;
 			}
 
 			num_pr++;
-
-			/* count how many IMSIs are among them */
-			if (pr_is_imsi(pr[i]))
-				num_imsi++;
 		}
 
 		/* if we have an IMMEDIATE ASSIGNMENT */
 		if (imm_ass) {
 			/* re-add paging records */
-			for (i = 0; i < num_pr; i++)
-				llist_add(&pr[i]->list, group_q);
+			for (i = num_pr; i > 0; i--)
+				llist_add(&pr[i - 1]->list, group_q);
 
 			/* get message and free record */
 			memcpy(out_buf, pr[num_pr]->u.imm_ass.msg,
@@ -636,82 +879,76 @@ int paging_gen_msg(struct paging_state *ps, uint8_t *out_buf, struct gsm_time *g
 			pcu_tx_pch_data_cnf(gt->fn, pr[num_pr]->u.imm_ass.msg,
 							GSM_MACBLOCK_LEN);
 			talloc_free(pr[num_pr]);
+			ps->num_fresh[group]--;
+			BTS_PROBE3(paging_gen_msg, bts->nr, gt->fn, GSM_MACBLOCK_LEN);
 			return GSM_MACBLOCK_LEN;
 		}
 
-		/* make sure the TMSIs are ahead of the IMSIs in the array */
-		sort_pr_tmsi_imsi(pr, num_pr);
+		num_sel = pack_paging_records(pr, num_pr, sel);
 
-		if (num_pr == 4 && num_imsi == 0) {
-			/* No IMSI: easy case, can use TYPE 3 */
+		switch (num_sel) {
+		case 4:
 			DEBUGP(DPAG, "Tx PAGING TYPE 3 (4 TMSI)\n");
 			len = fill_paging_type_3(out_buf,
-						 pr[0]->u.paging.identity_lv,
-						 pr[0]->u.paging.chan_needed,
-						 pr[1]->u.paging.identity_lv,
-						 pr[1]->u.paging.chan_needed,
-						 pr[2]->u.paging.identity_lv,
-						 pr[2]->u.paging.chan_needed,
-						 pr[3]->u.paging.identity_lv,
-						 pr[3]->u.paging.chan_needed);
-		} else if (num_pr >= 3 && num_imsi <= 1) {
-			/* 3 or 4, of which only up to 1 is IMSI */
+						 sel[0]->u.paging.identity_lv,
+						 sel[0]->u.paging.chan_needed,
+						 sel[1]->u.paging.identity_lv,
+						 sel[1]->u.paging.chan_needed,
+						 sel[2]->u.paging.identity_lv,
+						 sel[2]->u.paging.chan_needed,
+						 sel[3]->u.paging.identity_lv,
+						 sel[3]->u.paging.chan_needed);
+			break;
+		case 3:
 			DEBUGP(DPAG, "Tx PAGING TYPE 2 (2 TMSI,1 xMSI)\n");
 			len = fill_paging_type_2(out_buf,
-						 pr[0]->u.paging.identity_lv,
-						 pr[0]->u.paging.chan_needed,
-						 pr[1]->u.paging.identity_lv,
-						 pr[1]->u.paging.chan_needed,
-						 pr[2]->u.paging.identity_lv);
-			if (num_pr == 4) {
-				/* re-add #4 for next time */
-				llist_add(&pr[3]->list, group_q);
-				pr[3] = NULL;
-			}
-		} else if (num_pr == 1) {
+						 sel[0]->u.paging.identity_lv,
+						 sel[0]->u.paging.chan_needed,
+						 sel[1]->u.paging.identity_lv,
+						 sel[1]->u.paging.chan_needed,
+						 sel[2]->u.paging.identity_lv);
+			break;
+		case 2:
+			DEBUGP(DPAG, "Tx PAGING TYPE 1 (2 xMSI)\n");
+			len = fill_paging_type_1(out_buf,
+						 sel[0]->u.paging.identity_lv,
+						 sel[0]->u.paging.chan_needed,
+						 sel[1]->u.paging.identity_lv,
+						 sel[1]->u.paging.chan_needed, NULL);
+			break;
+		default:
 			DEBUGP(DPAG, "Tx PAGING TYPE 1 (1 xMSI,1 empty)\n");
 			len = fill_paging_type_1(out_buf,
-						 pr[0]->u.paging.identity_lv,
-						 pr[0]->u.paging.chan_needed,
+						 sel[0]->u.paging.identity_lv,
+						 sel[0]->u.paging.chan_needed,
 						 NULL, 0, NULL);
-		} else {
-			/* 2 (any type) or
-			 * 3 or 4, of which only 2 will be sent */
-			DEBUGP(DPAG, "Tx PAGING TYPE 1 (2 xMSI)\n");
-			len = fill_paging_type_1(out_buf,
-						 pr[0]->u.paging.identity_lv,
-						 pr[0]->u.paging.chan_needed,
-						 pr[1]->u.paging.identity_lv,
-						 pr[1]->u.paging.chan_needed, NULL);
-			if (num_pr >= 3) {
-				/* re-add #4 for next time */
-				llist_add(&pr[2]->list, group_q);
-				pr[2] = NULL;
-			}
-			if (num_pr == 4) {
-				/* re-add #4 for next time */
-				llist_add(&pr[3]->list, group_q);
-				pr[3] = NULL;
-			}
+			break;
 		}
 
-		for (i = 0; i < num_pr; i++) {
-			/* skip those that we might have re-added above */
-			if (pr[i] == NULL)
+		/* re-add the records which were not sent (in their order) */
+		for (i = num_pr; i > 0; i--) {
+			if (pr[i - 1] == NULL)
 				continue;
+			llist_add(&pr[i - 1]->list, group_q);
+		}
+
+		for (i = 0; i < num_sel; i++) {
 			rate_ctr_inc2(bts->ctrs, BTS_CTR_PAGING_SENT);
-			/* check if we can expire the paging record,
-			 * or if we need to re-queue it */
-			if (pr[i]->u.paging.expiration_time <= now) {
-				talloc_free(pr[i]);
-				ps->num_paging--;
+			if (!sel[i]->u.paging.sent)
+				ps->num_fresh[group]--;
+			sel[i]->u.paging.sent = true;
+			/* re-queue the paging record, unless its
+			 * lifetime is already over */
+			llist_add_tail(&sel[i]->list, group_q);
+			if (sel[i]->u.paging.expired) {
+				paging_record_free(ps, sel[i]);
 				LOGP(DPAG, LOGL_INFO, "Removed paging record, queue_len=%u\n",
 					ps->num_paging);
-			} else
-				llist_add_tail(&pr[i]->list, group_q);
+			}
 		}
 	}
 	memset(out_buf+len, 0x2B, GSM_MACBLOCK_LEN-len);
+	BTS_PROBE3(paging_gen_msg, bts->nr, gt->fn, len);
 	return len;
 }
 
@@ -746,7 +983,7 @@ struct paging_state *paging_init(struct gsm_bts *bts,
 				 unsigned int paging_lifetime)
 {
 	struct paging_state *ps;
-	unsigned int i;
+	unsigned int i, j;
 
 	ps  = talloc_zero(bts, struct paging_state);
 	if (!ps)
@@ -760,6 +997,11 @@ struct paging_state *paging_init(struct gsm_bts *bts,
 	for (i = 0; i < ARRAY_SIZE(ps->paging_queue); i++)
 		INIT_LLIST_HEAD(&ps->paging_queue[i]);
 
+	for (i = 0; i < ARRAY_SIZE(ps->wheel.level); i++) {
+		for (j = 0; j < ARRAY_SIZE(ps->wheel.level[i]); j++)
+			INIT_LLIST_HEAD(&ps->wheel.level[i][j]);
+	}
+
 	if (!initialized) {
 		osmo_signal_register_handler(SS_GLOBAL, paging_signal_cbfn, NULL);
 		initialized = 1;
@@ -782,17 +1024,16 @@ void paging_reset(struct paging_state *ps)
 	for (i = 0; i < ARRAY_SIZE(ps->paging_queue); i++) {
 		struct llist_head *queue = &ps->paging_queue[i];
 		struct paging_record *pr, *pr2;
-		llist_for_each_entry_safe(pr, pr2, queue, list) {
-			llist_del(&pr->list);
-			talloc_free(pr);
-			ps->num_paging--;
-		}
+		llist_for_each_entry_safe(pr, pr2, queue, list)
+			paging_record_free(ps, pr);
 	}
 
 	if (ps->num_paging != 0)
 		LOGP(DPAG, LOGL_NOTICE, "num_paging != 0 after flushing all records?!?\n");
 
 	ps->num_paging = 0;
+	memset(ps->num_fresh, 0, sizeof(ps->num_fresh));
+	memset(ps->num_yield, 0, sizeof(ps->num_yield));
 }
 
 /**
@@ -0,0 +1,243 @@
+/* Encoding of PCU interface primitives */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/pcu_if.h>
+#include <osmo-bts/pcu_enc.h>
+
+struct msgb *pcu_msgb_alloc(uint8_t msg_type, uint8_t bts_nr)
+{
+	struct msgb *msg;
+	struct gsm_pcu_if *pcu_prim;
+
+	msg = msgb_alloc(sizeof(struct gsm_pcu_if), "pcu_sock_tx");
+	if (!msg)
+		return NULL;
+	msgb_put(msg, sizeof(struct gsm_pcu_if));
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+	pcu_prim->msg_type = msg_type;
+	pcu_prim->bts_nr = bts_nr;
+
+	return msg;
+}
+
+/* Whether two INFO.ind only differ in their timeslot entries */
+static bool info_ind_only_ts_differ(const struct gsm_pcu_if_info_ind *a,
+				    const struct gsm_pcu_if_info_ind *b)
+{
+	const size_t trx_offs = offsetof(struct gsm_pcu_if_info_ind, trx);
+	const size_t bsic_offs = offsetof(struct gsm_pcu_if_info_ind, bsic);
+	unsigned int i;
+
+	if (memcmp(a, b, trx_offs) != 0)
+		return false;
+	if (memcmp(&a->bsic, &b->bsic, sizeof(*a) - bsic_offs) != 0)
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(a->trx); i++) {
+		if (a->trx[i].arfcn != b->trx[i].arfcn)
+			return false;
+		if (a->trx[i].hlayer1 != b->trx[i].hlayer1)
+			return false;
+	}
+
+	return true;
+}
+
+/* Encode the INFO_DELTA.ind from state->last to info_ind */
+static struct msgb *info_delta_ind_encode(const struct pcu_info_state *state, uint8_t bts_nr,
+					  const struct gsm_pcu_if_info_ind *info_ind)
+{
+	const struct gsm_pcu_if_info_ind *last = &state->last;
+	struct gsm_pcu_if_info_delta_ind *delta_ind;
+	struct gsm_pcu_if_info_delta_ts *delta_ts;
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+	unsigned int trx_nr, tn;
+
+	msg = msgb_alloc(PCUIF_HDR_SIZE + sizeof(*delta_ind)
+			 + ARRAY_SIZE(info_ind->trx) * 8 * sizeof(*delta_ts), "pcu_sock_tx");
+	if (!msg)
+		return NULL;
+	pcu_prim = (struct gsm_pcu_if *) msgb_put(msg, PCUIF_HDR_SIZE + sizeof(*delta_ind));
+	memset(pcu_prim, 0, msgb_length(msg));
+	pcu_prim->msg_type = PCU_IF_MSG_INFO_DELTA_IND;
+	pcu_prim->bts_nr = bts_nr;
+	delta_ind = &pcu_prim->u.info_delta_ind;
+	delta_ind->seq = state->seq + 1;
+
+	for (trx_nr = 0; trx_nr < ARRAY_SIZE(info_ind->trx); trx_nr++) {
+		const struct gsm_pcu_if_info_trx *trx_info = &info_ind->trx[trx_nr];
+		const struct gsm_pcu_if_info_trx *last_trx_info = &last->trx[trx_nr];
+
+		for (tn = 0; tn < 8; tn++) {
+			bool pdch = trx_info->pdch_mask & (1 << tn);
+
+			if (pdch == !!(last_trx_info->pdch_mask & (1 << tn)) &&
+			    !memcmp(&trx_info->ts[tn], &last_trx_info->ts[tn], sizeof(trx_info->ts[tn])))
+				continue;
+
+			delta_ts = (struct gsm_pcu_if_info_delta_ts *) msgb_put(msg, sizeof(*delta_ts));
+			delta_ts->trx_nr = trx_nr;
+			delta_ts->ts_nr = tn;
+			delta_ts->pdch = pdch;
+			delta_ts->spare = 0;
+			delta_ts->ts = trx_info->ts[tn];
+			delta_ind->num_ts++;
+		}
+	}
+
+	return msg;
+}
+
+/*! Encode the BTS info for the PCU.  If the PCU requested it and only
+ *  timeslot entries changed since the last one, just these are encoded in an
+ *  INFO_DELTA.ind, otherwise the complete INFO.ind.  The state is updated
+ *  as if the message was received by the PCU, if sending it fails the
+ *  caller has to clear state->valid, so that the next one is complete.
+ *  \param[inout] state INFO.ind last sent to the PCU
+ *  \param[in] bts_nr BTS number
+ *  \param[in] info_ind current BTS info
+ *  \param[out] msg_out the message to send, NULL if nothing changed
+ *  \returns 0 on success, negative on error */
+int pcu_info_ind_encode(struct pcu_info_state *state, uint8_t bts_nr,
+			const struct gsm_pcu_if_info_ind *info_ind, struct msgb **msg_out)
+{
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+
+	*msg_out = NULL;
+
+	if (state->delta && state->valid && info_ind_only_ts_differ(info_ind, &state->last)) {
+		msg = info_delta_ind_encode(state, bts_nr, info_ind);
+		if (!msg)
+			return -ENOMEM;
+		pcu_prim = (struct gsm_pcu_if *) msg->data;
+		/* don't bother the PCU (and don't use up a seq) for nothing */
+		if (pcu_prim->u.info_delta_ind.num_ts == 0) {
+			msgb_free(msg);
+			return 0;
+		}
+		state->seq++;
+	} else {
+		msg = pcu_msgb_alloc(PCU_IF_MSG_INFO_IND, bts_nr);
+		if (!msg)
+			return -ENOMEM;
+		pcu_prim = (struct gsm_pcu_if *) msg->data;
+		pcu_prim->u.info_ind = *info_ind;
+		state->seq = 0;
+		state->valid = true;
+	}
+
+	state->last = *info_ind;
+	*msg_out = msg;
+
+	return 0;
+}
+
+/*! Allocate an empty BATCH.ind */
+struct msgb *pcu_batch_alloc(uint8_t bts_nr)
+{
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+
+	msg = msgb_alloc(PCU_IF_BATCH_MAX_LEN, "pcu_sock_tx_batch");
+	if (!msg)
+		return NULL;
+	pcu_prim = (struct gsm_pcu_if *) msgb_put(msg,
+		PCUIF_HDR_SIZE + sizeof(pcu_prim->u.batch_ind));
+	memset(pcu_prim, 0, msgb_length(msg));
+	pcu_prim->msg_type = PCU_IF_MSG_BATCH_IND;
+	pcu_prim->bts_nr = bts_nr;
+
+	return msg;
+}
+
+/*! Append a primitive to a BATCH.ind.
+ *  \returns 0 on success, -ENOSPC if it does not fit into the batch */
+int pcu_batch_append(struct msgb *msg, uint8_t msg_type, const void *prim, uint8_t len)
+{
+	struct gsm_pcu_if *pcu_prim = (struct gsm_pcu_if *) msg->data;
+	struct gsm_pcu_if_batch_elem *elem;
+
+	if (msgb_tailroom(msg) < sizeof(*elem) + len)
+		return -ENOSPC;
+
+	elem = (struct gsm_pcu_if_batch_elem *) msgb_put(msg, sizeof(*elem) + len);
+	elem->msg_type = msg_type;
+	elem->len = len;
+	memcpy(elem->data, prim, len);
+
+	pcu_prim->u.batch_ind.num_elems++;
+	pcu_prim->u.batch_ind.length += sizeof(*elem) + len;
+
+	return 0;
+}
+
+/*! Call cb for each primitive of a received BATCH.ind.
+ *  \param[in] pcu_prim the BATCH.ind
+ *  \param[in] prim_len number of bytes received
+ *  \returns number of primitives, -EINVAL if the batch is malformed (in
+ *	     which case cb has not been called), or the first negative
+ *	     return value of cb */
+int pcu_batch_decode(const struct gsm_pcu_if *pcu_prim, size_t prim_len,
+		     pcu_batch_elem_cb cb, void *cb_data)
+{
+	const struct gsm_pcu_if_batch_ind *batch_ind = &pcu_prim->u.batch_ind;
+	const size_t hdr_len = PCUIF_HDR_SIZE + sizeof(*batch_ind);
+	const struct gsm_pcu_if_batch_elem *elem;
+	unsigned int i, offs;
+	int rc;
+
+	if (prim_len < hdr_len || prim_len > PCU_IF_BATCH_MAX_LEN)
+		return -EINVAL;
+	if (batch_ind->length != prim_len - hdr_len)
+		return -EINVAL;
+
+	/* validate all elements first, so that a malformed batch is rejected
+	 * as a whole */
+	for (i = 0, offs = 0; i < batch_ind->num_elems; i++) {
+		if (offs + sizeof(*elem) > batch_ind->length)
+			return -EINVAL;
+		elem = (const struct gsm_pcu_if_batch_elem *) &batch_ind->elems[offs];
+		offs += sizeof(*elem) + elem->len;
+		if (offs > batch_ind->length)
+			return -EINVAL;
+	}
+	if (offs != batch_ind->length)
+		return -EINVAL;
+
+	for (i = 0, offs = 0; i < batch_ind->num_elems; i++) {
+		elem = (const struct gsm_pcu_if_batch_elem *) &batch_ind->elems[offs];
+		rc = cb(elem->msg_type, elem->data, elem->len, cb_data);
+		if (rc < 0)
+			return rc;
+		offs += sizeof(*elem) + elem->len;
+	}
+
+	return batch_ind->num_elems;
+}
@@ -0,0 +1,234 @@
+/* Shared memory data plane of the BTS-PCU interface */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/utils.h>
+
+#include <osmo-bts/logging.h>
+#include <osmo-bts/pcu_if.h>
+#include <osmo-bts/pcu_shm.h>
+#include <osmo-bts/shm_ring.h>
+
+#include "btsconfig.h"
+
+osmo_static_assert(sizeof(struct gsm_pcu_if_shm_rec) == sizeof(struct shm_ring_rec), pcu_shm_rec_size);
+osmo_static_assert(PCU_IF_SHM_REC_WRAP == SHM_RING_REC_WRAP, pcu_shm_rec_wrap);
+
+#define PCU_SHM_RING(ring) SHM_RING(ring, DPCU, "PCU")
+
+/*
+ * Single producer, single consumer ring, see pcuif_proto.h
+ */
+
+/*! Reserve space for a primitive at the head of a ring.
+ *  \param[in] ring the ring to write to.
+ *  \param[in] len length of the primitive.
+ *  \returns pointer to len bytes to be filled by the caller before calling
+ *	     pcu_shm_ring_commit(), or NULL if the ring is full. */
+void *pcu_shm_ring_reserve(struct gsm_pcu_if_shm_ring *ring, uint16_t len)
+{
+	return shm_ring_reserve(&PCU_SHM_RING(ring), len);
+}
+
+/*! Make a primitive previously reserved with pcu_shm_ring_reserve()
+ *  visible to the consumer. */
+void pcu_shm_ring_commit(struct gsm_pcu_if_shm_ring *ring, uint16_t len)
+{
+	shm_ring_commit(&PCU_SHM_RING(ring), len);
+}
+
+struct pcu_shm_rx_state {
+	pcu_shm_rx_cb_t *cb;
+	void *cb_data;
+};
+
+static void pcu_shm_ring_rx_cb(const uint8_t *data, uint16_t len, void *cb_data)
+{
+	struct pcu_shm_rx_state *st = cb_data;
+
+	st->cb((struct gsm_pcu_if *) data, len, st->cb_data);
+}
+
+/*! Read all primitives available in a ring.
+ *  \param[in] ring the ring to read from.
+ *  \param[in] cb function to call for each primitive.
+ *  \param[in] cb_data opaque data passed to cb.
+ *  \returns number of primitives read. */
+int pcu_shm_ring_read(struct gsm_pcu_if_shm_ring *ring,
+		      pcu_shm_rx_cb_t *cb, void *cb_data)
+{
+	struct pcu_shm_rx_state st = { .cb = cb, .cb_data = cb_data };
+
+	return shm_ring_read(&PCU_SHM_RING(ring), pcu_shm_ring_rx_cb, &st);
+}
+
+/*
+ * Shared memory area and wake-up
+ */
+
+static int pcu_shm_rx_fd_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct pcu_shm *shm = ofd->data;
+	uint64_t val;
+
+	/* reading resets the counter, the number of wake-ups does not matter */
+	if (read(ofd->fd, &val, sizeof(val)) < 0 && errno != EAGAIN)
+		return -errno;
+
+	pcu_shm_ring_read(&shm->area->ring[PCU_IF_SHM_RING_PCU2BTS],
+			  shm->rx_cb, shm->rx_cb_data);
+
+	return 0;
+}
+
+/*! Whether the shared memory data plane can be used on this system. */
+bool pcu_shm_supported(void)
+{
+#ifdef HAVE_MEMFD_CREATE
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*! Allocate the shared memory area and eventfds for a PCU connection.
+ *  \param[in] ctx talloc context.
+ *  \param[in] rx_cb function to call for each primitive from the PCU.
+ *  \param[in] rx_cb_data opaque data passed to rx_cb.
+ *  \returns the shared memory state, NULL on error. */
+struct pcu_shm *pcu_shm_alloc(void *ctx, pcu_shm_rx_cb_t *rx_cb, void *rx_cb_data)
+{
+#ifdef HAVE_MEMFD_CREATE
+	struct pcu_shm *shm;
+	void *area;
+	int fd;
+
+	shm = talloc_zero(ctx, struct pcu_shm);
+	if (!shm)
+		return NULL;
+	shm->mem_fd = -1;
+	shm->tx_efd = -1;
+	shm->rx_ofd.fd = -1;
+	shm->rx_cb = rx_cb;
+	shm->rx_cb_data = rx_cb_data;
+
+	shm->mem_fd = memfd_create("osmo-bts-pcu", MFD_CLOEXEC);
+	if (shm->mem_fd < 0)
+		goto err;
+	if (ftruncate(shm->mem_fd, sizeof(*shm->area)) < 0)
+		goto err;
+
+	area = mmap(NULL, sizeof(*shm->area), PROT_READ | PROT_WRITE,
+		    MAP_SHARED, shm->mem_fd, 0);
+	if (area == MAP_FAILED)
+		goto err;
+	shm->area = area;
+	shm->area->magic = PCU_IF_SHM_MAGIC;
+	shm->area->ring_size = PCU_IF_SHM_RING_SIZE;
+
+	shm->tx_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (shm->tx_efd < 0)
+		goto err;
+
+	fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0)
+		goto err;
+	osmo_fd_setup(&shm->rx_ofd, fd, OSMO_FD_READ, pcu_shm_rx_fd_cb, shm, 0);
+	if (osmo_fd_register(&shm->rx_ofd) < 0) {
+		close(fd);
+		shm->rx_ofd.fd = -1;
+		goto err;
+	}
+
+	return shm;
+
+err:
+	LOGP(DPCU, LOGL_ERROR, "Failed to set up PCU shared memory: %s\n",
+	     strerror(errno));
+	pcu_shm_free(shm);
+	return NULL;
+#else
+	LOGP(DPCU, LOGL_ERROR, "PCU shared memory is not supported on this system\n");
+	return NULL;
+#endif
+}
+
+void pcu_shm_free(struct pcu_shm *shm)
+{
+	if (shm->rx_ofd.fd >= 0) {
+		osmo_fd_unregister(&shm->rx_ofd);
+		close(shm->rx_ofd.fd);
+	}
+	if (shm->tx_efd >= 0)
+		close(shm->tx_efd);
+	if (shm->area)
+		munmap(shm->area, sizeof(*shm->area));
+	if (shm->mem_fd >= 0)
+		close(shm->mem_fd);
+	talloc_free(shm);
+}
+
+/*! Write a primitive to the BTS->PCU ring.  The PCU is not woken up before
+ *  pcu_shm_tx_flush() is called, so that it is only woken up once for all
+ *  primitives of a scheduling round. */
+int pcu_shm_tx(struct pcu_shm *shm, uint8_t msg_type, uint8_t bts_nr,
+	       const void *prim, uint16_t len)
+{
+	struct gsm_pcu_if_shm_ring *ring = &shm->area->ring[PCU_IF_SHM_RING_BTS2PCU];
+	struct gsm_pcu_if *pcu_prim;
+
+	pcu_prim = pcu_shm_ring_reserve(ring, PCUIF_HDR_SIZE + len);
+	if (!pcu_prim) {
+		LOGP(DPCU, LOGL_ERROR, "PCU shared memory ring is full, "
+		     "dropping message type 0x%02x\n", msg_type);
+		return -ENOSPC;
+	}
+
+	memset(pcu_prim, 0, PCUIF_HDR_SIZE);
+	pcu_prim->msg_type = msg_type;
+	pcu_prim->bts_nr = bts_nr;
+	memcpy(&pcu_prim->u, prim, len);
+
+	pcu_shm_ring_commit(ring, PCUIF_HDR_SIZE + len);
+	shm->tx_pending = true;
+
+	return 0;
+}
+
+/*! Wake up the PCU if primitives were written since the last call. */
+void pcu_shm_tx_flush(struct pcu_shm *shm)
+{
+	uint64_t val = 1;
+
+	if (!shm->tx_pending)
+		return;
+	shm->tx_pending = false;
+
+	if (write(shm->tx_efd, &val, sizeof(val)) < 0 && errno != EAGAIN)
+		LOGP(DPCU, LOGL_ERROR, "Failed to wake up PCU: %s\n", strerror(errno));
+}
@@ -30,6 +30,7 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <inttypes.h>
+#include <stddef.h>
 
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/select.h>
@@ -40,6 +41,8 @@
 #include <osmo-bts/gsm_data.h>
 #include <osmo-bts/pcu_if.h>
 #include <osmo-bts/pcuif_proto.h>
+#include <osmo-bts/pcu_shm.h>
+#include <osmo-bts/pcu_enc.h>
 #include <osmo-bts/bts.h>
 #include <osmo-bts/rsl.h>
 #include <osmo-bts/signal.h>
@@ -63,26 +66,32 @@ static const char *sapi_string[] = {
 	[PCU_IF_SAPI_PTCCH] = 	"PTCCH",
 };
 
+/* maximum number of messages read from the PCU socket at once */
+#define PCU_SOCK_RX_BUDGET	16
+
+struct pcu_sock_state {
+	struct gsm_network *net;
+	struct osmo_fd listen_bfd;	/* fd for listen socket */
+	struct osmo_fd conn_bfd;	/* fd for connection to lcr */
+	struct llist_head upqueue;	/* queue for sending messages */
+	bool batch;			/* PCU requested batched indications */
+	struct msgb *batch_msg;		/* BATCH.ind not yet sent, or NULL */
+	struct pcu_shm *shm;		/* shared memory data plane, or NULL */
+
+	/* INFO.ind as last sent to the PCU, base of INFO_DELTA.ind */
+	struct pcu_info_state info;
+
+	/* receive buffer, re-used for every message from the PCU */
+	union {
+		struct gsm_pcu_if pcu_prim;
+		uint8_t buf[sizeof(struct gsm_pcu_if) + 1000];
+	} rx;
+};
+
 /*
  * PCU messages
  */
 
-struct msgb *pcu_msgb_alloc(uint8_t msg_type, uint8_t bts_nr)
-{
-	struct msgb *msg;
-	struct gsm_pcu_if *pcu_prim;
-
-	msg = msgb_alloc(sizeof(struct gsm_pcu_if), "pcu_sock_tx");
-	if (!msg)
-		return NULL;
-	msgb_put(msg, sizeof(struct gsm_pcu_if));
-	pcu_prim = (struct gsm_pcu_if *) msg->data;
-	pcu_prim->msg_type = msg_type;
-	pcu_prim->bts_nr = bts_nr;
-
-	return msg;
-}
-
 static bool ts_should_be_pdch(const struct gsm_bts_trx_ts *ts)
 {
 	switch (ts->pchan) {
@@ -232,28 +241,13 @@ static void info_ind_fill_trx(struct gsm_pcu_if_info_trx *trx_info,
 	}
 }
 
-int pcu_tx_info_ind(void)
+static void info_ind_fill(struct gsm_pcu_if_info_ind *info_ind,
+			  struct gsm_network *net, struct gsm_bts *bts)
 {
-	struct gsm_network *net = &bts_gsmnet;
-	struct msgb *msg;
-	struct gsm_pcu_if *pcu_prim;
-	struct gsm_pcu_if_info_ind *info_ind;
-	struct gsm_bts *bts;
-	struct gprs_rlc_cfg *rlcc;
+	struct gprs_rlc_cfg *rlcc = &bts->gprs.cell.rlc_cfg;
 	struct gsm_bts_trx *trx;
 	int i;
 
-	LOGP(DPCU, LOGL_INFO, "Sending info\n");
-
-	/* FIXME: allow multiple BTS */
-	bts = llist_entry(net->bts_list.next, struct gsm_bts, list);
-	rlcc = &bts->gprs.cell.rlc_cfg;
-
-	msg = pcu_msgb_alloc(PCU_IF_MSG_INFO_IND, bts->nr);
-	if (!msg)
-		return -ENOMEM;
-	pcu_prim = (struct gsm_pcu_if *) msg->data;
-	info_ind = &pcu_prim->u.info_ind;
 	info_ind->version = PCU_IF_VERSION;
 
 	if (avail_lai && avail_nse && avail_cell && avail_nsvc[0]) {
@@ -264,6 +258,10 @@ int pcu_tx_info_ind(void)
 
 	if (pcu_direct)
 		info_ind->flags |= PCU_IF_FLAG_SYSMO;
+	info_ind->flags |= PCU_IF_FLAG_BATCH;
+	if (pcu_shm_supported())
+		info_ind->flags |= PCU_IF_FLAG_SHM;
+	info_ind->flags |= PCU_IF_FLAG_INFO_DELTA;
 
 	info_ind->bsic = bts->bsic;
 	/* RAI */
@@ -358,8 +356,56 @@ int pcu_tx_info_ind(void)
 
 		info_ind_fill_trx(&info_ind->trx[trx->nr], trx);
 	}
+}
+
+/* Send the BTS info to the PCU.  If the PCU requested it and only timeslot
+ * entries changed, just these are sent in an INFO_DELTA.ind, otherwise the
+ * complete INFO.ind is sent. */
+int pcu_tx_info_ind(void)
+{
+	struct gsm_network *net = &bts_gsmnet;
+	struct pcu_sock_state *state = net->pcu_state;
+	struct gsm_pcu_if_info_ind info_ind;
+	struct gsm_pcu_if *pcu_prim;
+	struct gsm_bts *bts;
+	struct msgb *msg;
+	int rc;
+
+	LOGP(DPCU, LOGL_INFO, "Sending info\n");
+
+	/* FIXME: allow multiple BTS */
+	bts = llist_entry(net->bts_list.next, struct gsm_bts, list);
+
+	memset(&info_ind, 0, sizeof(info_ind));
+	info_ind_fill(&info_ind, net, bts);
+
+	if (!state) {
+		msg = pcu_msgb_alloc(PCU_IF_MSG_INFO_IND, bts->nr);
+		if (!msg)
+			return -ENOMEM;
+		pcu_prim = (struct gsm_pcu_if *) msg->data;
+		pcu_prim->u.info_ind = info_ind;
+		return pcu_sock_send(net, msg);
+	}
+
+	rc = pcu_info_ind_encode(&state->info, bts->nr, &info_ind, &msg);
+	if (rc < 0 || !msg) {
+		/* nothing changed, or no memory: resynchronize next time */
+		if (rc < 0)
+			state->info.valid = false;
+		return rc;
+	}
+
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+	if (pcu_prim->msg_type == PCU_IF_MSG_INFO_DELTA_IND)
+		LOGP(DPCU, LOGL_INFO, "Sending info delta #%u (%u timeslots)\n",
+		     pcu_prim->u.info_delta_ind.seq, pcu_prim->u.info_delta_ind.num_ts);
+
+	rc = pcu_sock_send(net, msg);
+	if (rc < 0)
+		state->info.valid = false;
 
-	return pcu_sock_send(net, msg);
+	return rc;
 }
 
 static int pcu_if_signal_cb(unsigned int subsys, unsigned int signal,
@@ -440,41 +486,109 @@ int pcu_tx_app_info_req(struct gsm_bts *bts, uint8_t app_type, uint8_t len, cons
 	return pcu_sock_send(&bts_gsmnet, msg);
 }
 
-int pcu_tx_rts_req(struct gsm_bts_trx_ts *ts, uint8_t is_ptcch, uint32_t fn,
-	uint16_t arfcn, uint8_t block_nr)
+/* Whether a primitive is sent through the shared memory data plane */
+static bool pcu_prim_is_data_plane(uint8_t msg_type, const void *prim)
 {
-	struct msgb *msg;
+	const struct gsm_pcu_if_data *data_ind = prim;
+
+	switch (msg_type) {
+	case PCU_IF_MSG_RTS_REQ:
+	case PCU_IF_MSG_TIME_IND:
+		return true;
+	case PCU_IF_MSG_DATA_IND:
+		return data_ind->sapi == PCU_IF_SAPI_PDTCH
+			|| data_ind->sapi == PCU_IF_SAPI_PTCCH;
+	default:
+		return false;
+	}
+}
+
+/* Send a RTS.req, DATA.ind or TIME.ind primitive.  If the PCU asked for it,
+ * the primitive is written to the shared memory ring, or appended to a
+ * BATCH.ind, which collects all of them until the socket becomes writable
+ * again, i.e. until the end of the current scheduling round.  Otherwise it is
+ * sent as a message of its own. */
+static int pcu_sock_send_prim(struct gsm_network *net, uint8_t msg_type,
+			      uint8_t bts_nr, const void *prim, uint8_t len)
+{
+	struct pcu_sock_state *state = net->pcu_state;
 	struct gsm_pcu_if *pcu_prim;
-	struct gsm_pcu_if_rts_req *rts_req;
-	struct gsm_bts *bts = ts->trx->bts;
+	struct msgb *msg;
+	int rc;
 
-	LOGP(DPCU, LOGL_DEBUG, "Sending rts request: is_ptcch=%d arfcn=%d "
-		"block=%d\n", is_ptcch, arfcn, block_nr);
+	if (state && state->shm && pcu_prim_is_data_plane(msg_type, prim)) {
+		rc = pcu_shm_tx(state->shm, msg_type, bts_nr, prim, len);
+		/* wake up the PCU from pcu_sock_write() */
+		if (rc == 0)
+			osmo_fd_write_enable(&state->conn_bfd);
+		return rc;
+	}
+
+	if (!state || !state->batch) {
+		msg = pcu_msgb_alloc(msg_type, bts_nr);
+		if (!msg)
+			return -ENOMEM;
+		pcu_prim = (struct gsm_pcu_if *) msg->data;
+		memcpy(&pcu_prim->u, prim, len);
+
+		return pcu_sock_send(net, msg);
+	}
+
+	/* append to the pending batch, as long as nothing else was queued
+	 * after it, in order not to change the order of messages */
+	msg = state->batch_msg;
+	if (msg) {
+		pcu_prim = (struct gsm_pcu_if *) msg->data;
+		if (state->upqueue.prev == &msg->list && pcu_prim->bts_nr == bts_nr
+		    && pcu_batch_append(msg, msg_type, prim, len) == 0)
+			return 0;
+	}
 
-	msg = pcu_msgb_alloc(PCU_IF_MSG_RTS_REQ, bts->nr);
+	/* start a new batch */
+	msg = pcu_batch_alloc(bts_nr);
 	if (!msg)
 		return -ENOMEM;
-	pcu_prim = (struct gsm_pcu_if *) msg->data;
-	rts_req = &pcu_prim->u.rts_req;
+	rc = pcu_batch_append(msg, msg_type, prim, len);
+	if (rc < 0) {
+		msgb_free(msg);
+		return rc;
+	}
+
+	rc = pcu_sock_send(net, msg);
+	if (rc < 0)
+		return rc;
+	state->batch_msg = msg;
 
-	rts_req->sapi = (is_ptcch) ? PCU_IF_SAPI_PTCCH : PCU_IF_SAPI_PDTCH;
-	rts_req->fn = fn;
-	rts_req->arfcn = arfcn;
-	rts_req->trx_nr = ts->trx->nr;
-	rts_req->ts_nr = ts->nr;
-	rts_req->block_nr = block_nr;
+	return 0;
+}
 
-	return pcu_sock_send(&bts_gsmnet, msg);
+int pcu_tx_rts_req(struct gsm_bts_trx_ts *ts, uint8_t is_ptcch, uint32_t fn,
+	uint16_t arfcn, uint8_t block_nr)
+{
+	struct gsm_bts *bts = ts->trx->bts;
+	struct gsm_pcu_if_rts_req rts_req = {
+		.sapi = (is_ptcch) ? PCU_IF_SAPI_PTCCH : PCU_IF_SAPI_PDTCH,
+		.fn = fn,
+		.arfcn = arfcn,
+		.trx_nr = ts->trx->nr,
+		.ts_nr = ts->nr,
+		.block_nr = block_nr,
+	};
+
+	LOGP(DPCU, LOGL_DEBUG, "Sending rts request: is_ptcch=%d arfcn=%d "
+		"block=%d\n", is_ptcch, arfcn, block_nr);
+
+	return pcu_sock_send_prim(&bts_gsmnet, PCU_IF_MSG_RTS_REQ, bts->nr,
+				  &rts_req, sizeof(rts_req));
 }
 
 int pcu_tx_data_ind(struct gsm_bts_trx_ts *ts, uint8_t sapi, uint32_t fn,
 	uint16_t arfcn, uint8_t block_nr, uint8_t *data, uint8_t len,
 	int8_t rssi, uint16_t ber10k, int16_t bto, int16_t lqual)
 {
-	struct msgb *msg;
-	struct gsm_pcu_if *pcu_prim;
-	struct gsm_pcu_if_data *data_ind;
+	struct gsm_pcu_if_data data_ind;
 	struct gsm_bts *bts = ts->trx->bts;
+	int rc;
 
 	LOGP(DPCU, LOGL_DEBUG, "Sending data indication: sapi=%s arfcn=%d block=%d data=%s\n",
 	     sapi_string[sapi], arfcn, block_nr, osmo_hexdump(data, len));
@@ -485,27 +599,28 @@ int pcu_tx_data_ind(struct gsm_bts_trx_ts *ts, uint8_t sapi, uint32_t fn,
 		return 0;
 	}
 
-	msg = pcu_msgb_alloc(PCU_IF_MSG_DATA_IND, bts->nr);
-	if (!msg)
-		return -ENOMEM;
-	pcu_prim = (struct gsm_pcu_if *) msg->data;
-	data_ind = &pcu_prim->u.data_ind;
-
-	data_ind->sapi = sapi;
-	data_ind->rssi = rssi;
-	data_ind->fn = fn;
-	data_ind->arfcn = arfcn;
-	data_ind->trx_nr = ts->trx->nr;
-	data_ind->ts_nr = ts->nr;
-	data_ind->block_nr = block_nr;
-	data_ind->ber10k = ber10k;
-	data_ind->ta_offs_qbits = bto;
-	data_ind->lqual_cb = lqual;
+	data_ind = (struct gsm_pcu_if_data) {
+		.sapi = sapi,
+		.rssi = rssi,
+		.fn = fn,
+		.arfcn = arfcn,
+		.trx_nr = ts->trx->nr,
+		.ts_nr = ts->nr,
+		.block_nr = block_nr,
+		.ber10k = ber10k,
+		.ta_offs_qbits = bto,
+		.lqual_cb = lqual,
+	};
 	if (len)
-		memcpy(data_ind->data, data, len);
-	data_ind->len = len;
+		memcpy(data_ind.data, data, len);
+	data_ind.len = len;
 
-	return pcu_sock_send(&bts_gsmnet, msg);
+	rc = pcu_sock_send_prim(&bts_gsmnet, PCU_IF_MSG_DATA_IND, bts->nr,
+				&data_ind, sizeof(data_ind));
+	if (rc >= 0)
+		bts_ul_lat_sent(bts);
+
+	return rc;
 }
 
 int pcu_tx_rach_ind(uint8_t bts_nr, uint8_t trx_nr, uint8_t ts_nr,
@@ -539,24 +654,17 @@ int pcu_tx_rach_ind(uint8_t bts_nr, uint8_t trx_nr, uint8_t ts_nr,
 
 int pcu_tx_time_ind(uint32_t fn)
 {
-	struct msgb *msg;
-	struct gsm_pcu_if *pcu_prim;
-	struct gsm_pcu_if_time_ind *time_ind;
+	struct gsm_pcu_if_time_ind time_ind = {
+		.fn = fn,
+	};
 	uint8_t fn13 = fn % 13;
 
 	/* omit frame numbers not starting at a MAC block */
 	if (fn13 != 0 && fn13 != 4 && fn13 != 8)
 		return 0;
 
-	msg = pcu_msgb_alloc(PCU_IF_MSG_TIME_IND, 0);
-	if (!msg)
-		return -ENOMEM;
-	pcu_prim = (struct gsm_pcu_if *) msg->data;
-	time_ind = &pcu_prim->u.time_ind;
-
-	time_ind->fn = fn;
-
-	return pcu_sock_send(&bts_gsmnet, msg);
+	return pcu_sock_send_prim(&bts_gsmnet, PCU_IF_MSG_TIME_IND, 0,
+				  &time_ind, sizeof(time_ind));
 }
 
 int pcu_tx_interf_ind(uint8_t bts_nr, uint8_t trx_nr, uint32_t fn,
@@ -683,6 +791,7 @@ static int pcu_rx_data_req(struct gsm_bts *bts, uint8_t msg_type,
 		}
 		msg->l3h = msgb_put(msg, data_req->len);
 		memcpy(msg->l3h, data_req->data, data_req->len);
+		bts_dl_lat_stamp(msg, BTS_LAT_SAPI_CCCH);
 		if (bts_agch_enqueue(bts, msg) < 0) {
 			msgb_free(msg);
 			rc = -EIO;
@@ -883,6 +992,99 @@ static int pcu_rx_act_req(struct gsm_bts *bts,
 	return 0;
 }
 
+static int pcu_rx_batch_req(struct gsm_network *net,
+	const struct gsm_pcu_if_batch_req *batch_req)
+{
+	struct pcu_sock_state *state = net->pcu_state;
+
+	LOGP(DPCU, LOGL_INFO, "PCU %s batched indications\n",
+	     batch_req->enable ? "requests" : "declines");
+
+	state->batch = !!batch_req->enable;
+
+	return 0;
+}
+
+static int pcu_rx(struct gsm_network *net, uint8_t msg_type,
+	struct gsm_pcu_if *pcu_prim, size_t prim_len);
+
+static int pcu_rx_info_delta_req(struct gsm_network *net,
+	const struct gsm_pcu_if_info_delta_req *delta_req)
+{
+	struct pcu_sock_state *state = net->pcu_state;
+
+	LOGP(DPCU, LOGL_INFO, "PCU %s info deltas\n",
+	     delta_req->enable ? "requests" : "declines");
+
+	state->info.delta = !!delta_req->enable;
+
+	/* (re)start with a complete INFO.ind */
+	state->info.valid = false;
+	return pcu_tx_info_ind();
+}
+
+/* Primitive read from the PCU->BTS shared memory ring */
+static int pcu_shm_rx(struct gsm_pcu_if *pcu_prim, size_t len, void *data)
+{
+	struct gsm_network *net = data;
+
+	if (len < PCUIF_HDR_SIZE || pcu_prim->msg_type != PCU_IF_MSG_DATA_REQ) {
+		LOGP(DPCU, LOGL_ERROR, "Received unexpected primitive (len=%zu) "
+		     "on PCU shared memory, discarding\n", len);
+		return -EINVAL;
+	}
+
+	return pcu_rx(net, pcu_prim->msg_type, pcu_prim, len);
+}
+
+/* Queue SHM.cnf behind the primitives already in the upqueue.  The file
+ * descriptors of the shared memory are attached when it is actually written
+ * to the socket, see pcu_sock_write_shm_cnf(). */
+static int pcu_tx_shm_cnf(struct pcu_sock_state *state, uint8_t bts_nr)
+{
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+
+	msg = pcu_msgb_alloc(PCU_IF_MSG_SHM_CNF, bts_nr);
+	if (!msg)
+		return -ENOMEM;
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+
+	if (state->shm)
+		pcu_prim->u.shm_cnf.size = sizeof(*state->shm->area);
+	else
+		pcu_prim->u.shm_cnf.result = EIO;
+
+	return pcu_sock_send(state->net, msg);
+}
+
+static int pcu_rx_shm_req(struct gsm_network *net, struct gsm_bts *bts,
+	const struct gsm_pcu_if_shm_req *shm_req)
+{
+	struct pcu_sock_state *state = net->pcu_state;
+	int rc;
+
+	LOGP(DPCU, LOGL_INFO, "PCU %s shared memory data plane\n",
+	     shm_req->enable ? "requests" : "declines");
+
+	if (state->shm) {
+		pcu_shm_free(state->shm);
+		state->shm = NULL;
+	}
+
+	if (!shm_req->enable)
+		return 0;
+
+	state->shm = pcu_shm_alloc(state, pcu_shm_rx, net);
+	rc = pcu_tx_shm_cnf(state, bts->nr);
+	if (rc < 0 && state->shm) {
+		pcu_shm_free(state->shm);
+		state->shm = NULL;
+	}
+
+	return rc;
+}
+
 #define CHECK_IF_MSG_SIZE(prim_len, prim_msg) \
 	do { \
 		size_t _len = PCUIF_HDR_SIZE + sizeof(prim_msg); \
@@ -932,6 +1134,18 @@ static int pcu_rx(struct gsm_network *net, uint8_t msg_type,
 		}
 		rc = abis_osmo_pcu_tx_container(bts, &pcu_prim->u.container);
 		break;
+	case PCU_IF_MSG_BATCH_REQ:
+		CHECK_IF_MSG_SIZE(prim_len, pcu_prim->u.batch_req);
+		rc = pcu_rx_batch_req(net, &pcu_prim->u.batch_req);
+		break;
+	case PCU_IF_MSG_INFO_DELTA_REQ:
+		CHECK_IF_MSG_SIZE(prim_len, pcu_prim->u.info_delta_req);
+		rc = pcu_rx_info_delta_req(net, &pcu_prim->u.info_delta_req);
+		break;
+	case PCU_IF_MSG_SHM_REQ:
+		CHECK_IF_MSG_SIZE(prim_len, pcu_prim->u.shm_req);
+		rc = pcu_rx_shm_req(net, bts, &pcu_prim->u.shm_req);
+		break;
 	default:
 		LOGP(DPCU, LOGL_ERROR, "Received unknown PCU msg type %d\n",
 			msg_type);
@@ -945,13 +1159,6 @@ static int pcu_rx(struct gsm_network *net, uint8_t msg_type,
  * PCU socket interface
  */
 
-struct pcu_sock_state {
-	struct gsm_network *net;
-	struct osmo_fd listen_bfd;	/* fd for listen socket */
-	struct osmo_fd conn_bfd;	/* fd for connection to lcr */
-	struct llist_head upqueue;	/* queue for sending messages */
-};
-
 int pcu_sock_send(struct gsm_network *net, struct msgb *msg)
 {
 	struct pcu_sock_state *state = net->pcu_state;
@@ -1029,6 +1236,16 @@ static void pcu_sock_close(struct pcu_sock_state *state)
 		}
 	}
 
+	/* a new PCU connection has to request batching and deltas again */
+	state->batch = false;
+	state->info.delta = false;
+	state->info.valid = false;
+	state->batch_msg = NULL;
+	if (state->shm) {
+		pcu_shm_free(state->shm);
+		state->shm = NULL;
+	}
+
 	/* flush the queue */
 	while (!llist_empty(&state->upqueue)) {
 		struct msgb *msg = msgb_dequeue(&state->upqueue);
@@ -1039,54 +1256,98 @@ static void pcu_sock_close(struct pcu_sock_state *state)
 static int pcu_sock_read(struct osmo_fd *bfd)
 {
 	struct pcu_sock_state *state = (struct pcu_sock_state *)bfd->data;
-	struct gsm_pcu_if *pcu_prim;
-	struct msgb *msg;
+	struct gsm_pcu_if *pcu_prim = &state->rx.pcu_prim;
+	unsigned int i;
 	int rc;
 
-	msg = msgb_alloc(sizeof(*pcu_prim) + 1000, "pcu_sock_rx");
-	if (!msg)
-		return -ENOMEM;
-
-	pcu_prim = (struct gsm_pcu_if *) msg->tail;
-
-	rc = recv(bfd->fd, msg->tail, msgb_tailroom(msg), 0);
-	if (rc == 0)
-		goto close;
+	/* as we always synchronously process the message in pcu_rx() and
+	 * its callbacks, the same receive buffer can be used for all of them.
+	 * Read up to PCU_SOCK_RX_BUDGET messages before returning to the
+	 * main loop, so that other file descriptors are not starved. */
+	for (i = 0; i < PCU_SOCK_RX_BUDGET; i++) {
+		rc = recv(bfd->fd, state->rx.buf, sizeof(state->rx.buf), MSG_DONTWAIT);
+		if (rc == 0)
+			goto close;
 
-	if (rc < 0) {
-		if (errno == EAGAIN) {
-			msgb_free(msg);
-			return 0;
+		if (rc < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			goto close;
 		}
-		goto close;
-	}
 
-	if (rc < PCUIF_HDR_SIZE) {
-		LOGP(DPCU, LOGL_ERROR, "Received %d bytes on PCU Socket, but primitive hdr size "
-		     "is %zu, discarding\n", rc, PCUIF_HDR_SIZE);
-		msgb_free(msg);
-		return 0;
-	}
+		if (rc < PCUIF_HDR_SIZE) {
+			LOGP(DPCU, LOGL_ERROR, "Received %d bytes on PCU Socket, but primitive hdr size "
+			     "is %zu, discarding\n", rc, PCUIF_HDR_SIZE);
+			continue;
+		}
 
-	rc = pcu_rx(state->net, pcu_prim->msg_type, pcu_prim, rc);
+		pcu_rx(state->net, pcu_prim->msg_type, pcu_prim, rc);
 
-	/* as we always synchronously process the message in pcu_rx() and
-	 * its callbacks, we can free the message here. */
-	msgb_free(msg);
+		/* the connection may have been closed while processing */
+		if (bfd->fd < 0)
+			return -1;
+	}
 
-	return rc;
+	return 0;
 
 close:
-	msgb_free(msg);
 	pcu_sock_close(state);
 	return -1;
 }
 
+/* Write a queued SHM.cnf, together with the file descriptors of the shared
+ * memory.  If the shared memory was released since SHM.cnf was queued, the
+ * PCU is told that it is not available. */
+static int pcu_sock_write_shm_cnf(struct pcu_sock_state *state, struct msgb *msg)
+{
+	struct gsm_pcu_if *pcu_prim = (struct gsm_pcu_if *) msg->data;
+	struct pcu_shm *shm = state->shm;
+	struct iovec iov = {
+		.iov_base = msgb_data(msg),
+		.iov_len = msgb_length(msg),
+	};
+	struct msghdr mh = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+	};
+	union {
+		char buf[CMSG_SPACE(3 * sizeof(int))];
+		struct cmsghdr align;
+	} cmsg_buf;
+	struct cmsghdr *cmsg;
+	int fds[3];
+
+	if (pcu_prim->u.shm_cnf.result == 0 && shm) {
+		fds[0] = shm->mem_fd;
+		fds[1] = shm->tx_efd;
+		fds[2] = shm->rx_ofd.fd;
+
+		mh.msg_control = cmsg_buf.buf;
+		mh.msg_controllen = sizeof(cmsg_buf.buf);
+		cmsg = CMSG_FIRSTHDR(&mh);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+		memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+	} else {
+		pcu_prim->u.shm_cnf.result = EIO;
+		pcu_prim->u.shm_cnf.size = 0;
+	}
+
+	return sendmsg(state->conn_bfd.fd, &mh, 0);
+}
+
 static int pcu_sock_write(struct osmo_fd *bfd)
 {
 	struct pcu_sock_state *state = bfd->data;
 	int rc;
 
+	/* wake up the PCU once for all primitives written to the shared
+	 * memory during this scheduling round */
+	if (state->shm)
+		pcu_shm_tx_flush(state->shm);
+	osmo_fd_write_disable(bfd);
+
 	while (!llist_empty(&state->upqueue)) {
 		struct msgb *msg, *msg2;
 		struct gsm_pcu_if *pcu_prim;
@@ -1095,8 +1356,6 @@ static int pcu_sock_write(struct osmo_fd *bfd)
 		msg = llist_entry(state->upqueue.next, struct msgb, list);
 		pcu_prim = (struct gsm_pcu_if *)msg->data;
 
-		osmo_fd_write_disable(bfd);
-
 		/* bug hunter 8-): maybe someone forgot msgb_put(...) ? */
 		if (!msgb_length(msg)) {
 			LOGP(DPCU, LOGL_ERROR, "message type (%d) with ZERO "
@@ -1105,7 +1364,10 @@ static int pcu_sock_write(struct osmo_fd *bfd)
 		}
 
 		/* try to send it over the socket */
-		rc = write(bfd->fd, msgb_data(msg), msgb_length(msg));
+		if (pcu_prim->msg_type == PCU_IF_MSG_SHM_CNF)
+			rc = pcu_sock_write_shm_cnf(state, msg);
+		else
+			rc = write(bfd->fd, msgb_data(msg), msgb_length(msg));
 		if (rc == 0)
 			goto close;
 		if (rc < 0) {
@@ -1120,6 +1382,8 @@ dontsend:
 		/* _after_ we send it, we can deueue */
 		msg2 = msgb_dequeue(&state->upqueue);
 		assert(msg == msg2);
+		if (msg == state->batch_msg)
+			state->batch_msg = NULL;
 		msgb_free(msg);
 	}
 	return 0;
@@ -58,6 +58,7 @@
 #include <osmo-bts/l1sap.h>
 #include <osmo-bts/bts_model.h>
 #include <osmo-bts/pcuif_proto.h>
+#include <osmo-bts/probes.h>
 
 //#define FAKE_CIPH_MODE_COMPL
 
@@ -822,6 +823,20 @@ static inline void lapdm_ui_prefix_bts(struct gsm_bts *bts, const uint8_t *curre
 	lapdm_ui_prefix(GSM_BTS_SI(bts, osmo_si), &bts->si_valid, current, osmo_si, len);
 }
 
+/*! Get the shared SACCH buffer of the BTS for a given SI type, NULL if not valid */
+static struct gsm_sacch_si *bts_sacch_si(struct gsm_bts *bts, uint8_t osmo_si)
+{
+	if (!GSM_BTS_HAS_SI(bts, osmo_si))
+		return NULL;
+
+	if (!bts->sacch_si[osmo_si]) {
+		bts->sacch_si[osmo_si] = sacch_si_alloc(bts);
+		memcpy(bts->sacch_si[osmo_si]->buf, GSM_BTS_SI(bts, osmo_si), sizeof(sysinfo_buf_t));
+	}
+
+	return bts->sacch_si[osmo_si];
+}
+
 /*! Prefix a given SACCH frame with a L2/LAPDm UI header and store it in given lchan SACCH buffer
  *  \param[out] lchan Logical Channel in whose System Information State we shall store
  *  \param[in] current input data (L3 without L2/L1 header)
@@ -829,7 +844,19 @@ static inline void lapdm_ui_prefix_bts(struct gsm_bts *bts, const uint8_t *curre
  *  \param[in] len length of \a current in octets */
 static inline void lapdm_ui_prefix_lchan(struct gsm_lchan *lchan, const uint8_t *current, uint8_t osmo_si, uint16_t len)
 {
-	lapdm_ui_prefix(GSM_LCHAN_SI(lchan, osmo_si), &lchan->si.valid, current, osmo_si, len);
+	struct gsm_bts *bts = lchan->ts->trx->bts;
+	struct gsm_sacch_si *si = sacch_si_alloc(bts);
+	struct gsm_sacch_si *bts_si;
+
+	lapdm_ui_prefix(si->buf, &lchan->si.valid, current, osmo_si, len);
+
+	/* share the BTS buffer if the contents are the same */
+	bts_si = bts_sacch_si(bts, osmo_si);
+	if (bts_si && !memcmp(bts_si->buf, si->buf, sizeof(sysinfo_buf_t)))
+		lchan_sacch_si_set(lchan, osmo_si, bts_si);
+	else
+		lchan_sacch_si_set(lchan, osmo_si, si);
+	sacch_si_put(si);
 }
 
 /* 8.6.2 SACCH FILLING */
@@ -857,10 +884,17 @@ static int rsl_rx_sacch_fill(struct gsm_bts_trx *trx, struct msgb *msg)
 	}
 	if (TLVP_PRESENT(&tp, RSL_IE_L3_INFO)) {
 		uint16_t len = TLVP_LEN(&tp, RSL_IE_L3_INFO);
+		struct gsm_sacch_si *si;
 		struct gsm_bts_trx *t;
 
 		lapdm_ui_prefix_bts(bts, TLVP_VAL(&tp, RSL_IE_L3_INFO), osmo_si, len);
 
+		/* The shared buffer is never modified, replace it */
+		if (bts->sacch_si[osmo_si])
+			sacch_si_put(bts->sacch_si[osmo_si]);
+		bts->sacch_si[osmo_si] = NULL;
+		si = bts_sacch_si(bts, osmo_si);
+
 		/* Propagate SI change to all lchans which adhere to BTS-global default. */
 		llist_for_each_entry(t, &bts->trx_list, list) {
 			int i, j;
@@ -870,7 +904,8 @@ static int rsl_rx_sacch_fill(struct gsm_bts_trx *trx, struct msgb *msg)
 					struct gsm_lchan *lchan = &ts->lchan[j];
 					if (lchan->state == LCHAN_S_NONE || (lchan->si.overridden & (1 << osmo_si)))
 						continue;
-					lapdm_ui_prefix_lchan(lchan, TLVP_VAL(&tp, RSL_IE_L3_INFO), osmo_si, len);
+					lchan->si.valid |= (1 << osmo_si);
+					lchan_sacch_si_set(lchan, osmo_si, si);
 				}
 			}
 		}
@@ -881,6 +916,9 @@ static int rsl_rx_sacch_fill(struct gsm_bts_trx *trx, struct msgb *msg)
 		struct gsm_bts_trx *t;
 
 		bts->si_valid &= ~(1 << osmo_si);
+		if (bts->sacch_si[osmo_si])
+			sacch_si_put(bts->sacch_si[osmo_si]);
+		bts->sacch_si[osmo_si] = NULL;
 
 		/* Propagate SI change to all lchans which adhere to BTS-global default. */
 		llist_for_each_entry(t, &bts->trx_list, list) {
@@ -892,6 +930,7 @@ static int rsl_rx_sacch_fill(struct gsm_bts_trx *trx, struct msgb *msg)
 					if (lchan->state == LCHAN_S_NONE || (lchan->si.overridden & (1 << osmo_si)))
 						continue;
 					lchan->si.valid &= ~(1 << osmo_si);
+					lchan_sacch_si_set(lchan, osmo_si, NULL);
 				}
 			}
 		}
@@ -1296,6 +1335,7 @@ int rsl_tx_rf_rel_ack(struct gsm_lchan *lchan)
 	 * has released all the resources.
 	 */
 	lapdm_channel_exit(&lchan->lapdm_ch);
+	bts_dl_lat_rll_reset(lchan);
 
 	/* Also ensure that there are no leftovers from repeated FACCH or
 	 * repeated SACCH that might cause memory leakage. */
@@ -1446,7 +1486,7 @@ int rsl_tx_chan_rqd(struct gsm_bts_trx *trx, struct gsm_time *gtime,
 	return abis_bts_rsl_sendmsg(nmsg);
 }
 
-/* copy the SACCH related sysinfo from BTS global buffer to lchan specific buffer */
+/* let the lchan use the SACCH related sysinfo of the BTS (no copy, the buffers are shared) */
 static void copy_sacch_si_to_lchan(struct gsm_lchan *lchan)
 {
 	struct gsm_bts *bts = lchan->ts->trx->bts;
@@ -1463,10 +1503,11 @@ static void copy_sacch_si_to_lchan(struct gsm_lchan *lchan)
 			continue;
 		if (!(bts->si_valid & osmo_si_shifted)) {
 			lchan->si.valid &= ~osmo_si_shifted;
+			lchan_sacch_si_set(lchan, osmo_si, NULL);
 			continue;
 		}
 		lchan->si.valid |= osmo_si_shifted;
-		memcpy(GSM_LCHAN_SI(lchan, osmo_si), GSM_BTS_SI(bts, osmo_si), sizeof(sysinfo_buf_t));
+		lchan_sacch_si_set(lchan, osmo_si, bts_sacch_si(bts, osmo_si));
 	}
 }
 
@@ -1977,6 +2018,7 @@ static int rsl_rx_rf_chan_rel(struct gsm_lchan *lchan, uint8_t chan_nr)
 	l1sap_chan_rel(lchan->ts->trx, chan_nr);
 
 	lapdm_channel_exit(&lchan->lapdm_ch);
+	bts_dl_lat_rll_reset(lchan);
 
 	return 0;
 }
@@ -2409,6 +2451,7 @@ static int rsl_rx_sacch_inf_mod(struct msgb *msg)
 			  get_value_string(osmo_sitype_strs, osmo_si));
 	} else {
 		lchan->si.valid &= ~(1 << osmo_si);
+		lchan_sacch_si_set(lchan, osmo_si, NULL);
 		LOGPLCHAN(lchan, DRSL, LOGL_INFO, "Rx RSL Disabling SACCH FILLING (SI%s)\n",
 			  get_value_string(osmo_sitype_strs, osmo_si));
 	}
@@ -3345,11 +3388,20 @@ static int rsl_reject_unknown_lchan(struct msgb *msg)
  * selecting message
  */
 
+static inline int rsl_link_id_is_sacch(uint8_t link_id)
+{
+	if (link_id >> 6 == 1)
+		return 1;
+	else
+		return 0;
+}
+
 static int rsl_rx_rll(struct gsm_bts_trx *trx, struct msgb *msg)
 {
 	struct abis_rsl_rll_hdr *rh = msgb_l2(msg);
 	struct abis_rsl_rll_hdr rh2;
 	struct gsm_lchan *lchan;
+	uint32_t lat_ts_us;
 	int rc;
 
 	if (msgb_l2len(msg) < sizeof(*rh)) {
@@ -3383,20 +3435,19 @@ static int rsl_rx_rll(struct gsm_bts_trx *trx, struct msgb *msg)
 
 	/* make copy of RLL header, as the message will be free'd in case of erroneous return */
 	rh2 = *rh;
+	lat_ts_us = msgb_dl_lat_ts(msg);
 	/* exception: RLL messages are _NOT_ freed as they are now
 	 * owned by LAPDm which might have queued them */
 	rc = lapdm_rslms_recvmsg(msg, &lchan->lapdm_ch);
-	if (rc < 0)
+	if (rc < 0) {
 		rsl_tx_error_report(trx, RSL_ERR_MSG_TYPE, &rh2.chan_nr, &rh2.link_id, NULL);
-	return rc;
-}
+		return rc;
+	}
 
-static inline int rsl_link_id_is_sacch(uint8_t link_id)
-{
-	if (link_id >> 6 == 1)
-		return 1;
-	else
-		return 0;
+	if (rh2.c.msg_type == RSL_MT_DATA_REQ || rh2.c.msg_type == RSL_MT_UNIT_DATA_REQ)
+		bts_dl_lat_rll_push(lchan, rsl_link_id_is_sacch(rh2.link_id), rh2.link_id & 0x07,
+				    lat_ts_us);
+	return rc;
 }
 
 static int rslms_get_rll_msg_type(struct msgb *msg)
@@ -3581,6 +3632,10 @@ int rsl_tx_meas_res(struct gsm_lchan *lchan, uint8_t *l3, int l3_len, const stru
 	rsl_dch_push_hdr(msg, RSL_MT_MEAS_RES, chan_nr);
 	msg->trx = lchan->ts->trx;
 
+	/* under overload, send a few per TDMA frame instead of in bursts */
+	if (bts->ovld.level >= BTS_OVLD_L_MEAS_RES)
+		return bts_ovld_meas_res_defer(bts, msg);
+
 	return abis_bts_rsl_sendmsg(msg);
 }
 
@@ -3603,6 +3658,23 @@ int lapdm_rll_tx_cb(struct msgb *msg, struct lapdm_entity *le, void *ctx)
 	msg->trx = lchan->ts->trx;
 	msg->lchan = lchan;
 
+	/* LAPDm discards its queues and starts over with N(S) = 0 when a
+	 * data link is (re)established or released */
+	if ((rh->msg_discr & 0xfe) == ABIS_RSL_MDISC_RLL
+	    && msgb_l2len(msg) >= sizeof(struct abis_rsl_rll_hdr)) {
+		const struct abis_rsl_rll_hdr *rllh = msgb_l2(msg);
+
+		switch (rh->msg_type) {
+		case RSL_MT_EST_IND:
+		case RSL_MT_EST_CONF:
+		case RSL_MT_REL_IND:
+		case RSL_MT_REL_CONF:
+			bts_dl_lat_rll_reset_sapi(lchan, rsl_link_id_is_sacch(rllh->link_id),
+						  rllh->link_id & 0x07);
+			break;
+		}
+	}
+
 	/* check if this is a measurement report from SACCH which needs special
 	 * processing before forwarding */
 	if (rslms_is_meas_rep(msg)) {
@@ -3876,6 +3948,19 @@ int lchan_deactivate(struct gsm_lchan *lchan)
 	return bts_model_lchan_deactivate(lchan);
 }
 
+/* Channel Number of an RSL message, 0 for TRX management messages */
+static inline uint8_t rsl_probe_chan_nr(const struct msgb *msg)
+{
+	const struct abis_rsl_cchan_hdr *cch = msgb_l2(msg);
+
+	/* RLL, DCHAN and IPACCESS headers have chan_nr at the same offset */
+	if ((cch->c.msg_discr & 0xfe) == ABIS_RSL_MDISC_TRX)
+		return 0;
+	if (msgb_l2len(msg) < sizeof(*cch))
+		return 0;
+	return cch->chan_nr;
+}
+
 int down_rsl(struct gsm_bts_trx *trx, struct msgb *msg)
 {
 	struct abis_rsl_common_hdr *rslh;
@@ -3893,6 +3978,12 @@ int down_rsl(struct gsm_bts_trx *trx, struct msgb *msg)
 		return -EIO;
 	}
 
+	BTS_PROBE3(rsl_down, trx->nr, rslh->msg_type, rsl_probe_chan_nr(msg));
+
+	/* Only AGCH messages reach L1 in this msgb, RLL messages are
+	 * tracked by bts_dl_lat_rll_push() */
+	bts_dl_lat_stamp(msg, BTS_LAT_SAPI_CCCH);
+
 	switch (rslh->msg_discr & 0xfe) {
 	case ABIS_RSL_MDISC_RLL:
 		ret = rsl_rx_rll(trx, msg);
@@ -43,6 +43,8 @@
 #include <osmo-bts/l1sap.h>
 #include <osmo-bts/scheduler.h>
 #include <osmo-bts/scheduler_backend.h>
+#include <osmo-bts/burst_trace.h>
+#include <osmo-bts/probes.h>
 #include <osmo-bts/bts.h>
 
 extern void *tall_bts_ctx;
@@ -746,11 +748,18 @@ struct msgb *_sched_dequeue_prim(struct l1sched_ts *l1ts, const struct trx_dl_bu
 
 		/* unlink and return message */
 		llist_del(&msg->list);
+		burst_trace(BURST_TRACE_EV_DL_DEQUEUE, l1ts->ts->trx->nr, br->fn, br->tn,
+			    br->chan, 0, 0, 0, 0, 1);
+		BTS_PROBE5(dl_dequeue, l1ts->ts->trx->nr, br->fn, br->tn, br->chan, 1);
+		bts_dl_lat_account(l1ts->ts->trx->bts, msg);
 		return msg;
 	}
 
 	/* Queue was traversed with no candidate, no prim is available for current FN: */
 	rate_ctr_inc2(l1ts->ctrs, L1SCHED_TS_CTR_DL_NOT_FOUND);
+	burst_trace(BURST_TRACE_EV_DL_DEQUEUE, l1ts->ts->trx->nr, br->fn, br->tn,
+		    br->chan, 0, 0, 0, 0, 0);
+	BTS_PROBE5(dl_dequeue, l1ts->ts->trx->nr, br->fn, br->tn, br->chan, 0);
 	return NULL;
 
 free_msg:
@@ -760,6 +769,24 @@ free_msg:
 	return NULL;
 }
 
+/* SAPI of an Uplink block for the latency statistics */
+static enum bts_lat_sapi ul_lat_sapi(enum trx_chan_type chan, const uint8_t *l2, uint8_t l2_len)
+{
+	if (chan == TRXC_PDTCH || chan == TRXC_PTCCH)
+		return BTS_LAT_SAPI_PDTCH;
+
+	if (L1SAP_IS_LINK_SACCH(trx_chan_desc[chan].link_id)) {
+		/* skip the L1 header */
+		if (l2_len > 2 && ((l2[2] >> 2) & 0x07) == 3)
+			return BTS_LAT_SAPI_SAPI3;
+		return BTS_LAT_SAPI_SACCH;
+	}
+
+	if (l2_len > 0 && ((l2[0] >> 2) & 0x07) == 3)
+		return BTS_LAT_SAPI_SAPI3;
+	return BTS_LAT_SAPI_DCCH;
+}
+
 int _sched_compose_ph_data_ind(struct l1sched_ts *l1ts, uint32_t fn,
 			       enum trx_chan_type chan, uint8_t *l2,
 			       uint8_t l2_len, float rssi,
@@ -795,8 +822,14 @@ int _sched_compose_ph_data_ind(struct l1sched_ts *l1ts, uint32_t fn,
 	if (L1SAP_IS_LINK_SACCH(trx_chan_desc[chan].link_id))
 		l1ts->chan_state[chan].lost_frames = 0;
 
+	burst_trace(BURST_TRACE_EV_UL_DATA, l1ts->ts->trx->nr, fn, l1ts->ts->nr, chan,
+		    (int8_t) rssi, ta_offs_256bits, link_qual_cb, 0, ber10k);
+	BTS_PROBE5(ul_data_ind, l1ts->ts->trx->nr, fn, l1ts->ts->nr, chan, l2_len);
+
 	/* forward primitive */
+	bts_ul_lat_decoded(l1ts->ts->trx->bts, ul_lat_sapi(chan, l2, l2_len));
 	l1sap_up(l1ts->ts->trx, l1sap);
+	bts_ul_lat_done();
 
 	return 0;
 }
@@ -836,8 +869,11 @@ int _sched_compose_tch_ind(struct l1sched_ts *l1ts, uint32_t fn,
 
 	LOGL1S(DL1P, LOGL_DEBUG, l1ts, chan, l1sap->u.data.fn, "%s Rx -> RTP: %s\n",
 	       gsm_lchan_name(lchan), osmo_hexdump(msgb_l2(msg), msgb_l2len(msg)));
+	BTS_PROBE5(ul_tch_ind, l1ts->ts->trx->nr, fn, l1ts->ts->nr, chan, tch_len);
 	/* forward primitive */
+	bts_ul_lat_decoded(l1ts->ts->trx->bts, BTS_LAT_SAPI_TCH);
 	l1sap_up(l1ts->ts->trx, l1sap);
+	bts_ul_lat_done();
 
 	return 0;
 }
@@ -1318,12 +1354,17 @@ void _sched_dl_burst(struct l1sched_ts *l1ts, struct trx_dl_burst_req *br)
 	br->tsc = l1ts->ts->tsc;
 
 	/* get burst from function */
+	BTS_PROBE5(dl_burst_entry, l1ts->ts->trx->nr, br->fn, br->tn, br->chan, br->bid);
 	if (func(l1ts, br) != 0)
 		return;
+	BTS_PROBE5(dl_burst_return, l1ts->ts->trx->nr, br->fn, br->tn, br->chan, br->burst_len);
 
 	/* Modulation is indicated by func() */
 	br->mod = l1cs->dl_mod_type;
 
+	burst_trace(BURST_TRACE_EV_DL_BURST, l1ts->ts->trx->nr, br->fn, br->tn,
+		    br->chan, 0, 0, 0, br->mod, br->burst_len);
+
 	/* BS Power reduction (in dB) per logical channel */
 	if (l1cs->lchan != NULL)
 		br->att = l1cs->lchan->bs_power_ctrl.current;
@@ -1450,6 +1491,88 @@ static int trx_sched_calc_frame_loss(struct l1sched_ts *l1ts,
 	return 0;
 }
 
+/* Add a set of UL burst measurements to the history */
+void trx_sched_meas_push(struct l1sched_chan_state *chan_state,
+			 const struct trx_ul_burst_ind *bi)
+{
+	unsigned int hist_size = ARRAY_SIZE(chan_state->meas.buf);
+	unsigned int current = chan_state->meas.current;
+
+	chan_state->meas.buf[current] = (struct l1sched_meas_set) {
+		.ci_cb = (bi->flags & TRX_BI_F_CI_CB) ? bi->ci_cb : 0,
+		.toa256 = bi->toa256,
+		.rssi = bi->rssi,
+	};
+
+	chan_state->meas.current = (current + 1) % hist_size;
+}
+
+/* Calculate the AVG of n measurements from the history */
+void trx_sched_meas_avg(const struct l1sched_chan_state *chan_state,
+			struct l1sched_meas_set *avg,
+			enum sched_meas_avg_mode mode)
+{
+	unsigned int hist_size = ARRAY_SIZE(chan_state->meas.buf);
+	unsigned int current = chan_state->meas.current;
+	const struct l1sched_meas_set *set;
+	unsigned int shift, pos, i, n;
+
+	float rssi_sum = 0;
+	int toa256_sum = 0;
+	int ci_cb_sum = 0;
+
+	switch (mode) {
+	/* last 4 bursts (default for xCCH, TCH/H, PTCCH and PDTCH) */
+	case SCHED_MEAS_AVG_M_QUAD:
+		n = 4; shift = n;
+		break;
+	/* last 8 bursts (default for TCH/F and FACCH/F) */
+	case SCHED_MEAS_AVG_M_OCTO:
+		n = 8; shift = n;
+		break;
+	/* last 6 bursts (default for FACCH/H) */
+	case SCHED_MEAS_AVG_M_SIX:
+		n = 6; shift = n;
+		break;
+	/* first 4 of last 8 bursts */
+	case SCHED_MEAS_AVG_M8_FIRST_QUAD:
+		n = 4; shift = 8;
+		break;
+	/* first 2 of last 6 bursts */
+	case SCHED_MEAS_AVG_M6_FIRST_TWO:
+		n = 2; shift = 6;
+		break;
+	/* middle 2 of last 6 bursts */
+	case SCHED_MEAS_AVG_M6_MIDDLE_TWO:
+		n = 2; shift = 4;
+		break;
+	default:
+		/* Shall not happen */
+		OSMO_ASSERT(false);
+	}
+
+	/* Calculate the sum of n entries starting from pos */
+	for (i = 0; i < n; i++) {
+		pos = (current + hist_size - shift + i) % hist_size;
+		set = &chan_state->meas.buf[pos];
+
+		rssi_sum   += set->rssi;
+		toa256_sum += set->toa256;
+		ci_cb_sum  += set->ci_cb;
+	}
+
+	/* Calculate the average for each value */
+	*avg = (struct l1sched_meas_set) {
+		.rssi   = (rssi_sum   / n),
+		.toa256 = (toa256_sum / n),
+		.ci_cb  = (ci_cb_sum  / n),
+	};
+
+	LOGP(DMEAS, LOGL_DEBUG, "Measurement AVG (num=%u, shift=%u): "
+	     "RSSI %f, ToA256 %d, C/I %d cB\n", n, shift,
+	     avg->rssi, avg->toa256, avg->ci_cb);
+}
+
 /* Process a single noise measurement for an inactive timeslot. */
 static void trx_sched_noise_meas(struct l1sched_chan_state *l1cs,
 				 const struct trx_ul_burst_ind *bi)
@@ -1519,6 +1642,9 @@ int trx_sched_ul_burst(struct l1sched_ts *l1ts, struct trx_ul_burst_ind *bi)
 	l1cs->last_tdma_fn = bi->fn;
 	l1cs->proc_tdma_fs++;
 
+	burst_trace(BURST_TRACE_EV_UL_BURST, l1ts->ts->trx->nr, bi->fn, bi->tn, bi->chan,
+		    bi->rssi, bi->toa256, bi->ci_cb, bi->flags, bi->burst_len);
+
 	/* handle NOPE indications */
 	if (bi->flags & TRX_BI_F_NOPE_IND) {
 		switch (bi->chan) {
@@ -1548,7 +1674,9 @@ int trx_sched_ul_burst(struct l1sched_ts *l1ts, struct trx_ul_burst_ind *bi)
 	}
 
 	/* Invoke the logical channel handler */
+	BTS_PROBE5(ul_burst_entry, l1ts->ts->trx->nr, bi->fn, bi->tn, bi->chan, bi->bid);
 	func(l1ts, bi);
+	BTS_PROBE5(ul_burst_return, l1ts->ts->trx->nr, bi->fn, bi->tn, bi->chan, bi->bid);
 
 	return 0;
 }
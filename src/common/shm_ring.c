@@ -0,0 +1,118 @@
+/* Single producer, single consumer ring in shared memory */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <osmocom/core/logging.h>
+
+#include <osmo-bts/shm_ring.h>
+
+/* Space occupied by a record with a payload of the given length */
+#define SHM_REC_LEN(len) \
+	((sizeof(struct shm_ring_rec) + (len) + 3) & ~3)
+
+/*! Reserve space for a record at the head of a ring.
+ *  \param[in] ring the ring to write to.
+ *  \param[in] len length of the payload.
+ *  \returns pointer to len bytes to be filled by the caller before calling
+ *	     shm_ring_commit(), or NULL if the ring is full. */
+void *shm_ring_reserve(const struct shm_ring *ring, uint16_t len)
+{
+	const uint32_t rec_len = SHM_REC_LEN(len);
+	uint32_t head = *ring->head;
+	uint32_t tail = __atomic_load_n(ring->tail, __ATOMIC_ACQUIRE);
+	uint32_t offs = head % ring->size;
+	uint32_t pad = 0;
+	struct shm_ring_rec *rec;
+
+	if (len >= SHM_RING_REC_WRAP)
+		return NULL;
+
+	/* records do not wrap around, skip the rest of the ring */
+	if (offs + rec_len > ring->size)
+		pad = ring->size - offs;
+
+	if (head - tail + pad + rec_len > ring->size)
+		return NULL;
+
+	if (pad) {
+		rec = (struct shm_ring_rec *) &ring->data[offs];
+		rec->len = SHM_RING_REC_WRAP;
+		__atomic_store_n(ring->head, head + pad, __ATOMIC_RELEASE);
+		offs = 0;
+	}
+
+	rec = (struct shm_ring_rec *) &ring->data[offs];
+	rec->len = len;
+	rec->spare = 0;
+
+	return rec->data;
+}
+
+/*! Make a record previously reserved with shm_ring_reserve() visible to
+ *  the consumer. */
+void shm_ring_commit(const struct shm_ring *ring, uint16_t len)
+{
+	__atomic_store_n(ring->head, *ring->head + SHM_REC_LEN(len), __ATOMIC_RELEASE);
+}
+
+/*! Read all records available in a ring.  If a corrupted record is
+ *  found, the rest of the ring is discarded.
+ *  \param[in] ring the ring to read from.
+ *  \param[in] cb function to call for each record.
+ *  \param[in] cb_data opaque data passed to cb.
+ *  \returns number of records read. */
+int shm_ring_read(const struct shm_ring *ring, shm_ring_rx_cb_t *cb, void *cb_data)
+{
+	const uint32_t size = ring->size;
+	uint32_t head = __atomic_load_n(ring->head, __ATOMIC_ACQUIRE);
+	uint32_t tail = *ring->tail;
+	int num = 0;
+
+	while (tail != head) {
+		uint32_t offs = tail % size;
+		struct shm_ring_rec *rec = (struct shm_ring_rec *) &ring->data[offs];
+		uint16_t len = rec->len;
+
+		if (len == SHM_RING_REC_WRAP) {
+			if (head - tail < size - offs)
+				goto corrupt;
+			tail += size - offs;
+			continue;
+		}
+
+		if (head - tail < SHM_REC_LEN(len) || offs + SHM_REC_LEN(len) > size)
+			goto corrupt;
+
+		cb(rec->data, len, cb_data);
+		tail += SHM_REC_LEN(len);
+		num++;
+	}
+
+	__atomic_store_n(ring->tail, tail, __ATOMIC_RELEASE);
+
+	return num;
+
+corrupt:
+	LOGP(ring->log_subsys, LOGL_ERROR, "Corrupted record in %s shared memory ring, "
+	     "discarding %u bytes\n", ring->name, head - tail);
+	__atomic_store_n(ring->tail, head, __ATOMIC_RELEASE);
+
+	return num;
+}
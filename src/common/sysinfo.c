@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <errno.h>
 
+#include <osmocom/core/talloc.h>
 #include <osmocom/gsm/gsm_utils.h>
 #include <osmocom/gsm/sysinfo.h>
 
@@ -168,18 +169,70 @@ uint8_t num_agch(const struct gsm_bts_trx *trx, const char * arg)
 uint8_t *lchan_sacch_get(struct gsm_lchan *lchan)
 {
 	uint32_t tmp, i;
+	uint8_t *si;
 
 	for (i = 0; i < _MAX_SYSINFO_TYPE; i++) {
 		tmp = (lchan->si.last + 1 + i) % _MAX_SYSINFO_TYPE;
 		if (!(lchan->si.valid & (1 << tmp)))
 			continue;
+		si = GSM_LCHAN_SI(lchan, tmp);
+		if (!si)
+			continue;
 		lchan->si.last = tmp;
-		return GSM_LCHAN_SI(lchan, tmp);
+		return si;
 	}
 	LOGPLCHAN(lchan, DL1P, LOGL_NOTICE, "SACCH no SI available\n");
 	return NULL;
 }
 
+/*! Allocate a SACCH SI buffer with a reference count of 1.  The caller fills
+ *  the buffer, it must not be modified anymore once it is shared. */
+struct gsm_sacch_si *sacch_si_alloc(void *ctx)
+{
+	struct gsm_sacch_si *si = talloc_zero(ctx, struct gsm_sacch_si);
+
+	OSMO_ASSERT(si);
+	si->refcnt = 1;
+
+	return si;
+}
+
+/*! Take a reference to a SACCH SI buffer. */
+struct gsm_sacch_si *sacch_si_get(struct gsm_sacch_si *si)
+{
+	si->refcnt++;
+	return si;
+}
+
+/*! Drop a reference to a SACCH SI buffer, free it if it was the last one. */
+void sacch_si_put(struct gsm_sacch_si *si)
+{
+	OSMO_ASSERT(si->refcnt > 0);
+	if (--si->refcnt == 0)
+		talloc_free(si);
+}
+
+/*! Make an lchan use the given SACCH SI buffer (or none, if NULL). */
+void lchan_sacch_si_set(struct gsm_lchan *lchan, unsigned int osmo_si, struct gsm_sacch_si *si)
+{
+	struct gsm_sacch_si *old = lchan->si.sacch[osmo_si];
+
+	lchan->si.sacch[osmo_si] = si ? sacch_si_get(si) : NULL;
+	if (old)
+		sacch_si_put(old);
+}
+
+/*! Drop all SACCH SI buffers of an lchan, e.g. when it is released. */
+void lchan_sacch_si_release(struct gsm_lchan *lchan)
+{
+	unsigned int i;
+
+	for (i = 0; i < _MAX_SYSINFO_TYPE; i++)
+		lchan_sacch_si_set(lchan, i, NULL);
+	lchan->si.valid = 0;
+	lchan->si.overridden = 0;
+}
+
 /* re-generate SI3 restoctets with GPRS indicator depending on the PCU socket connection state */
 void regenerate_si3_restoctets(struct gsm_bts *bts)
 {
@@ -49,6 +49,8 @@
 #include <osmo-bts/phy_link.h>
 #include <osmo-bts/abis.h>
 #include <osmo-bts/bts.h>
+#include <osmo-bts/gsmtap_batch.h>
+#include <osmo-bts/burst_trace.h>
 #include <osmo-bts/rsl.h>
 #include <osmo-bts/oml.h>
 #include <osmo-bts/signal.h>
@@ -319,6 +321,10 @@ static void config_write_bts_single(struct vty *vty, const struct gsm_bts *bts)
 		vty_out(vty, " agch-queue-mgmt threshold %d low %d high %d%s",
 			bts->agch_queue.thresh_level, bts->agch_queue.low_level,
 			bts->agch_queue.high_level, VTY_NEWLINE);
+	if (bts->agch_queue.imm_ass_ext)
+		vty_out(vty, " agch-queue-mgmt imm-ass-ext enable%s", VTY_NEWLINE);
+	if (bts->agch_queue.pch_preempt)
+		vty_out(vty, " agch-queue-mgmt pch-preempt enable%s", VTY_NEWLINE);
 
 	if (bts->gsmtap.remote_host != NULL)
 		vty_out(vty, " gsmtap-remote-host %s%s",
@@ -337,6 +343,14 @@ static void config_write_bts_single(struct vty *vty, const struct gsm_bts *bts)
 		sapi_buf = osmo_str_tolower(get_value_string(gsmtap_sapi_names, GSMTAP_CHANNEL_ACCH));
 		vty_out(vty, " gsmtap-sapi %s%s", sapi_buf, VTY_NEWLINE);
 	}
+	if (bts->gsmtap.batched)
+		vty_out(vty, " gsmtap-batching enable%s", VTY_NEWLINE);
+	if (bts->gsmtap.sample_rate != 1)
+		vty_out(vty, " gsmtap-sample-rate %u%s", bts->gsmtap.sample_rate, VTY_NEWLINE);
+	for (i = 0; i < 8; i++) {
+		if (~bts->gsmtap.ts_mask & (1 << i))
+			vty_out(vty, " gsmtap-timeslot %u disable%s", i, VTY_NEWLINE);
+	}
 	vty_out(vty, " min-qual-rach %d%s", bts->min_qual_rach,
 		VTY_NEWLINE);
 	vty_out(vty, " min-qual-norm %d%s", bts->min_qual_norm,
@@ -345,6 +359,21 @@ static void config_write_bts_single(struct vty *vty, const struct gsm_bts *bts)
 		VTY_NEWLINE);
 	if (strcmp(bts->pcu.sock_path, PCU_SOCK_DEFAULT))
 		vty_out(vty, " pcu-socket %s%s", bts->pcu.sock_path, VTY_NEWLINE);
+	if (bts->rsl_tx_coalesce_frame)
+		vty_out(vty, " rsl-tx-coalesce frame%s", VTY_NEWLINE);
+	else if (bts->rsl_tx_coalesce_us)
+		vty_out(vty, " rsl-tx-coalesce window %u%s", bts->rsl_tx_coalesce_us, VTY_NEWLINE);
+	if (g_burst_trace) {
+		vty_out(vty, " burst-trace size %u%s", g_burst_trace->num_recs, VTY_NEWLINE);
+		if (g_burst_trace->crash_path)
+			vty_out(vty, " burst-trace crash-dump %s%s",
+				g_burst_trace->crash_path, VTY_NEWLINE);
+	}
+	if (bts->ovld.enabled)
+		vty_out(vty, " overload-shedding enable%s", VTY_NEWLINE);
+	if (bts->ovld.high_pct != 75 || bts->ovld.low_pct != 40)
+		vty_out(vty, " overload-shedding thresholds %u %u%s",
+			bts->ovld.high_pct, bts->ovld.low_pct, VTY_NEWLINE);
 	if (bts->supp_meas_toa256)
 		vty_out(vty, " supp-meas-info toa256%s", VTY_NEWLINE);
 	vty_out(vty, " smscb queue-max-length %d%s", bts->smscb_queue_max_len, VTY_NEWLINE);
@@ -724,6 +753,37 @@ DEFUN_ATTR(cfg_bts_agch_queue_mgmt_default,
 	return CMD_SUCCESS;
 }
 
+DEFUN_ATTR(cfg_bts_agch_queue_mgmt_imm_ass_ext,
+	   cfg_bts_agch_queue_mgmt_imm_ass_ext_cmd,
+	   "agch-queue-mgmt imm-ass-ext (enable|disable)",
+	   AGCH_QUEUE_STR
+	   "Combine two Immediate Assignments for dedicated channels "
+	   "into one Immediate Assignment Extended\n"
+	   "Enable combining\n" "Disable combining (default)\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->agch_queue.imm_ass_ext = !strcmp(argv[0], "enable");
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_ATTR(cfg_bts_agch_queue_mgmt_pch_preempt,
+	   cfg_bts_agch_queue_mgmt_pch_preempt_cmd,
+	   "agch-queue-mgmt pch-preempt (enable|disable)",
+	   AGCH_QUEUE_STR
+	   "Send queued AGCH messages instead of repeated paging on PCH blocks\n"
+	   "Enable preemption\n" "Disable preemption (default)\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->agch_queue.pch_preempt = !strcmp(argv[0], "enable");
+
+	return CMD_SUCCESS;
+}
+
 #define UL_POWER_TARGET_CMD \
 	"uplink-power-target <-110-0>"
 #define UL_POWER_TARGET_CMD_DESC \
@@ -859,6 +919,135 @@ DEFUN(cfg_bts_pcu_sock, cfg_bts_pcu_sock_cmd,
 	return CMD_SUCCESS;
 }
 
+#define RSL_TX_COALESCE_STR "Send RSL messages towards the BSC in batches\n"
+
+DEFUN_ATTR(cfg_bts_rsl_tx_coalesce, cfg_bts_rsl_tx_coalesce_cmd,
+	   "rsl-tx-coalesce (disable|frame)",
+	   RSL_TX_COALESCE_STR
+	   "Send each RSL message on its own (default)\n"
+	   "Coalesce RSL messages generated within one TDMA frame\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+
+	if (!strcmp(argv[0], "frame")) {
+		bts->rsl_tx_coalesce_us = GSM_TDMA_FN_DURATION_uS;
+		bts->rsl_tx_coalesce_frame = true;
+	} else {
+		bts->rsl_tx_coalesce_us = 0;
+		bts->rsl_tx_coalesce_frame = false;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_ATTR(cfg_bts_rsl_tx_coalesce_window, cfg_bts_rsl_tx_coalesce_window_cmd,
+	   "rsl-tx-coalesce window <1-100000>",
+	   RSL_TX_COALESCE_STR
+	   "Coalesce RSL messages generated within a time window\n"
+	   "Window length in microseconds\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->rsl_tx_coalesce_us = atoi(argv[0]);
+	bts->rsl_tx_coalesce_frame = false;
+
+	return CMD_SUCCESS;
+}
+
+#define BURST_TRACE_STR "Binary trace of per-burst scheduler events\n"
+
+DEFUN_ATTR(cfg_bts_burst_trace_size, cfg_bts_burst_trace_size_cmd,
+	   "burst-trace size <0-1048576>",
+	   BURST_TRACE_STR
+	   "Number of trace records to keep (24 bytes each)\n"
+	   "Number of records, rounded up to a power of two, 0 to disable (default)\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	/* the crash dump file is kept on resize, but not when disabling */
+	if (burst_trace_set_size(tall_bts_ctx, atoi(argv[0])) < 0) {
+		vty_out(vty, "%% Failed to allocate the burst trace%s", VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_ATTR(cfg_bts_burst_trace_crash_dump, cfg_bts_burst_trace_crash_dump_cmd,
+	   "burst-trace crash-dump PATH",
+	   BURST_TRACE_STR
+	   "Write the trace to a file when the process aborts\n"
+	   "Path of the file\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	if (!g_burst_trace) {
+		vty_out(vty, "%% Burst trace is disabled, see 'burst-trace size'%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	osmo_talloc_replace_string(g_burst_trace, &g_burst_trace->crash_path, argv[0]);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_ATTR(cfg_bts_no_burst_trace_crash_dump, cfg_bts_no_burst_trace_crash_dump_cmd,
+	   "no burst-trace crash-dump",
+	   NO_STR BURST_TRACE_STR
+	   "Do not write the trace to a file when the process aborts\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	if (g_burst_trace) {
+		talloc_free(g_burst_trace->crash_path);
+		g_burst_trace->crash_path = NULL;
+	}
+
+	return CMD_SUCCESS;
+}
+
+#define OVLD_STR "Shed non-essential work when the frame processing falls behind\n"
+
+DEFUN_ATTR(cfg_bts_overload_shedding, cfg_bts_overload_shedding_cmd,
+	   "overload-shedding (enable|disable)",
+	   OVLD_STR
+	   "Disable GSMTAP, debug logging, interference reports and defer MEAS RES step by step\n"
+	   "Always do all the work (default)\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->ovld.enabled = (strcmp(argv[0], "enable") == 0);
+	if (!bts->ovld.enabled)
+		bts_ovld_reset(bts);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_ATTR(cfg_bts_overload_shedding_thresh, cfg_bts_overload_shedding_thresh_cmd,
+	   "overload-shedding thresholds <1-100> <1-100>",
+	   OVLD_STR
+	   "Thresholds of the average frame processing time\n"
+	   "Shed more above this percentage of a TDMA frame (default 75)\n"
+	   "Shed less below this percentage of a TDMA frame (default 40)\n",
+	   CMD_ATTR_IMMEDIATE)
+{
+	struct gsm_bts *bts = vty->index;
+	int high = atoi(argv[0]);
+	int low = atoi(argv[1]);
+
+	if (low >= high) {
+		vty_out(vty, "%% The lower threshold must be below the upper one%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	bts->ovld.high_pct = high;
+	bts->ovld.low_pct = low;
+
+	return CMD_SUCCESS;
+}
+
 DEFUN_ATTR(cfg_bts_supp_meas_toa256, cfg_bts_supp_meas_toa256_cmd,
 	   "supp-meas-info toa256",
 	   "Configure the RSL Supplementary Measurement Info\n"
@@ -1139,10 +1328,11 @@ static void bts_dump_vty(struct vty *vty, const struct gsm_bts *bts)
 		paging_get_queue_max(bts->paging_state), paging_queue_length(bts->paging_state),
 		paging_get_lifetime(bts->paging_state), VTY_NEWLINE);
 	vty_out(vty, "  AGCH: Queue limit %u, occupied %d, "
-		"dropped %"PRIu64", merged %"PRIu64", rejected %"PRIu64", "
+		"dropped %"PRIu64", merged %"PRIu64" (imm-ass-ext %"PRIu64"), rejected %"PRIu64", "
 		"ag-res %"PRIu64", non-res %"PRIu64"%s",
 		bts->agch_queue.max_length, bts->agch_queue.length,
 		bts->agch_queue.dropped_msgs, bts->agch_queue.merged_msgs,
+		bts->agch_queue.merged_imm_ass_msgs,
 		bts->agch_queue.rejected_msgs, bts->agch_queue.agch_msgs,
 		bts->agch_queue.pch_msgs,
 		VTY_NEWLINE);
@@ -1159,6 +1349,11 @@ static void bts_dump_vty(struct vty *vty, const struct gsm_bts *bts)
 		bts->oml_link ? "connected" : "disconnected", VTY_NEWLINE);
 	vty_out(vty, "  PH-RTS.ind FN advance average: %d, min: %d, max: %d%s",
 		bts_get_avg_fn_advance(bts), bts->fn_stats.min, bts->fn_stats.max, VTY_NEWLINE);
+	if (bts->ovld.enabled)
+		vty_out(vty, "  Overload shedding: level %s, frame processing time %u us, "
+			"MEAS RES queued %u%s",
+			get_value_string(bts_ovld_level_names, bts->ovld.level),
+			bts->ovld.avg_us, bts->ovld.meas_res_queue_len, VTY_NEWLINE);
 	vty_out(vty, "  Radio Link Timeout (OML): %s%s",
 		stringify_radio_link_timeout(bts->radio_link_timeout.oml), VTY_NEWLINE);
 	if (bts->radio_link_timeout.vty_override) {
@@ -1278,6 +1473,60 @@ DEFUN(show_bts_gprs, show_bts_gprs_cmd,
 	return CMD_SUCCESS;
 }
 
+static void bts_lat_dump_vty(struct vty *vty, const struct bts_lat_stats *stats)
+{
+	const struct rate_ctr_group_desc *desc = stats[0].ctrs->desc;
+	unsigned int i, j;
+
+	/* bucket labels are the counter names without the "lat:" prefix */
+	vty_out(vty, "  SAPI     samples  avg ms  max ms");
+	for (j = 0; j < BTS_LAT_NUM_BUCKETS; j++)
+		vty_out(vty, " %6s", desc->ctr_desc[j].name + 4);
+	vty_out(vty, "%s", VTY_NEWLINE);
+
+	for (i = 0; i < _NUM_BTS_LAT_SAPI; i++) {
+		const struct bts_lat_stats *st = &stats[i];
+
+		vty_out(vty, "  %-6s %9"PRIu64" %7.1f %7.1f",
+			get_value_string(bts_lat_sapi_names, i), st->samples,
+			st->samples ? st->sum_us / 1e3 / st->samples : 0.0,
+			st->max_us / 1e3);
+		for (j = 0; j < BTS_LAT_NUM_BUCKETS; j++)
+			vty_out(vty, " %6"PRIu64, rate_ctr_group_get_ctr(st->ctrs, j)->current);
+		vty_out(vty, "%s", VTY_NEWLINE);
+	}
+}
+
+DEFUN(show_bts_latency, show_bts_latency_cmd,
+      "show bts <0-255> latency",
+      SHOW_STR "Display information about a BTS
+"
+      BTS_NR_STR "End-to-end latency through the BTS per SAPI
+")
+{
+	const struct gsm_network *net = gsmnet_from_vty(vty);
+	const struct gsm_bts *bts;
+
+	bts = gsm_bts_num(net, atoi(argv[0]));
+	if (bts == NULL) {
+		vty_out(vty, "%% can't find BTS '%s'%s",
+			argv[0], VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	vty_out(vty, "BTS %u Downlink latency (arrival to first burst):%s",
+		bts->nr, VTY_NEWLINE);
+	bts_lat_dump_vty(vty, bts->dl_lat);
+	vty_out(vty, "BTS %u Uplink decode time (last burst received to block decoded):%s",
+		bts->nr, VTY_NEWLINE);
+	bts_lat_dump_vty(vty, bts->ul_dec);
+	vty_out(vty, "BTS %u Uplink queue time (block decoded to Abis/RTP/PCU):%s",
+		bts->nr, VTY_NEWLINE);
+	bts_lat_dump_vty(vty, bts->ul_queue);
+
+	return CMD_SUCCESS;
+}
+
 DEFUN(test_send_failure_event_report, test_send_failure_event_report_cmd, "test send-failure-event-report <0-255>",
       "Various testing commands\n"
       "Send a test OML failure event report to the BSC\n" BTS_NR_STR)
@@ -1360,6 +1609,30 @@ DEFUN(bts_c0_power_red,
 	return CMD_SUCCESS;
 }
 
+DEFUN(burst_trace_dump, burst_trace_dump_cmd,
+      "burst-trace dump PATH",
+      BURST_TRACE_STR
+      "Write the trace records to a file, see contrib/burst_trace_decode.py\n"
+      "Path of the file\n")
+{
+	int rc;
+
+	if (!g_burst_trace) {
+		vty_out(vty, "%% Burst trace is disabled%s", VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	rc = burst_trace_dump(g_burst_trace, argv[0]);
+	if (rc < 0) {
+		vty_out(vty, "%% Failed to write '%s': %s%s", argv[0], strerror(-rc), VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	vty_out(vty, "Wrote %d records to '%s'%s", rc, argv[0], VTY_NEWLINE);
+
+	return CMD_SUCCESS;
+}
+
 /* TODO: generalize and move indention handling to libosmocore */
 #define cfg_out(vty, fmt, args...) \
 	vty_out(vty, "%*s" fmt, indent, "", ##args)
@@ -1526,6 +1799,63 @@ DEFUN(show_trx,
 }
 
 
+static void mem_usage_dump_vty(struct vty *vty, const char *name, unsigned int count, size_t size)
+{
+	vty_out(vty, "  %-28s %6u x %6zu = %10zu%s", name, count, size,
+		count * size, VTY_NEWLINE);
+}
+
+DEFUN(show_memory_usage, show_memory_usage_cmd,
+      "show memory-usage",
+      SHOW_STR "Display memory usage per object type\n")
+{
+	const struct gsm_network *net = gsmnet_from_vty(vty);
+	const struct gsm_bts *bts;
+	const struct gsm_bts_trx *trx;
+	unsigned int num_bts = 0;
+	unsigned int num_trx = 0;
+	unsigned int num_lchan_active = 0;
+	unsigned int tn, ln;
+
+	llist_for_each_entry(bts, &net->bts_list, list) {
+		num_bts++;
+		llist_for_each_entry(trx, &bts->trx_list, list) {
+			num_trx++;
+			for (tn = 0; tn < ARRAY_SIZE(trx->ts); tn++) {
+				for (ln = 0; ln < ARRAY_SIZE(trx->ts[tn].lchan); ln++) {
+					if (trx->ts[tn].lchan[ln].state != LCHAN_S_NONE)
+						num_lchan_active++;
+				}
+			}
+		}
+	}
+
+	vty_out(vty, "  %-28s %6s   %6s   %10s%s", "Object type", "count",
+		"bytes", "bytes", VTY_NEWLINE);
+	mem_usage_dump_vty(vty, "BTS", num_bts, sizeof(struct gsm_bts));
+	mem_usage_dump_vty(vty, "TRX", num_trx, sizeof(struct gsm_bts_trx));
+	mem_usage_dump_vty(vty, " Timeslot", num_trx * TRX_NR_TS,
+			   sizeof(struct gsm_bts_trx_ts));
+	mem_usage_dump_vty(vty, "  Logical channel", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(struct gsm_lchan));
+	mem_usage_dump_vty(vty, "   SACCH SI buffers", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(((struct gsm_lchan *)NULL)->si));
+	mem_usage_dump_vty(vty, "   Measurement state", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(((struct gsm_lchan *)NULL)->meas));
+	mem_usage_dump_vty(vty, "   LAPDm state", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(((struct gsm_lchan *)NULL)->lapdm_ch));
+	mem_usage_dump_vty(vty, "   TCH state", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(((struct gsm_lchan *)NULL)->tch));
+	mem_usage_dump_vty(vty, "   Power control parameters", num_trx * TRX_NR_TS * TS_MAX_LCHAN,
+			   sizeof(struct gsm_power_ctrl_params) * 2);
+	vty_out(vty, "Active logical channels: %u%s", num_lchan_active, VTY_NEWLINE);
+	vty_out(vty, "Total allocated: %zu bytes in %zu blocks%s",
+		talloc_total_size(tall_bts_ctx), talloc_total_blocks(tall_bts_ctx),
+		VTY_NEWLINE);
+
+	return CMD_SUCCESS;
+}
+
 static void ts_dump_vty(struct vty *vty, const struct gsm_bts_trx_ts *ts)
 {
 	vty_out(vty, "BTS %u, TRX %u, Timeslot %u, phys cfg %s, TSC %u",
@@ -2124,6 +2454,55 @@ DEFUN(cfg_trx_no_gsmtap_sapi, cfg_bts_no_gsmtap_sapi_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(cfg_bts_gsmtap_batching, cfg_bts_gsmtap_batching_cmd,
+	"gsmtap-batching (enable|disable)",
+	"Queue GSMTAP frames and send them once per TDMA frame\n"
+	"Queue frames, drop (and count) them if the queue is full\n"
+	"Send every frame immediately (default)\n")
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->gsmtap.batched = (strcmp(argv[0], "enable") == 0);
+	if (!bts->gsmtap.batched && bts->gsmtap.batch) {
+		gsmtap_batch_flush(bts->gsmtap.batch);
+		gsmtap_batch_free(bts->gsmtap.batch);
+		bts->gsmtap.batch = NULL;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_bts_gsmtap_sample_rate, cfg_bts_gsmtap_sample_rate_cmd,
+	"gsmtap-sample-rate <1-65535>",
+	"Send only every Nth GSMTAP frame (after SAPI/timeslot filtering)\n"
+	"Sampling rate N (default 1, i.e. send all frames)\n")
+{
+	struct gsm_bts *bts = vty->index;
+
+	bts->gsmtap.sample_rate = atoi(argv[0]);
+	bts->gsmtap.sample_cnt = 0;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_bts_gsmtap_timeslot, cfg_bts_gsmtap_timeslot_cmd,
+	"gsmtap-timeslot <0-7> (enable|disable)",
+	"Enable/disable sending of UL/DL messages of a timeslot over GSMTAP\n"
+	"Timeslot number\n"
+	"Send messages of this timeslot (default)\n"
+	"Do not send messages of this timeslot\n")
+{
+	struct gsm_bts *bts = vty->index;
+	int tn = atoi(argv[0]);
+
+	if (strcmp(argv[1], "enable") == 0)
+		bts->gsmtap.ts_mask |= (1 << tn);
+	else
+		bts->gsmtap.ts_mask &= ~(1 << tn);
+
+	return CMD_SUCCESS;
+}
+
 static struct cmd_node phy_node = {
 	PHY_NODE,
 	"%s(phy)# ",
@@ -2448,6 +2827,8 @@ int bts_vty_init(void *ctx)
 	install_element_ve(&show_lchan_cmd);
 	install_element_ve(&show_lchan_summary_cmd);
 	install_element_ve(&show_bts_gprs_cmd);
+	install_element_ve(&show_bts_latency_cmd);
+	install_element_ve(&show_memory_usage_cmd);
 
 	install_element_ve(&logging_fltr_l1_sapi_cmd);
 	install_element_ve(&no_logging_fltr_l1_sapi_cmd);
@@ -2473,6 +2854,8 @@ int bts_vty_init(void *ctx)
 	install_element(BTS_NODE, &cfg_bts_paging_lifetime_cmd);
 	install_element(BTS_NODE, &cfg_bts_agch_queue_mgmt_default_cmd);
 	install_element(BTS_NODE, &cfg_bts_agch_queue_mgmt_params_cmd);
+	install_element(BTS_NODE, &cfg_bts_agch_queue_mgmt_imm_ass_ext_cmd);
+	install_element(BTS_NODE, &cfg_bts_agch_queue_mgmt_pch_preempt_cmd);
 	install_element(BTS_NODE, &cfg_bts_ul_power_target_cmd);
 	install_element(BTS_NODE, &cfg_bts_ul_power_target_hysteresis_cmd);
 	install_element(BTS_NODE, &cfg_bts_no_ul_power_filter_cmd);
@@ -2481,6 +2864,13 @@ int bts_vty_init(void *ctx)
 	install_element(BTS_NODE, &cfg_bts_min_qual_norm_cmd);
 	install_element(BTS_NODE, &cfg_bts_max_ber_rach_cmd);
 	install_element(BTS_NODE, &cfg_bts_pcu_sock_cmd);
+	install_element(BTS_NODE, &cfg_bts_rsl_tx_coalesce_cmd);
+	install_element(BTS_NODE, &cfg_bts_rsl_tx_coalesce_window_cmd);
+	install_element(BTS_NODE, &cfg_bts_burst_trace_size_cmd);
+	install_element(BTS_NODE, &cfg_bts_burst_trace_crash_dump_cmd);
+	install_element(BTS_NODE, &cfg_bts_no_burst_trace_crash_dump_cmd);
+	install_element(BTS_NODE, &cfg_bts_overload_shedding_cmd);
+	install_element(BTS_NODE, &cfg_bts_overload_shedding_thresh_cmd);
 	install_element(BTS_NODE, &cfg_bts_supp_meas_toa256_cmd);
 	install_element(BTS_NODE, &cfg_bts_no_supp_meas_toa256_cmd);
 	install_element(BTS_NODE, &cfg_bts_smscb_max_qlen_cmd);
@@ -2492,6 +2882,9 @@ int bts_vty_init(void *ctx)
 	install_element(BTS_NODE, &cfg_bts_gsmtap_sapi_all_cmd);
 	install_element(BTS_NODE, &cfg_bts_gsmtap_sapi_cmd);
 	install_element(BTS_NODE, &cfg_bts_no_gsmtap_sapi_cmd);
+	install_element(BTS_NODE, &cfg_bts_gsmtap_batching_cmd);
+	install_element(BTS_NODE, &cfg_bts_gsmtap_sample_rate_cmd);
+	install_element(BTS_NODE, &cfg_bts_gsmtap_timeslot_cmd);
 
 	/* add and link to TRX config node */
 	install_element(BTS_NODE, &cfg_bts_trx_cmd);
@@ -2513,6 +2906,7 @@ int bts_vty_init(void *ctx)
 	install_element(ENABLE_NODE, &test_send_failure_event_report_cmd);
 	install_element(ENABLE_NODE, &radio_link_timeout_cmd);
 	install_element(ENABLE_NODE, &bts_c0_power_red_cmd);
+	install_element(ENABLE_NODE, &burst_trace_dump_cmd);
 
 	install_element(CONFIG_NODE, &cfg_phy_cmd);
 	install_node(&phy_node, config_write_phy);
@@ -46,6 +46,7 @@
 #include <osmo-bts/scheduler.h>
 #include <osmo-bts/scheduler_backend.h>
 #include <osmo-bts/pcu_if.h>
+#include <osmo-bts/probes.h>
 
 #include "l1_if.h"
 #include "trx_if.h"
@@ -268,8 +269,10 @@ static void bts_sched_fn(struct gsm_bts *bts, const uint32_t fn)
 	struct gsm_bts_trx *trx;
 	unsigned int tn;
 
-	/* Report interference measurements */
-	if (fn % 104 == 0) /* SACCH period */
+	BTS_PROBE1(sched_fn_entry, fn);
+
+	/* Report interference measurements, unless shed due to overload */
+	if (fn % 104 == 0 && bts->ovld.level < BTS_OVLD_L_INTERF) /* SACCH period */
 		bts_report_interf_meas(bts, fn);
 
 	/* send time indication */
@@ -320,6 +323,8 @@ static void bts_sched_fn(struct gsm_bts *bts, const uint32_t fn)
 
 	/* Send everything to the PHY */
 	bts_sched_flush_buffers(bts);
+
+	BTS_PROBE1(sched_fn_return, fn);
 }
 
 /* Find a route (TRX instance) for a given Uplink burst indication */
@@ -402,9 +407,9 @@ static int trx_fn_timer_cb(struct osmo_fd *ofd, unsigned int what)
 	struct gsm_bts *bts = ofd->data;
 	struct bts_trx_priv *bts_trx = (struct bts_trx_priv *)bts->model_priv;
 	struct osmo_trx_clock_state *tcs = &bts_trx->clk_s;
-	struct timespec tv_now;
+	struct timespec tv_now, tv_done;
 	uint64_t expire_count;
-	int64_t elapsed_us, error_us;
+	int64_t elapsed_us, error_us, proc_us;
 	int rc, i;
 
 	if (!(what & OSMO_FD_READ))
@@ -449,6 +454,16 @@ static int trx_fn_timer_cb(struct osmo_fd *ofd, unsigned int what)
 	for (i = 0; i < expire_count; i++)
 		bts_sched_fn(bts, GSM_TDMA_FN_INC(tcs->last_fn_timer.fn));
 
+	/* processing time of this frame, counted from when the timer should
+	 * have fired, i.e. including the time we were busy with other work */
+	if (bts->ovld.enabled) {
+		clock_gettime(CLOCK_MONOTONIC, &tv_done);
+		proc_us = compute_elapsed_us(&tv_now, &tv_done);
+		if (error_us > 0)
+			proc_us += error_us;
+		bts_ovld_fn(bts, proc_us, expire_count - 1);
+	}
+
 	return 0;
 
 no_clock:
@@ -499,6 +514,7 @@ int trx_sched_clock_stopped(struct gsm_bts *bts)
 
 	LOGP(DL1C, LOGL_NOTICE, "GSM clock stopped\n");
 	osmo_fd_close(&tcs->fn_timer_ofd);
+	bts_ovld_reset(bts);
 
 	return 0;
 }
@@ -612,85 +628,3 @@ void _sched_act_rach_det(struct gsm_bts_trx *trx, uint8_t tn, uint8_t ss, int ac
 	else
 		trx_if_cmd_nohandover(l1h, tn, ss);
 }
-
-/* Add a set of UL burst measurements to the history */
-void trx_sched_meas_push(struct l1sched_chan_state *chan_state,
-			 const struct trx_ul_burst_ind *bi)
-{
-	unsigned int hist_size = ARRAY_SIZE(chan_state->meas.buf);
-	unsigned int current = chan_state->meas.current;
-
-	chan_state->meas.buf[current] = (struct l1sched_meas_set) {
-		.ci_cb = (bi->flags & TRX_BI_F_CI_CB) ? bi->ci_cb : 0,
-		.toa256 = bi->toa256,
-		.rssi = bi->rssi,
-	};
-
-	chan_state->meas.current = (current + 1) % hist_size;
-}
-
-/* Calculate the AVG of n measurements from the history */
-void trx_sched_meas_avg(const struct l1sched_chan_state *chan_state,
-			struct l1sched_meas_set *avg,
-			enum sched_meas_avg_mode mode)
-{
-	unsigned int hist_size = ARRAY_SIZE(chan_state->meas.buf);
-	unsigned int current = chan_state->meas.current;
-	const struct l1sched_meas_set *set;
-	unsigned int shift, pos, i, n;
-
-	float rssi_sum = 0;
-	int toa256_sum = 0;
-	int ci_cb_sum = 0;
-
-	switch (mode) {
-	/* last 4 bursts (default for xCCH, TCH/H, PTCCH and PDTCH) */
-	case SCHED_MEAS_AVG_M_QUAD:
-		n = 4; shift = n;
-		break;
-	/* last 8 bursts (default for TCH/F and FACCH/F) */
-	case SCHED_MEAS_AVG_M_OCTO:
-		n = 8; shift = n;
-		break;
-	/* last 6 bursts (default for FACCH/H) */
-	case SCHED_MEAS_AVG_M_SIX:
-		n = 6; shift = n;
-		break;
-	/* first 4 of last 8 bursts */
-	case SCHED_MEAS_AVG_M8_FIRST_QUAD:
-		n = 4; shift = 8;
-		break;
-	/* first 2 of last 6 bursts */
-	case SCHED_MEAS_AVG_M6_FIRST_TWO:
-		n = 2; shift = 6;
-		break;
-	/* middle 2 of last 6 bursts */
-	case SCHED_MEAS_AVG_M6_MIDDLE_TWO:
-		n = 2; shift = 4;
-		break;
-	default:
-		/* Shall not happen */
-		OSMO_ASSERT(false);
-	}
-
-	/* Calculate the sum of n entries starting from pos */
-	for (i = 0; i < n; i++) {
-		pos = (current + hist_size - shift + i) % hist_size;
-		set = &chan_state->meas.buf[pos];
-
-		rssi_sum   += set->rssi;
-		toa256_sum += set->toa256;
-		ci_cb_sum  += set->ci_cb;
-	}
-
-	/* Calculate the average for each value */
-	*avg = (struct l1sched_meas_set) {
-		.rssi   = (rssi_sum   / n),
-		.toa256 = (toa256_sum / n),
-		.ci_cb  = (ci_cb_sum  / n),
-	};
-
-	LOGP(DMEAS, LOGL_DEBUG, "Measurement AVG (num=%u, shift=%u): "
-	     "RSSI %f, ToA256 %d, C/I %d cB\n", n, shift,
-	     avg->rssi, avg->toa256, avg->ci_cb);
-}
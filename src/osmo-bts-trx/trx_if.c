@@ -46,6 +46,8 @@
 #include <osmo-bts/logging.h>
 #include <osmo-bts/bts.h>
 #include <osmo-bts/scheduler.h>
+#include <osmo-bts/burst_trace.h>
+#include <osmo-bts/probes.h>
 
 #include "l1_if.h"
 #include "trx_if.h"
@@ -993,6 +995,7 @@ static int trx_data_read_cb(struct osmo_fd *ofd, unsigned int what)
 	struct trx_l1h *l1h = ofd->data;
 	struct trx_ul_burst_ind bi;
 	ssize_t hdr_len, buf_len;
+	uint32_t rx_ts_us;
 	uint8_t pdu_ver;
 
 	buf_len = recv(ofd->fd, trx_data_buf, sizeof(trx_data_buf), 0);
@@ -1003,6 +1006,7 @@ static int trx_data_read_cb(struct osmo_fd *ofd, unsigned int what)
 			buf_len, trx_data_buf);
 		return buf_len;
 	}
+	rx_ts_us = bts_lat_now_us();
 
 	/* Parse PDU version first */
 	pdu_ver = buf[0] >> 4;
@@ -1082,8 +1086,15 @@ static int trx_data_read_cb(struct osmo_fd *ofd, unsigned int what)
 		/* Number of processed PDUs */
 		bi._num_pdus++;
 
+		burst_trace(BURST_TRACE_EV_TRXD_RX, l1h->phy_inst->trx->nr, bi.fn, bi.tn, 0xff,
+			    bi.rssi, bi.toa256, (bi.flags & TRX_BI_F_CI_CB) ? bi.ci_cb : 0,
+			    bi.flags, bi.burst_len);
+		BTS_PROBE5(trxd_pdu, l1h->phy_inst->trx->nr, bi.fn, bi.tn, pdu_ver, bi.burst_len);
+
 		/* feed received burst into scheduler code */
+		bts_ul_lat_set_rx(rx_ts_us);
 		trx_sched_route_burst_ind(l1h->phy_inst->trx, &bi);
+		bts_ul_lat_set_rx(0);
 	} while (bi.flags & TRX_BI_F_BATCH_IND);
 
 	return 0;
@@ -0,0 +1,982 @@
+/* Synthetic load generator for osmo-bts-trx, acting as a fake transceiver */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* osmo-trx-loadgen speaks the TRXC/TRXD protocol (PDU versions 0..2) of
+ * trx_if.c from the transceiver side: it emits CLOCK indications, answers
+ * the commands sent by the provisioning FSM, and sends uplink bursts for N
+ * simulated MS on TCH/F, TCH/H, SDCCH and PDTCH.  The bursts are encoded
+ * with libosmocoding and follow the multiframe layout of the scheduler, so
+ * that osmo-bts-trx decodes them like the bursts of real phones once the
+ * BSC activated the logical channels.
+ *
+ * The downlink bursts are consumed and their timeliness is measured: the
+ * advance of each burst is its TDMA frame number minus the frame number of
+ * the fake transceiver's clock when the burst was received.  Bursts with
+ * an advance <= 0 arrived too late to be transmitted. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/bits.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/socket.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/application.h>
+#include <osmocom/gsm/gsm_utils.h>
+#include <osmocom/codec/codec.h>
+#include <osmocom/coding/gsm0503_coding.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/scheduler.h>
+
+#define LG_MAX_TRX		8
+#define LG_TRXC_BUF_SIZE	1500
+#define LG_TRXD_BUF_SIZE	2048
+/* osmo-trx sends a CLOCK indication about every 0.5 s */
+#define LG_CLOCK_IND_INTERVAL	102
+/* DL advance histogram: <= 0 (late), 1, ..., LG_ADV_HIST_MAX - 1, more */
+#define LG_ADV_HIST_MAX		16
+
+/* values of SETSLOT, see transceiver_chan_types[] in l1_if.c */
+static const struct {
+	uint8_t type;
+	enum gsm_phys_chan_config pchan;
+} lg_slot_types[] = {
+	{ 1,	GSM_PCHAN_TCH_F },
+	{ 3,	GSM_PCHAN_TCH_H },
+	{ 4,	GSM_PCHAN_CCCH },
+	{ 5,	GSM_PCHAN_CCCH_SDCCH4 },
+	{ 7,	GSM_PCHAN_SDCCH8_SACCH8C },
+	{ 13,	GSM_PCHAN_PDCH },
+};
+
+/* Training Sequences for Normal Burst, TSC set 1 (3GPP TS 45.002, table 5.2.3a) */
+static const ubit_t lg_tsc[8][26] = {
+	{ 0,0,1,0,0,1,0,1,1,1,0,0,0,0,1,0,0,0,1,0,0,1,0,1,1,1 },
+	{ 0,0,1,0,1,1,0,1,1,1,0,1,1,1,1,0,0,0,1,0,1,1,0,1,1,1 },
+	{ 0,1,0,0,0,0,1,1,1,0,1,1,1,0,1,0,0,1,0,0,0,0,1,1,1,0 },
+	{ 0,1,0,0,0,1,1,1,1,0,1,1,0,1,0,0,0,1,0,0,0,1,1,1,1,0 },
+	{ 0,0,0,1,1,0,1,0,1,1,1,0,0,1,0,0,0,0,0,1,1,0,1,0,1,1 },
+	{ 0,1,0,0,1,1,1,0,1,0,1,1,0,0,0,0,0,1,0,0,1,1,1,0,1,0 },
+	{ 1,0,1,0,0,1,1,1,1,1,0,1,1,0,0,0,1,0,1,0,0,1,1,1,1,1 },
+	{ 1,1,1,0,1,1,1,1,0,0,0,1,0,0,1,0,1,1,1,0,1,1,1,1,0,0 },
+};
+
+/* Uplink payloads: LAPDm fill frames, a silence FR frame, an empty HR frame
+ * and a dummy RLC/MAC block (CS-1) */
+static const uint8_t lg_sdcch_l2[GSM_MACBLOCK_LEN] = {
+	0x01, 0x03, 0x01, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+	0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+};
+static const uint8_t lg_sacch_l2[GSM_MACBLOCK_LEN] = {
+	0x05, 0x00, /* L1 SACCH header: MS power level, timing advance */
+	0x01, 0x03, 0x01, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+	0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+};
+static const uint8_t lg_fr_frame[GSM_FR_BYTES] = { 0xd0 };
+static const uint8_t lg_hr_frame[GSM_HR_BYTES] = { 0x00 };
+static const uint8_t lg_pdtch_block[GSM_MACBLOCK_LEN] = { 0x40 };
+
+/* A simulated MS, occupying one dedicated channel (and its SACCH) */
+struct lg_ms {
+	enum trx_chan_type chan;
+	enum trx_chan_type sacch;	/* TRXC_IDLE for PDTCH */
+	ubit_t tch_bursts[928];		/* TCH interleaving buffer */
+	ubit_t xcch_bursts[464];	/* SDCCH or PDTCH block */
+	ubit_t sacch_bursts[464];
+};
+
+struct lg_ts {
+	int mf_idx;			/* index in trx_sched_multiframes[], -1: off */
+	struct lg_ms *ms[8];
+	unsigned int num_ms;
+};
+
+struct lg_stats {
+	uint64_t ul_bursts;
+	uint64_t ul_nope;
+	uint64_t dl_bursts;
+	uint64_t dl_late;
+	int64_t dl_adv_sum;
+	int dl_adv_min;
+	int dl_adv_max;
+	uint64_t dl_adv_hist[LG_ADV_HIST_MAX + 1];
+};
+
+struct lg_trx {
+	unsigned int num;
+	struct osmo_fd ctrl_ofd;
+	struct osmo_fd data_ofd;
+	bool powered;
+	uint8_t tsc;
+	uint8_t pdu_ver;
+	struct lg_ts ts[8];
+	struct lg_stats stats;
+};
+
+static struct {
+	const char *local_ip;
+	const char *remote_ip;
+	uint16_t base_port;		/* transceiver side */
+	uint16_t bts_base_port;		/* osmo-bts-trx side */
+	unsigned int num_trx;
+	unsigned int num_ms;
+	uint8_t pdu_ver_max;
+	unsigned int duration;		/* seconds, 0: forever */
+	unsigned int report_interval;	/* seconds */
+	bool self_test;
+} cfg = {
+	.local_ip = "127.0.0.1",
+	.remote_ip = "127.0.0.1",
+	.base_port = 5700,
+	.bts_base_port = 5800,
+	.num_trx = 1,
+	.num_ms = 8,
+	.pdu_ver_max = 2,
+	.report_interval = 10,
+};
+
+static void *tall_lg_ctx;
+static struct lg_trx lg_trx[LG_MAX_TRX];
+static unsigned int lg_num_ms;
+static struct osmo_fd lg_clk_ofd;
+static struct osmo_fd lg_fn_timer_ofd;
+static uint64_t lg_start_ns;
+static uint64_t lg_frames;
+static uint32_t lg_fn;
+static struct osmo_timer_list lg_report_timer;
+static int lg_quit;
+
+/* scheduler_mframe.c is only linked for its tables */
+enum gsm_phys_chan_config ts_pchan(const struct gsm_bts_trx_ts *ts)
+{
+	return GSM_PCHAN_NONE;
+}
+
+static uint64_t lg_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Simulated MS
+ */
+
+static void lg_ts_release(struct lg_ts *ts)
+{
+	unsigned int i;
+
+	for (i = 0; i < ts->num_ms; i++)
+		talloc_free(ts->ms[i]);
+	lg_num_ms -= ts->num_ms;
+	ts->num_ms = 0;
+	ts->mf_idx = -1;
+}
+
+static void lg_ts_add_ms(struct lg_ts *ts, enum trx_chan_type chan, enum trx_chan_type sacch)
+{
+	struct lg_ms *ms;
+
+	if (lg_num_ms >= cfg.num_ms || ts->num_ms >= ARRAY_SIZE(ts->ms))
+		return;
+
+	ms = talloc_zero(tall_lg_ctx, struct lg_ms);
+	ms->chan = chan;
+	ms->sacch = sacch;
+	ts->ms[ts->num_ms++] = ms;
+	lg_num_ms++;
+}
+
+/* Configure a timeslot (SETSLOT) and place simulated MS on it */
+static void lg_ts_setslot(struct lg_ts *ts, unsigned int tn, uint8_t type)
+{
+	enum gsm_phys_chan_config pchan = GSM_PCHAN_NONE;
+	unsigned int i;
+
+	lg_ts_release(ts);
+
+	for (i = 0; i < ARRAY_SIZE(lg_slot_types); i++) {
+		if (lg_slot_types[i].type == type)
+			pchan = lg_slot_types[i].pchan;
+	}
+	if (pchan == GSM_PCHAN_NONE)
+		return;
+
+	ts->mf_idx = find_sched_mframe_idx(pchan, tn);
+
+	switch (pchan) {
+	case GSM_PCHAN_TCH_F:
+		lg_ts_add_ms(ts, TRXC_TCHF, TRXC_SACCHTF);
+		break;
+	case GSM_PCHAN_TCH_H:
+		for (i = 0; i < 2; i++)
+			lg_ts_add_ms(ts, TRXC_TCHH_0 + i, TRXC_SACCHTH_0 + i);
+		break;
+	case GSM_PCHAN_CCCH_SDCCH4:
+		for (i = 0; i < 4; i++)
+			lg_ts_add_ms(ts, TRXC_SDCCH4_0 + i, TRXC_SACCH4_0 + i);
+		break;
+	case GSM_PCHAN_SDCCH8_SACCH8C:
+		for (i = 0; i < 8; i++)
+			lg_ts_add_ms(ts, TRXC_SDCCH8_0 + i, TRXC_SACCH8_0 + i);
+		break;
+	case GSM_PCHAN_PDCH:
+		lg_ts_add_ms(ts, TRXC_PDTCH, TRXC_IDLE);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Get the 116 coded bits of the given UL burst of a simulated MS,
+ * encoding the next block at the first burst (bid 0) */
+static const ubit_t *lg_ms_burst(struct lg_ms *ms, enum trx_chan_type chan, uint8_t bid)
+{
+	ubit_t *bursts = ms->tch_bursts;
+
+	if (chan == ms->sacch) {
+		if (bid == 0)
+			gsm0503_xcch_encode(ms->sacch_bursts, lg_sacch_l2);
+		return ms->sacch_bursts + bid * 116;
+	}
+
+	switch (chan) {
+	case TRXC_TCHF:
+		/* block diagonal interleaving over 8 bursts, shift by 4 */
+		if (bid == 0) {
+			memcpy(bursts, bursts + 464, 464);
+			memset(bursts + 464, 0, 464);
+			gsm0503_tch_fr_encode(bursts, lg_fr_frame, sizeof(lg_fr_frame), 1);
+		}
+		return bursts + bid * 116;
+	case TRXC_TCHH_0:
+	case TRXC_TCHH_1:
+		/* interleaving over 4 bursts, shift by 2 */
+		if (bid == 0) {
+			memcpy(bursts, bursts + 232, 232);
+			memset(bursts + 232, 0, 232);
+			gsm0503_tch_hr_encode(bursts, lg_hr_frame, sizeof(lg_hr_frame));
+		}
+		return bursts + bid * 116;
+	case TRXC_PDTCH:
+		if (bid == 0)
+			gsm0503_pdtch_encode(ms->xcch_bursts, lg_pdtch_block, sizeof(lg_pdtch_block));
+		return ms->xcch_bursts + bid * 116;
+	default: /* SDCCH */
+		if (bid == 0)
+			gsm0503_xcch_encode(ms->xcch_bursts, lg_sdcch_l2);
+		return ms->xcch_bursts + bid * 116;
+	}
+}
+
+/*
+ * TRXD: uplink bursts
+ */
+
+/* Write one UL PDU (header and soft-bits) for the given timeslot.
+ * Returns the number of bytes written. */
+static unsigned int lg_ul_pdu(struct lg_trx *trx, uint8_t tn, uint8_t *buf, bool first, bool batch)
+{
+	const struct lg_ts *ts = &trx->ts[tn];
+	const struct trx_sched_multiframe *mf = &trx_sched_multiframes[ts->mf_idx];
+	const struct trx_sched_frame *frame = &mf->frames[lg_fn % mf->period];
+	const ubit_t *coded = NULL;
+	uint8_t *p = buf;
+	ubit_t burst[GSM_BURST_LEN] = { 0 };
+	uint8_t mts;
+	unsigned int i;
+
+	for (i = 0; i < ts->num_ms; i++) {
+		struct lg_ms *ms = ts->ms[i];
+
+		if (frame->ul_chan != TRXC_IDLE
+		    && (frame->ul_chan == ms->chan || frame->ul_chan == ms->sacch)) {
+			coded = lg_ms_burst(ms, frame->ul_chan, frame->ul_bid);
+			break;
+		}
+	}
+
+	/* NOPE.ind if there is nothing to send, TRXDv0 has no way to say so */
+	if (!coded && trx->pdu_ver == 0)
+		return 0;
+	mts = coded ? (trx->tsc & 0x07) : 0x80;
+
+	switch (trx->pdu_ver) {
+	case 0:
+	case 1:
+		*p++ = (trx->pdu_ver << 4) | tn;
+		osmo_store32be(lg_fn, p); p += 4;
+		*p++ = 60;			/* RSSI: -60 dBm */
+		osmo_store16be(0, p); p += 2;	/* ToA256 */
+		if (trx->pdu_ver == 1) {
+			*p++ = mts;
+			osmo_store16be(100, p); p += 2; /* C/I: 10 dB */
+		}
+		break;
+	default:
+		*p++ = (first ? (trx->pdu_ver << 4) : 0) | tn;
+		*p++ = (batch ? (1 << 7) : 0) | (trx->num & 0x3f);
+		*p++ = mts;
+		*p++ = 60;
+		osmo_store16be(0, p); p += 2;
+		osmo_store16be(100, p); p += 2;
+		if (first) {
+			osmo_store32be(lg_fn, p); p += 4;
+		}
+		break;
+	}
+
+	if (!coded) {
+		trx->stats.ul_nope++;
+		return p - buf;
+	}
+
+	/* normal burst: 3 tail, 58 coded, 26 training, 58 coded, 3 tail */
+	memcpy(burst + 3, coded, 58);
+	memcpy(burst + 61, lg_tsc[trx->tsc & 0x07], 26);
+	memcpy(burst + 87, coded + 58, 58);
+
+	/* soft-bits as sent by osmo-trx: 0 is a certain '0', 254 a certain '1' */
+	for (i = 0; i < GSM_BURST_LEN; i++)
+		*p++ = burst[i] ? 254 : 0;
+
+	trx->stats.ul_bursts++;
+	return p - buf;
+}
+
+/* Send the UL bursts of the current frame, batched for TRXDv2 */
+static void lg_trx_send_ul(struct lg_trx *trx)
+{
+	uint8_t buf[LG_TRXD_BUF_SIZE];
+	uint8_t tns[8];
+	unsigned int num = 0, len = 0, i;
+
+	for (i = 0; i < ARRAY_SIZE(trx->ts); i++) {
+		if (trx->ts[i].mf_idx >= 0)
+			tns[num++] = i;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (trx->pdu_ver < 2) {
+			len = lg_ul_pdu(trx, tns[i], buf, true, false);
+			if (len > 0)
+				send(trx->data_ofd.fd, buf, len, 0);
+			continue;
+		}
+		len += lg_ul_pdu(trx, tns[i], buf + len, i == 0, i + 1 < num);
+	}
+
+	if (trx->pdu_ver >= 2 && len > 0)
+		send(trx->data_ofd.fd, buf, len, 0);
+}
+
+/*
+ * TRXD: downlink bursts
+ */
+
+static void lg_dl_account(struct lg_trx *trx, uint32_t fn)
+{
+	struct lg_stats *st = &trx->stats;
+	int adv = GSM_TDMA_FN_SUB(fn, lg_fn);
+
+	/* bursts from the past wrap around to large advances */
+	if (adv > GSM_TDMA_HYPERFRAME / 2)
+		adv -= GSM_TDMA_HYPERFRAME;
+
+	if (st->dl_bursts == 0 || adv < st->dl_adv_min)
+		st->dl_adv_min = adv;
+	if (st->dl_bursts == 0 || adv > st->dl_adv_max)
+		st->dl_adv_max = adv;
+	st->dl_bursts++;
+	st->dl_adv_sum += adv;
+
+	if (adv <= 0) {
+		st->dl_late++;
+		st->dl_adv_hist[0]++;
+	} else {
+		st->dl_adv_hist[OSMO_MIN(adv, LG_ADV_HIST_MAX)]++;
+	}
+}
+
+/* Length of the burst following a DL TRXDv2 header with the given MTS */
+static size_t lg_dl_burst_len(uint8_t mts)
+{
+	if (mts & (1 << 7))
+		return 0;			/* NOPE.req */
+	if ((mts & 0x70) == 0x20)
+		return 3 * GSM_BURST_LEN;	/* 8-PSK: .010x... */
+	if ((mts & 0x60) == 0x60)
+		return 2 * GSM_BURST_LEN;	/* AQPSK: .11xx..., two subchannels */
+	return GSM_BURST_LEN;			/* GMSK: .00xx... */
+}
+
+/* Account the DL bursts of a TRXD message.
+ * Returns the number of bursts, -EINVAL if the message is truncated. */
+static int lg_dl_parse(struct lg_trx *trx, const uint8_t *buf, size_t len)
+{
+	const uint8_t *p = buf;
+	uint32_t fn = 0;
+	bool batch;
+	int num = 0;
+
+	if (len < 1)
+		return -EINVAL;
+
+	if ((buf[0] >> 4) < 2) {
+		/* TN, FN, attenuation, hard-bits */
+		if (len < 6)
+			return -EINVAL;
+		lg_dl_account(trx, osmo_load32be(buf + 1));
+		return 1;
+	}
+
+	/* TRXDv2: TN, TRXN, MTS, attenuation, SCPIR, spare, (FN), hard-bits */
+	do {
+		size_t hdr_len = (p == buf) ? 12 : 8;
+		size_t burst_len;
+
+		if (buf + len - p < hdr_len)
+			return -EINVAL;
+		batch = p[1] & (1 << 7);
+		if (p == buf)
+			fn = osmo_load32be(p + 8);
+		burst_len = lg_dl_burst_len(p[2]);
+		if (buf + len - p < hdr_len + burst_len)
+			return -EINVAL;
+		p += hdr_len + burst_len;
+		if (burst_len) {
+			lg_dl_account(trx, fn);
+			num++;
+		}
+	} while (batch && p < buf + len);
+
+	return num;
+}
+
+static int lg_data_read_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct lg_trx *trx = ofd->data;
+	uint8_t buf[LG_TRXD_BUF_SIZE];
+	ssize_t len;
+
+	len = recv(ofd->fd, buf, sizeof(buf), 0);
+	if (len <= 0)
+		return 0;
+
+	lg_dl_parse(trx, buf, len);
+	return 0;
+}
+
+/*
+ * TRXC
+ */
+
+static void lg_ctrl_send(struct lg_trx *trx, const char *cmd, int status, const char *params)
+{
+	char buf[LG_TRXC_BUF_SIZE];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "RSP %s %d%s%s", cmd, status,
+		       params[0] ? " " : "", params);
+	if (len >= sizeof(buf))
+		return;
+	send(trx->ctrl_ofd.fd, buf, len + 1, 0);
+}
+
+static void lg_clock_send(void)
+{
+	char buf[32];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "IND CLOCK %u", lg_fn);
+	send(lg_clk_ofd.fd, buf, len + 1, 0);
+}
+
+static int lg_ctrl_read_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct lg_trx *trx = ofd->data;
+	char buf[LG_TRXC_BUF_SIZE];
+	char rsp_params[LG_TRXC_BUF_SIZE];
+	char *cmd, *params;
+	unsigned int tn, type, ver;
+	ssize_t len;
+	int status = 0;
+
+	len = recv(ofd->fd, buf, sizeof(buf) - 1, 0);
+	if (len <= 0)
+		return 0;
+	buf[len] = '\0';
+
+	if (strncmp(buf, "CMD ", 4))
+		return 0;
+	cmd = buf + 4;
+	params = strchr(cmd, ' ');
+	if (params)
+		*params++ = '\0';
+	else
+		params = cmd + strlen(cmd);
+
+	/* by default, responses echo the parameters of the command */
+	OSMO_STRLCPY_ARRAY(rsp_params, params);
+
+	if (!strcmp(cmd, "POWERON")) {
+		trx->powered = true;
+		lg_clock_send();
+	} else if (!strcmp(cmd, "POWEROFF")) {
+		trx->powered = false;
+	} else if (!strcmp(cmd, "SETFORMAT")) {
+		/* status is the version to use, params the requested one */
+		if (sscanf(params, "%u", &ver) == 1) {
+			trx->pdu_ver = OSMO_MIN(ver, cfg.pdu_ver_max);
+			status = trx->pdu_ver;
+		}
+	} else if (!strcmp(cmd, "SETTSC")) {
+		trx->tsc = atoi(params) & 0x07;
+	} else if (!strcmp(cmd, "SETBSIC")) {
+		trx->tsc = atoi(params) & 0x07;
+	} else if (!strcmp(cmd, "NOMTXPOWER")) {
+		snprintf(rsp_params, sizeof(rsp_params), "%d", 50);
+	} else if (!strcmp(cmd, "SETSLOT")) {
+		if (sscanf(params, "%u %u", &tn, &type) == 2 && tn < ARRAY_SIZE(trx->ts))
+			lg_ts_setslot(&trx->ts[tn], tn, type);
+		else
+			status = 1;
+	}
+	/* everything else (tuning, gain, power, delays, handover, RF mute) is acknowledged */
+
+	lg_ctrl_send(trx, cmd, status, rsp_params);
+
+	return 0;
+}
+
+/*
+ * Frame clock
+ */
+
+static int lg_fn_timer_arm(void)
+{
+	uint64_t deadline_ns = lg_start_ns + (lg_frames + 1) * 120000000 / 26;
+	const struct itimerspec its = {
+		.it_value = {
+			.tv_sec = deadline_ns / 1000000000,
+			.tv_nsec = deadline_ns % 1000000000,
+		},
+	};
+
+	return timerfd_settime(lg_fn_timer_ofd.fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static int lg_fn_timer_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	uint64_t expire_count, due;
+	unsigned int i;
+
+	if (read(ofd->fd, &expire_count, sizeof(expire_count)) < 0)
+		return 0;
+
+	/* like a radio, the clock does not wait: skip the frames we missed */
+	due = (lg_now_ns() - lg_start_ns) * 26 / 120000000 - lg_frames;
+	lg_frames += due;
+	lg_fn = GSM_TDMA_FN_SUM(lg_fn, due);
+
+	if (lg_frames % LG_CLOCK_IND_INTERVAL < due)
+		lg_clock_send();
+
+	for (i = 0; i < cfg.num_trx; i++) {
+		if (lg_trx[i].powered)
+			lg_trx_send_ul(&lg_trx[i]);
+	}
+
+	lg_fn_timer_arm();
+	return 0;
+}
+
+/*
+ * Reports
+ */
+
+static void lg_report(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < cfg.num_trx; i++) {
+		const struct lg_stats *st = &lg_trx[i].stats;
+
+		printf("TRX%u: UL %"PRIu64" bursts, %"PRIu64" NOPE; DL %"PRIu64" bursts, "
+		       "%"PRIu64" late", i, st->ul_bursts, st->ul_nope, st->dl_bursts, st->dl_late);
+		if (st->dl_bursts) {
+			printf(", advance min/avg/max %d/%.2f/%d frames\n      advance histogram:",
+			       st->dl_adv_min, (double) st->dl_adv_sum / st->dl_bursts, st->dl_adv_max);
+			for (j = 0; j <= LG_ADV_HIST_MAX; j++) {
+				if (st->dl_adv_hist[j])
+					printf(" %s%u:%"PRIu64, j == 0 ? "<=" : (j == LG_ADV_HIST_MAX ? ">=" : ""),
+					       j, st->dl_adv_hist[j]);
+			}
+		}
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+static void lg_report_timer_cb(void *data)
+{
+	lg_report();
+	osmo_timer_schedule(&lg_report_timer, cfg.report_interval, 0);
+}
+
+static void signal_handler(int signum)
+{
+	switch (signum) {
+	case SIGINT:
+	case SIGTERM:
+	case SIGALRM:
+		lg_quit = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Self-test of the TRXD encoding and decoding
+ */
+
+static unsigned int lg_test_failed;
+
+#define LG_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			lg_test_failed++; \
+		} \
+	} while (0)
+
+static void lg_self_test_ul(struct lg_trx *trx, uint8_t pdu_ver)
+{
+	uint8_t buf[LG_TRXD_BUF_SIZE];
+	unsigned int len;
+
+	trx->pdu_ver = pdu_ver;
+
+	/* TN 1 carries a TCH/F, the first frame has a burst */
+	lg_fn = 0;
+	len = lg_ul_pdu(trx, 1, buf, true, false);
+	switch (pdu_ver) {
+	case 0:
+		LG_CHECK(len == 8 + GSM_BURST_LEN);
+		LG_CHECK(buf[0] == 0x01);
+		LG_CHECK(osmo_load32be(buf + 1) == lg_fn);
+		break;
+	case 1:
+		LG_CHECK(len == 11 + GSM_BURST_LEN);
+		LG_CHECK(buf[0] == 0x11);
+		LG_CHECK(buf[8] == trx->tsc);
+		break;
+	default:
+		LG_CHECK(len == 12 + GSM_BURST_LEN);
+		LG_CHECK(buf[0] == 0x21);
+		LG_CHECK(buf[1] == trx->num);
+		LG_CHECK(buf[2] == trx->tsc);
+		LG_CHECK(osmo_load32be(buf + 8) == lg_fn);
+		break;
+	}
+	LG_CHECK(buf[len - 1] == 0 || buf[len - 1] == 254);
+
+	/* TN 0 carries a CCCH without MS, nothing to send */
+	len = lg_ul_pdu(trx, 0, buf, false, true);
+	switch (pdu_ver) {
+	case 0:
+		LG_CHECK(len == 0);
+		break;
+	case 1:
+		LG_CHECK(len == 11);
+		LG_CHECK(buf[8] == 0x80);
+		break;
+	default:
+		LG_CHECK(len == 8);
+		LG_CHECK(buf[0] == 0x00);
+		LG_CHECK(buf[1] == ((1 << 7) | trx->num));
+		LG_CHECK(buf[2] == 0x80);
+		break;
+	}
+}
+
+static void lg_self_test_dl(struct lg_trx *trx)
+{
+	/* MTS, burst length: 8-PSK, AQPSK, NOPE.req, GMSK */
+	static const struct {
+		uint8_t mts;
+		size_t burst_len;
+	} pdus[] = {
+		{ 0x2d, 3 * GSM_BURST_LEN },
+		{ 0x65, 2 * GSM_BURST_LEN },
+		{ 0x80, 0 },
+		{ 0x1d, GSM_BURST_LEN },
+	};
+	uint8_t buf[LG_TRXD_BUF_SIZE];
+	uint8_t *p = buf;
+	unsigned int i;
+
+	LG_CHECK(lg_dl_burst_len(0x00) == GSM_BURST_LEN);
+	LG_CHECK(lg_dl_burst_len(0x20) == 3 * GSM_BURST_LEN);
+	LG_CHECK(lg_dl_burst_len(0x28) == 3 * GSM_BURST_LEN);
+	LG_CHECK(lg_dl_burst_len(0x60) == 2 * GSM_BURST_LEN);
+	LG_CHECK(lg_dl_burst_len(0x78) == 2 * GSM_BURST_LEN);
+	LG_CHECK(lg_dl_burst_len(0x85) == 0);
+
+	/* a batch of TRXDv2 PDUs as sent by trx_if.c */
+	memset(buf, 0, sizeof(buf));
+	for (i = 0; i < ARRAY_SIZE(pdus); i++) {
+		p[0] = i == 0 ? (0x20 | i) : i;
+		p[1] = (i + 1 < ARRAY_SIZE(pdus) ? (1 << 7) : 0) | trx->num;
+		p[2] = pdus[i].mts;
+		p += 8;
+		if (i == 0) {
+			osmo_store32be(lg_fn + 2, p);
+			p += 4;
+		}
+		p += pdus[i].burst_len;
+	}
+
+	LG_CHECK(lg_dl_parse(trx, buf, p - buf) == 3);
+	LG_CHECK(trx->stats.dl_bursts == 3);
+	LG_CHECK(trx->stats.dl_adv_min == 2 && trx->stats.dl_adv_max == 2);
+	LG_CHECK(lg_dl_parse(trx, buf, p - buf - 1) == -EINVAL);
+
+	/* TRXDv0 */
+	buf[0] = 0x03;
+	osmo_store32be(lg_fn, buf + 1);
+	LG_CHECK(lg_dl_parse(trx, buf, 6 + GSM_BURST_LEN) == 1);
+	LG_CHECK(trx->stats.dl_late == 1);
+}
+
+/* Check the TRXD PDUs against the formats of trx_if.c.
+ * Returns the number of failed checks. */
+static unsigned int lg_self_test(void)
+{
+	struct lg_trx *trx = &lg_trx[0];
+	uint8_t pdu_ver;
+	unsigned int tn;
+
+	memset(trx, 0, sizeof(*trx));
+	for (tn = 0; tn < ARRAY_SIZE(trx->ts); tn++)
+		trx->ts[tn].mf_idx = -1;
+	trx->tsc = 5;
+	lg_ts_setslot(&trx->ts[0], 0, 4);
+	lg_ts_setslot(&trx->ts[1], 1, 1);
+
+	for (pdu_ver = 0; pdu_ver <= 2; pdu_ver++)
+		lg_self_test_ul(trx, pdu_ver);
+	lg_self_test_dl(trx);
+
+	for (tn = 0; tn < ARRAY_SIZE(trx->ts); tn++)
+		lg_ts_release(&trx->ts[tn]);
+
+	printf("Self-test %s\n", lg_test_failed ? "failed" : "passed");
+	return lg_test_failed;
+}
+
+/*
+ * Setup
+ */
+
+static int lg_udp_open(struct osmo_fd *ofd, uint16_t offset, int (*cb)(struct osmo_fd *, unsigned int),
+		       void *data)
+{
+	osmo_fd_setup(ofd, -1, OSMO_FD_READ, cb, data, 0);
+	return osmo_sock_init2_ofd(ofd, AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP,
+				   cfg.local_ip, cfg.base_port + offset,
+				   cfg.remote_ip, cfg.bts_base_port + offset,
+				   OSMO_SOCK_F_BIND | OSMO_SOCK_F_CONNECT);
+}
+
+static int lg_clk_read_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	uint8_t buf[64];
+
+	/* nothing is expected on the clock socket, drain it */
+	recv(ofd->fd, buf, sizeof(buf), 0);
+	return 0;
+}
+
+static void print_help(const char *prog_name)
+{
+	printf("Usage: %s [options]\n", prog_name);
+	printf("  -h --help			This text.\n"
+	       "  -l --local-ip IP		Address to bind to (default: 127.0.0.1)\n"
+	       "  -r --remote-ip IP		Address of osmo-bts-trx (default: 127.0.0.1)\n"
+	       "  -p --base-port PORT		Transceiver base port (default: 5700)\n"
+	       "  -P --bts-base-port PORT	osmo-bts-trx base port (default: 5800)\n"
+	       "  -t --trx-num N		Number of transceivers (default: 1)\n"
+	       "  -m --ms-num N			Number of simulated MS (default: 8)\n"
+	       "  -F --trxd-version-max N	Highest TRXD PDU version to accept (default: 2)\n"
+	       "  -d --duration SECONDS		Stop after SECONDS (default: run until interrupted)\n"
+	       "  -i --report-interval SECONDS	Print statistics every SECONDS (default: 10)\n"
+	       "  -T --self-test		Check the TRXD encoding and decoding, then exit\n");
+}
+
+static void handle_options(int argc, char **argv)
+{
+	while (1) {
+		int option_index = 0, c;
+		static const struct option long_options[] = {
+			{ "help", 0, 0, 'h' },
+			{ "local-ip", 1, 0, 'l' },
+			{ "remote-ip", 1, 0, 'r' },
+			{ "base-port", 1, 0, 'p' },
+			{ "bts-base-port", 1, 0, 'P' },
+			{ "trx-num", 1, 0, 't' },
+			{ "ms-num", 1, 0, 'm' },
+			{ "trxd-version-max", 1, 0, 'F' },
+			{ "duration", 1, 0, 'd' },
+			{ "report-interval", 1, 0, 'i' },
+			{ "self-test", 0, 0, 'T' },
+			{ 0, 0, 0, 0 }
+		};
+
+		c = getopt_long(argc, argv, "hl:r:p:P:t:m:F:d:i:T", long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			print_help(argv[0]);
+			exit(0);
+		case 'l':
+			cfg.local_ip = optarg;
+			break;
+		case 'r':
+			cfg.remote_ip = optarg;
+			break;
+		case 'p':
+			cfg.base_port = atoi(optarg);
+			break;
+		case 'P':
+			cfg.bts_base_port = atoi(optarg);
+			break;
+		case 't':
+			cfg.num_trx = atoi(optarg);
+			if (cfg.num_trx < 1 || cfg.num_trx > LG_MAX_TRX) {
+				fprintf(stderr, "Number of TRX must be 1..%u\n", LG_MAX_TRX);
+				exit(2);
+			}
+			break;
+		case 'm':
+			cfg.num_ms = atoi(optarg);
+			break;
+		case 'F':
+			cfg.pdu_ver_max = OSMO_MIN(atoi(optarg), 2);
+			break;
+		case 'd':
+			cfg.duration = atoi(optarg);
+			break;
+		case 'i':
+			cfg.report_interval = OSMO_MAX(atoi(optarg), 1);
+			break;
+		case 'T':
+			cfg.self_test = true;
+			break;
+		default:
+			print_help(argv[0]);
+			exit(2);
+		}
+	}
+}
+
+static const struct log_info lg_log_info = { };
+
+int main(int argc, char **argv)
+{
+	unsigned int i, tn;
+	int rc;
+
+	tall_lg_ctx = talloc_named_const(NULL, 1, "osmo-trx-loadgen");
+	msgb_talloc_ctx_init(tall_lg_ctx, 0);
+	osmo_init_logging2(tall_lg_ctx, &lg_log_info);
+
+	handle_options(argc, argv);
+
+	if (cfg.self_test)
+		exit(lg_self_test() ? 1 : 0);
+
+	/* same port layout as osmo-trx: clock, then (TRXC, TRXD) per TRX */
+	if (lg_udp_open(&lg_clk_ofd, 0, lg_clk_read_cb, NULL) < 0) {
+		fprintf(stderr, "Failed to open the clock socket\n");
+		exit(1);
+	}
+
+	for (i = 0; i < cfg.num_trx; i++) {
+		struct lg_trx *trx = &lg_trx[i];
+
+		trx->num = i;
+		for (tn = 0; tn < ARRAY_SIZE(trx->ts); tn++)
+			trx->ts[tn].mf_idx = -1;
+		if (lg_udp_open(&trx->ctrl_ofd, 2 * i + 1, lg_ctrl_read_cb, trx) < 0
+		    || lg_udp_open(&trx->data_ofd, 2 * i + 2, lg_data_read_cb, trx) < 0) {
+			fprintf(stderr, "Failed to open the sockets of TRX%u\n", i);
+			exit(1);
+		}
+	}
+
+	rc = osmo_timerfd_setup(&lg_fn_timer_ofd, lg_fn_timer_cb, NULL);
+	if (rc < 0) {
+		fprintf(stderr, "Failed to set up the frame clock\n");
+		exit(1);
+	}
+	lg_start_ns = lg_now_ns();
+	lg_fn_timer_arm();
+
+	osmo_timer_setup(&lg_report_timer, lg_report_timer_cb, NULL);
+	osmo_timer_schedule(&lg_report_timer, cfg.report_interval, 0);
+
+	signal(SIGINT, &signal_handler);
+	signal(SIGTERM, &signal_handler);
+	signal(SIGALRM, &signal_handler);
+	if (cfg.duration)
+		alarm(cfg.duration);
+
+	printf("Simulating %u TRX with up to %u MS, TRXD PDU version <= %u\n",
+	       cfg.num_trx, cfg.num_ms, cfg.pdu_ver_max);
+
+	while (!lg_quit)
+		osmo_select_main(0);
+
+	lg_report();
+
+	return 0;
+}
@@ -38,6 +38,7 @@
 #include <osmo-bts/nm_common_fsm.h>
 
 #include "virtual_um.h"
+#include "l1_if.h"
 
 /* TODO: check if dummy method is sufficient, else implement */
 int bts_model_lchan_deactivate(struct gsm_lchan *lchan)
@@ -128,9 +129,12 @@ int bts_model_apply_oml(struct gsm_bts *bts, struct msgb *msg,
 	switch (foh->msg_type) {
 	case NM_MT_SET_BTS_ATTR:
 		ev_data.cause = vbts_set_bts(obj);
+		/* may have changed the ARFCN of C0 */
+		vbts_arfcn_map_update(bts);
 		break;
 	case NM_MT_SET_RADIO_ATTR:
 		ev_data.cause = vbts_set_trx(obj);
+		vbts_arfcn_map_update(bts);
 		break;
 	case NM_MT_SET_CHAN_ATTR:
 		ev_data.cause = vbts_set_ts(obj);
@@ -46,14 +46,56 @@
 
 extern int vbts_sched_start(struct gsm_bts *bts);
 
-static struct phy_instance *phy_instance_by_arfcn(struct phy_link *plink, uint16_t arfcn)
+#define ARFCN_MAP_SIZE	1024
+
+/* (re)build the ARFCN -> PHY instance map of a PHY link.  If several TRX
+ * of the link use the same ARFCN, the uplink goes to the first one only. */
+static void arfcn_map_build(struct phy_link *plink)
 {
+	struct phy_instance **map = plink->u.virt.arfcn_map;
 	struct phy_instance *pinst;
+	uint16_t arfcn;
+
+	if (!map)
+		return;
 
+	memset(map, 0, ARFCN_MAP_SIZE * sizeof(map[0]));
 	llist_for_each_entry(pinst, &plink->instances, list) {
-		if (pinst->trx && pinst->trx->arfcn == arfcn)
-			return pinst;
+		if (!pinst->trx || pinst->trx->arfcn >= ARFCN_MAP_SIZE)
+			continue;
+		arfcn = pinst->trx->arfcn;
+		if (map[arfcn]) {
+			LOGPPHI(pinst, DL1C, LOGL_NOTICE, "ARFCN %u is also used by TRX %u, "
+				"which gets all uplink bursts on it\n", arfcn, map[arfcn]->trx->nr);
+			continue;
+		}
+		map[arfcn] = pinst;
 	}
+}
+
+/*! Rebuild the ARFCN maps after the ARFCN of a TRX was (re)configured via OML */
+void vbts_arfcn_map_update(struct gsm_bts *bts)
+{
+	struct gsm_bts_trx *trx;
+	struct phy_instance *pinst;
+
+	llist_for_each_entry(trx, &bts->trx_list, list) {
+		pinst = trx_phy_instance(trx);
+		if (pinst)
+			arfcn_map_build(pinst->phy_link);
+	}
+}
+
+static struct phy_instance *phy_instance_by_arfcn(struct phy_link *plink, uint16_t arfcn)
+{
+	struct phy_instance *pinst;
+
+	if (arfcn >= ARFCN_MAP_SIZE)
+		return NULL;
+
+	pinst = plink->u.virt.arfcn_map[arfcn];
+	if (pinst && pinst->trx && pinst->trx->arfcn == arfcn)
+		return pinst;
 
 	return NULL;
 }
@@ -65,14 +107,14 @@ static int l1if_process_meas_res(struct gsm_bts_trx *trx, uint8_t tn, uint32_t f
  * The incoming message should be GSM_TAP encapsulated.
  * TODO: implement all channels
  */
-static void virt_um_rcv_cb(struct virt_um_inst *vui, struct msgb *msg)
+static int virt_um_rcv_cb(struct virt_um_inst *vui, struct msgb *msg)
 {
 	struct phy_link *plink = (struct phy_link *)vui->priv;
 	struct phy_instance *pinst;
 	if (!msg) {
 		pinst = phy_instance_by_num(plink, 0);
 		bts_shutdown(pinst->trx->bts, "VirtPHY read socket died\n");
-		return;
+		return 0;
 	}
 
 	struct gsmtap_hdr *gh = msgb_l1(msg);
@@ -178,10 +220,11 @@ static void virt_um_rcv_cb(struct virt_um_inst *vui, struct msgb *msg)
 	/* forward primitive, lsap takes ownership of the msgb. */
 	l1sap_up(pinst->trx, &l1sap);
 	DEBUGPFN(DL1P, fn, "Message forwarded to layer 2.\n");
-	return;
+	return 0;
 
 nomessage:
-	talloc_free(msg);
+	/* the caller frees or reuses the msgb */
+	return -EINVAL;
 }
 
 /* called by common part once OML link is established */
@@ -202,9 +245,31 @@ int bts_model_phy_link_open(struct phy_link *plink)
 
 	phy_link_state_set(plink, PHY_LINK_CONNECTING);
 
-	plink->u.virt.virt_um = virt_um_init(plink, plink->u.virt.ms_mcast_group, plink->u.virt.ms_mcast_port,
-					     plink->u.virt.bts_mcast_group, plink->u.virt.bts_mcast_port,
-					     plink->u.virt.ttl, plink->u.virt.mcast_dev, virt_um_rcv_cb);
+	if (!plink->u.virt.arfcn_map)
+		plink->u.virt.arfcn_map = talloc_zero_array(plink, struct phy_instance *, ARFCN_MAP_SIZE);
+	if (!plink->u.virt.arfcn_map) {
+		phy_link_state_set(plink, PHY_LINK_SHUTDOWN);
+		return -ENOMEM;
+	}
+	arfcn_map_build(plink);
+
+	switch (plink->u.virt.transport) {
+	case VIRT_UM_T_UNICAST:
+		plink->u.virt.virt_um = virt_um_init_unicast(plink, plink->u.virt.bts_mcast_port,
+							     plink->u.virt.unicast_peers,
+							     plink->u.virt.num_unicast_peers,
+							     plink->u.virt.ms_mcast_port, virt_um_rcv_cb);
+		break;
+	case VIRT_UM_T_SHM:
+		plink->u.virt.virt_um = virt_um_init_shm(plink, plink->u.virt.shm_name, virt_um_rcv_cb);
+		break;
+	case VIRT_UM_T_MULTICAST:
+	default:
+		plink->u.virt.virt_um = virt_um_init(plink, plink->u.virt.ms_mcast_group, plink->u.virt.ms_mcast_port,
+						     plink->u.virt.bts_mcast_group, plink->u.virt.bts_mcast_port,
+						     plink->u.virt.ttl, plink->u.virt.mcast_dev, virt_um_rcv_cb);
+		break;
+	}
 	if (!plink->u.virt.virt_um) {
 		phy_link_state_set(plink, PHY_LINK_SHUTDOWN);
 		return -1;
@@ -212,6 +277,9 @@ int bts_model_phy_link_open(struct phy_link *plink)
 	/* set back reference to plink */
 	plink->u.virt.virt_um->priv = plink;
 
+	if (plink->u.virt.batching && virt_um_set_batching(plink->u.virt.virt_um, true) < 0)
+		LOGP(DL1C, LOGL_ERROR, "Failed to enable batched Virtual Um I/O\n");
+
 	/* iterate over list of PHY instances and initialize the scheduler */
 	llist_for_each_entry(pinst, &plink->instances, list) {
 		if (pinst->trx == NULL)
@@ -5,11 +5,58 @@
 
 #include "virtual_um.h"
 
+/* bts-virtual specific rate counters */
+enum {
+	BTSVIRT_CTR_SCHED_DL_MISS_FN,
+	/* histogram of the frame clock wake-up delay after the deadline */
+	BTSVIRT_CTR_CLK_DELAY_100US,
+	BTSVIRT_CTR_CLK_DELAY_250US,
+	BTSVIRT_CTR_CLK_DELAY_500US,
+	BTSVIRT_CTR_CLK_DELAY_1MS,
+	BTSVIRT_CTR_CLK_DELAY_2MS,
+	BTSVIRT_CTR_CLK_DELAY_MORE,
+};
+
+/* phases of a frame in time-warp mode, see time_warp.c */
+enum vbts_tw_phase {
+	VBTS_TW_PH_LOOP,	/* main loop in between frames */
+	VBTS_TW_PH_UL,		/* synthetic uplink, Virtual Um receive path */
+	VBTS_TW_PH_TIME_IND,	/* MPH-TIME.ind */
+	VBTS_TW_PH_DL,		/* RTS and downlink burst generation */
+	VBTS_TW_PH_TX,		/* Virtual Um flush and poll */
+	_NUM_VBTS_TW_PH
+};
+
+/* command line configuration of the time-warp mode */
+struct vbts_time_warp_cfg {
+	uint64_t num_frames;		/* 0: real-time frame clock */
+	bool ul_load;			/* feed a synthetic uplink */
+};
+extern struct vbts_time_warp_cfg vbts_time_warp_cfg;
+
+struct vbts_time_warp {
+	uint64_t num_frames;		/* stop after this many frames */
+	bool ul_load;
+	uint64_t frames;		/* frames processed so far */
+	uint64_t start_wall_ns;		/* CLOCK_MONOTONIC */
+	uint64_t start_cpu_ns;		/* CLOCK_THREAD_CPUTIME_ID */
+	uint64_t mark_ns;		/* CPU time at the last phase boundary */
+	uint64_t phase_ns[_NUM_VBTS_TW_PH];
+};
+
 /* gsm_bts->model_priv, specific to osmo-bts-virtual */
 struct bts_virt_priv {
 	uint32_t last_fn;
-	struct timeval tv_clock;
-	struct osmo_timer_list fn_timer;
+	struct {
+		/*! CLOCK_MONOTONIC timerfd, armed with absolute deadlines */
+		struct osmo_fd fn_timer_ofd;
+		/*! time of the first frame (ns) */
+		uint64_t start_ns;
+		/*! number of frames processed since start_ns */
+		uint64_t frames;
+	} clk;
+	struct rate_ctr_group *ctrs;		/* bts-virtual specific rate counters */
+	struct vbts_time_warp *tw;		/* NULL unless in time-warp mode */
 };
 
 struct vbts_l1h {
@@ -24,3 +71,10 @@ void l1if_reset(struct vbts_l1h *l1h);
 int l1if_mph_time_ind(struct gsm_bts *bts, uint32_t fn);
 
 int vbts_sched_start(struct gsm_bts *bts);
+void vbts_arfcn_map_update(struct gsm_bts *bts);
+
+struct vbts_time_warp *vbts_tw_alloc(void *ctx);
+void vbts_tw_start(struct vbts_time_warp *tw);
+void vbts_tw_mark(struct vbts_time_warp *tw, enum vbts_tw_phase phase);
+void vbts_tw_ul_load(struct gsm_bts *bts, uint32_t fn);
+bool vbts_tw_frame_done(struct vbts_time_warp *tw);
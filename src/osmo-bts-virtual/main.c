@@ -20,6 +20,7 @@
  */
 
 #include <stdint.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -35,6 +36,8 @@
 
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/application.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stats.h>
 #include <osmocom/vty/telnet_interface.h>
 #include <osmocom/vty/logging.h>
 #include <osmocom/vty/ports.h>
@@ -49,6 +52,44 @@
 #include "virtual_um.h"
 #include "l1_if.h"
 
+static const struct rate_ctr_desc btsvirt_ctr_desc[] = {
+	[BTSVIRT_CTR_SCHED_DL_MISS_FN] = {
+		"virt_clk:sched_dl_miss_fn",
+		"Downlink frames scheduled later than expected due to missed timerfd event (due to high system load)"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_100US] = {
+		"virt_clk:delay_100us",
+		"Frame clock woke up less than 100us after the frame deadline"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_250US] = {
+		"virt_clk:delay_250us",
+		"Frame clock woke up 100..250us after the frame deadline"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_500US] = {
+		"virt_clk:delay_500us",
+		"Frame clock woke up 250..500us after the frame deadline"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_1MS] = {
+		"virt_clk:delay_1ms",
+		"Frame clock woke up 0.5..1ms after the frame deadline"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_2MS] = {
+		"virt_clk:delay_2ms",
+		"Frame clock woke up 1..2ms after the frame deadline"
+	},
+	[BTSVIRT_CTR_CLK_DELAY_MORE] = {
+		"virt_clk:delay_more",
+		"Frame clock woke up 2ms or more after the frame deadline"
+	},
+};
+static const struct rate_ctr_group_desc btsvirt_ctrg_desc = {
+	"bts-virtual",
+	"osmo-bts-virtual specific counters",
+	OSMO_STATS_CLASS_GLOBAL,
+	ARRAY_SIZE(btsvirt_ctr_desc),
+	btsvirt_ctr_desc
+};
+
 /* dummy, since no direct dsp support */
 uint32_t trx_get_hlayer1(const struct gsm_bts_trx *trx)
 {
@@ -58,6 +99,11 @@ uint32_t trx_get_hlayer1(const struct gsm_bts_trx *trx)
 int bts_model_init(struct gsm_bts *bts)
 {
 	struct bts_virt_priv *bts_virt = talloc_zero(bts, struct bts_virt_priv);
+	bts_virt->clk.fn_timer_ofd.fd = -1;
+	bts_virt->ctrs = rate_ctr_group_alloc(bts_virt, &btsvirt_ctrg_desc, 0);
+	if (vbts_time_warp_cfg.num_frames)
+		bts_virt->tw = vbts_tw_alloc(bts_virt);
+
 	bts->model_priv = bts_virt;
 	bts->variant = BTS_OSMO_VIRTUAL;
 	bts->support.ciphers = CIPHER_A5(1) | CIPHER_A5(2) | CIPHER_A5(3);
@@ -80,7 +126,11 @@ int bts_model_trx_init(struct gsm_bts_trx *trx)
 
 void bts_model_print_help()
 {
-	LOGP(DSUM, LOGL_NOTICE, "Unimplemented %s\n", __func__);
+	printf( "\nModel specific options:\n"
+		"  -W	--time-warp FRAMES	Benchmark: run FRAMES frames as fast as "
+						"possible, log the CPU cost and exit\n"
+		"	--time-warp-no-ul	Benchmark without synthetic uplink\n"
+		);
 }
 
 int bts_model_handle_options(int argc, char **argv)
@@ -91,15 +141,25 @@ int bts_model_handle_options(int argc, char **argv)
 		int option_idx = 0, c;
 		static const struct option long_options[] = {
 			/* specific to this hardware */
+			{ "time-warp", 1, 0, 'W' },
+			{ "time-warp-no-ul", 0, 0, 'U' },
 			{ 0, 0, 0, 0 }
 		};
 
-		c = getopt_long(argc, argv, "",
+		c = getopt_long(argc, argv, "W:",
 				long_options, &option_idx);
 		if (c == -1)
 			break;
 
 		switch (c) {
+		case 'W':
+			vbts_time_warp_cfg.num_frames = strtoull(optarg, NULL, 10);
+			if (!vbts_time_warp_cfg.num_frames)
+				num_errors++;
+			break;
+		case 'U':
+			vbts_time_warp_cfg.ul_load = false;
+			break;
 		default:
 			num_errors++;
 			break;
@@ -122,6 +182,8 @@ void bts_model_phy_link_set_defaults(struct phy_link *plink)
 	plink->u.virt.ms_mcast_group = talloc_strdup(plink, DEFAULT_MS_MCAST_GROUP);
 	plink->u.virt.ms_mcast_port = DEFAULT_MS_MCAST_PORT;
 	plink->u.virt.ttl = -1; /* initialize to -1 to prevent us setting the TTL */
+	plink->u.virt.transport = VIRT_UM_T_MULTICAST;
+	plink->u.virt.shm_name = talloc_strdup(plink, DEFAULT_SHM_NAME);
 }
 
 void bts_model_phy_instance_set_defaults(struct phy_instance *pinst)
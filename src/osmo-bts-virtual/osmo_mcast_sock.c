@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
@@ -8,8 +9,12 @@
 #include <string.h>
 #include <talloc.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
 #include "osmo_mcast_sock.h"
 
+#include "btsconfig.h"
+
 /* server socket is what we use for transmission. It is not subscribed
  * to a multicast group or locally bound, but it is just a normal UDP
  * socket that's connected to the remote mcast group + port */
@@ -103,6 +108,55 @@ int mcast_bidir_sock_rx(struct mcast_bidir_sock *bidir_sock, uint8_t *buf, unsig
 	return recv(bidir_sock->rx_ofd.fd, buf, buf_len, 0);
 }
 
+/* Send several datagrams on a UDP socket with one system call (if available).
+ * Returns the number of datagrams sent, negative errno if none was sent. */
+int dgram_sock_txv(int fd, struct mmsghdr *msgs, unsigned int num)
+{
+	int rc;
+
+#ifdef HAVE_SENDMMSG
+	rc = sendmmsg(fd, msgs, num, 0);
+	if (rc < 0)
+		return -errno;
+#else
+	for (rc = 0; (unsigned int) rc < num; rc++) {
+		if (sendmsg(fd, &msgs[rc].msg_hdr, 0) < 0) {
+			if (rc == 0)
+				return -errno;
+			break;
+		}
+	}
+#endif
+
+	return rc;
+}
+
+/* Receive up to num datagrams without blocking, the length of each one is
+ * stored in msgs[i].msg_len.  Returns the number of datagrams received,
+ * negative errno if none was available. */
+int dgram_sock_rxv(int fd, struct mmsghdr *msgs, unsigned int num)
+{
+	int rc;
+
+#ifdef HAVE_RECVMMSG
+	rc = recvmmsg(fd, msgs, num, MSG_DONTWAIT, NULL);
+	if (rc < 0)
+		return -errno;
+#else
+	for (rc = 0; (unsigned int) rc < num; rc++) {
+		ssize_t len = recvmsg(fd, &msgs[rc].msg_hdr, MSG_DONTWAIT);
+		if (len < 0) {
+			if (rc == 0)
+				return -errno;
+			break;
+		}
+		msgs[rc].msg_len = len;
+	}
+#endif
+
+	return rc;
+}
+
 void mcast_bidir_sock_close(struct mcast_bidir_sock *bidir_sock)
 {
 	osmo_fd_close(&bidir_sock->tx_ofd);
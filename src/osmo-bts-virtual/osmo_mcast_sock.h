@@ -5,6 +5,8 @@
 #include <netinet/in.h>
 #include <osmocom/core/select.h>
 
+struct mmsghdr;
+
 struct mcast_bidir_sock {
 	struct osmo_fd tx_ofd;
 	struct osmo_fd rx_ofd;
@@ -27,3 +29,6 @@ int mcast_bidir_sock_tx(struct mcast_bidir_sock *bidir_sock, const uint8_t *data
 int mcast_bidir_sock_rx(struct mcast_bidir_sock *bidir_sock, uint8_t *buf, unsigned int buf_len);
 void mcast_bidir_sock_close(struct mcast_bidir_sock* bidir_sock);
 
+int dgram_sock_txv(int fd, struct mmsghdr *msgs, unsigned int num);
+int dgram_sock_rxv(int fd, struct mmsghdr *msgs, unsigned int num);
+
@@ -25,13 +25,18 @@
 #include <string.h>
 #include <errno.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <ctype.h>
+#include <time.h>
+#include <sys/timerfd.h>
 
 #include <osmocom/core/msgb.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/bits.h>
 #include <osmocom/core/gsmtap_util.h>
 #include <osmocom/core/gsmtap.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/select.h>
 #include <osmocom/gsm/rsl.h>
 
 #include <osmo-bts/gsm_data.h>
@@ -519,12 +524,22 @@ void _sched_act_rach_det(struct gsm_bts_trx *trx, uint8_t tn, uint8_t ss, int ac
 
 static int vbts_sched_fn(struct gsm_bts *bts, uint32_t fn)
 {
+	struct vbts_time_warp *tw = ((struct bts_virt_priv *)bts->model_priv)->tw;
 	struct gsm_bts_trx *trx;
 
+	if (tw) {
+		vbts_tw_mark(tw, VBTS_TW_PH_LOOP);
+		if (tw->ul_load)
+			vbts_tw_ul_load(bts, fn);
+		vbts_tw_mark(tw, VBTS_TW_PH_UL);
+	}
+
 	/* send time indication */
 	/* update model with new frame number, lot of stuff happening, measurements of timeslots */
 	/* saving GSM time in BTS model, and more */
 	l1if_mph_time_ind(bts, fn);
+	if (tw)
+		vbts_tw_mark(tw, VBTS_TW_PH_TIME_IND);
 
 	/* advance the frame number? */
 	llist_for_each_entry(trx, &bts->trx_list, list) {
@@ -550,60 +565,179 @@ static int vbts_sched_fn(struct gsm_bts *bts, uint32_t fn)
 		}
 	}
 
+	if (tw)
+		vbts_tw_mark(tw, VBTS_TW_PH_DL);
+
+	/* send the messages of this frame (if batched) and read the shared
+	 * memory ring (if used), TRX may share a PHY link */
+	llist_for_each_entry(trx, &bts->trx_list, list) {
+		struct phy_instance *pinst = trx_phy_instance(trx);
+
+		if (pinst && pinst->phy_link->u.virt.virt_um) {
+			virt_um_flush(pinst->phy_link->u.virt.virt_um);
+			virt_um_poll(pinst->phy_link->u.virt.virt_um);
+		}
+	}
+	if (tw)
+		vbts_tw_mark(tw, VBTS_TW_PH_TX);
+
+	return 0;
+}
+
+/* Frame deadlines are computed from the start time and the number of frames
+ * processed, using the exact frame duration of 120/26 ms, so that neither the
+ * integer frame duration nor the wake-up delays accumulate. */
+static uint64_t vbts_clk_deadline_ns(const struct bts_virt_priv *bts_virt, uint64_t frames)
+{
+	return bts_virt->clk.start_ns + frames * 120000000 / 26;
+}
+
+static uint64_t vbts_clk_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int vbts_clk_arm(struct bts_virt_priv *bts_virt)
+{
+	uint64_t deadline_ns = vbts_clk_deadline_ns(bts_virt, bts_virt->clk.frames + 1);
+	const struct itimerspec its = {
+		.it_value = {
+			.tv_sec = deadline_ns / 1000000000,
+			.tv_nsec = deadline_ns % 1000000000,
+		},
+	};
+
+	return timerfd_settime(bts_virt->clk.fn_timer_ofd.fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+static void vbts_clk_delay_account(struct bts_virt_priv *bts_virt, uint64_t delay_ns)
+{
+	unsigned int idx;
+
+	if (delay_ns < 100000)
+		idx = BTSVIRT_CTR_CLK_DELAY_100US;
+	else if (delay_ns < 250000)
+		idx = BTSVIRT_CTR_CLK_DELAY_250US;
+	else if (delay_ns < 500000)
+		idx = BTSVIRT_CTR_CLK_DELAY_500US;
+	else if (delay_ns < 1000000)
+		idx = BTSVIRT_CTR_CLK_DELAY_1MS;
+	else if (delay_ns < 2000000)
+		idx = BTSVIRT_CTR_CLK_DELAY_2MS;
+	else
+		idx = BTSVIRT_CTR_CLK_DELAY_MORE;
+
+	rate_ctr_inc2(bts_virt->ctrs, idx);
+}
+
+/* In time-warp mode, the timer expires right away: it is only used to let the
+ * main loop handle the other file descriptors in between frames. */
+static int vbts_tw_arm(struct bts_virt_priv *bts_virt)
+{
+	const struct itimerspec its = {
+		.it_value = { .tv_nsec = 1 },
+	};
+
+	return timerfd_settime(bts_virt->clk.fn_timer_ofd.fd, 0, &its, NULL);
+}
+
+static int vbts_tw_fn_timer_cb(struct gsm_bts *bts)
+{
+	struct bts_virt_priv *bts_virt = (struct bts_virt_priv *)bts->model_priv;
+
+	bts_virt->clk.frames++;
+	vbts_sched_fn(bts, GSM_TDMA_FN_INC(bts_virt->last_fn));
+
+	if (vbts_tw_frame_done(bts_virt->tw)) {
+		bts_shutdown(bts, "Time-warp benchmark finished");
+		return 0;
+	}
+
+	if (vbts_tw_arm(bts_virt) < 0) {
+		LOGP(DL1P, LOGL_ERROR, "Failed to arm the frame clock: %s\n", strerror(errno));
+		bts_shutdown(bts, "Frame clock failure");
+		return -1;
+	}
+
 	return 0;
 }
 
-static void vbts_fn_timer_cb(void *data)
+static int vbts_fn_timer_cb(struct osmo_fd *ofd, unsigned int what)
 {
-	struct gsm_bts *bts = data;
+	struct gsm_bts *bts = ofd->data;
 	struct bts_virt_priv *bts_virt = (struct bts_virt_priv *)bts->model_priv;
-	struct timeval tv_now;
-	struct timeval *tv_clock = &bts_virt->tv_clock;
-	int32_t elapsed_us;
-
-	gettimeofday(&tv_now, NULL);
-
-	/* check how much time elapsed till the last timer callback call.
-	 * this value should be about 4.615 ms (a bit greater) as this is the scheduling interval */
-	elapsed_us = (tv_now.tv_sec - tv_clock->tv_sec) * 1000000
-	                + (tv_now.tv_usec - tv_clock->tv_usec);
-
-	/* not so good somehow a lot of time passed between two timer callbacks */
-	if (elapsed_us > 2 *GSM_TDMA_FN_DURATION_uS)
-		LOGP(DL1P, LOGL_NOTICE, "vbts_fn_timer_cb after %d us\n", elapsed_us);
-
-	/* schedule the current frame/s (fn = frame number)
-	 * this loop will be called at least once, but can also be executed
-	 * multiple times if more than one frame duration (4615us) passed till the last callback */
-	while (elapsed_us > GSM_TDMA_FN_DURATION_uS / 2) {
-		const struct timeval tv_frame = {
-			.tv_sec = 0,
-			.tv_usec = GSM_TDMA_FN_DURATION_uS,
-		};
-		timeradd(tv_clock, &tv_frame, tv_clock);
-		/* increment the frame number in the BTS model instance */
+	uint64_t expire_count, now_ns, deadline_ns, due;
+	int rc;
+
+	if (!(what & OSMO_FD_READ))
+		return 0;
+
+	/* the timer is one-shot, reading only acknowledges it */
+	rc = read(ofd->fd, (void *) &expire_count, sizeof(expire_count));
+	if (rc < 0 && errno == EAGAIN)
+		return 0;
+	OSMO_ASSERT(rc == sizeof(expire_count));
+
+	if (bts_virt->tw)
+		return vbts_tw_fn_timer_cb(bts);
+
+	now_ns = vbts_clk_now_ns();
+	deadline_ns = vbts_clk_deadline_ns(bts_virt, bts_virt->clk.frames + 1);
+	if (now_ns < deadline_ns) {
+		/* woken up early, should not happen with TFD_TIMER_ABSTIME */
+		vbts_clk_arm(bts_virt);
+		return 0;
+	}
+	vbts_clk_delay_account(bts_virt, now_ns - deadline_ns);
+
+	/* number of frames whose deadline has passed */
+	due = (now_ns - bts_virt->clk.start_ns) * 26 / 120000000 - bts_virt->clk.frames;
+	if (due > 1) {
+		LOGP(DL1P, LOGL_NOTICE, "vbts_fn_timer_cb %"PRIu64" us after the deadline: "
+		     "We missed %"PRIu64" frames\n", (now_ns - deadline_ns) / 1000, due - 1);
+		rate_ctr_add2(bts_virt->ctrs, BTSVIRT_CTR_SCHED_DL_MISS_FN, due - 1);
+	}
+
+	/* schedule the current frame/s (fn = frame number) */
+	while (due--) {
+		bts_virt->clk.frames++;
 		vbts_sched_fn(bts, GSM_TDMA_FN_INC(bts_virt->last_fn));
-		elapsed_us -= GSM_TDMA_FN_DURATION_uS;
 	}
 
-	/* re-schedule the timer */
-	/* timer is set to frame duration - elapsed time to guarantee that this cb method will be
-	 * periodically executed every 4.615ms */
-	osmo_timer_schedule(&bts_virt->fn_timer, 0, GSM_TDMA_FN_DURATION_uS - elapsed_us);
+	if (vbts_clk_arm(bts_virt) < 0) {
+		LOGP(DL1P, LOGL_ERROR, "Failed to arm the frame clock: %s\n", strerror(errno));
+		bts_shutdown(bts, "Frame clock failure");
+		return -1;
+	}
+
+	return 0;
 }
 
 int vbts_sched_start(struct gsm_bts *bts)
 {
 	struct bts_virt_priv *bts_virt = (struct bts_virt_priv *)bts->model_priv;
+	int rc;
+
 	LOGP(DL1P, LOGL_NOTICE, "starting VBTS scheduler\n");
 
-	memset(&bts_virt->fn_timer, 0, sizeof(bts_virt->fn_timer));
-	bts_virt->fn_timer.cb = vbts_fn_timer_cb;
-	bts_virt->fn_timer.data = bts;
+	osmo_fd_close(&bts_virt->clk.fn_timer_ofd);
+	rc = osmo_timerfd_setup(&bts_virt->clk.fn_timer_ofd, vbts_fn_timer_cb, bts);
+	if (rc < 0) {
+		LOGP(DL1P, LOGL_ERROR, "Failed to set up the frame clock timerfd\n");
+		return rc;
+	}
 
-	gettimeofday(&bts_virt->tv_clock, NULL);
-	/* trigger the first timer after 4615us (a frame duration) */
-	osmo_timer_schedule(&bts_virt->fn_timer, 0, GSM_TDMA_FN_DURATION_uS);
+	bts_virt->clk.start_ns = vbts_clk_now_ns();
+	bts_virt->clk.frames = 0;
 
-	return 0;
+	if (bts_virt->tw) {
+		vbts_tw_start(bts_virt->tw);
+		return vbts_tw_arm(bts_virt);
+	}
+
+	/* trigger the first timer after 4615us (a frame duration) */
+	return vbts_clk_arm(bts_virt);
 }
@@ -0,0 +1,248 @@
+/* Time-warp (free-running frame clock) benchmark of osmo-bts-virtual */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* In time-warp mode the frame clock does not wait for the 4.615 ms frame
+ * deadline, the next frame is scheduled as soon as vbts_sched_fn() returned
+ * and the main loop had a chance to handle the other file descriptors.
+ * Before each frame, a synthetic uplink is fed through the Virtual Um receive
+ * path, the downlink is what the scheduler generates on its own.
+ *
+ * The thread CPU time is accounted per phase of a frame, the result is
+ * logged after the configured number of frames and osmo-bts-virtual exits. */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/gsmtap.h>
+#include <osmocom/core/gsmtap_util.h>
+#include <osmocom/codec/codec.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/phy_link.h>
+#include <osmo-bts/logging.h>
+
+#include "virtual_um.h"
+#include "l1_if.h"
+
+/* RACH on every CCCH timeslot every 26 frames (~8 per second) */
+#define TW_RACH_INTERVAL	26
+
+struct vbts_time_warp_cfg vbts_time_warp_cfg = {
+	.ul_load = true,
+};
+
+static const struct value_string vbts_tw_phase_names[] = {
+	{ VBTS_TW_PH_LOOP,	"main loop" },
+	{ VBTS_TW_PH_UL,	"uplink" },
+	{ VBTS_TW_PH_TIME_IND,	"time indication" },
+	{ VBTS_TW_PH_DL,	"downlink" },
+	{ VBTS_TW_PH_TX,	"Um flush/poll" },
+	{ 0, NULL }
+};
+
+/* L2 fill frame, also used as dummy PDTCH block */
+static const uint8_t tw_l2_fill[GSM_MACBLOCK_LEN] = {
+	0x03, 0x03, 0x01, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+	0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+};
+
+/* voice type (gsmtap_um_voice_type) followed by a silence frame */
+static const uint8_t tw_fr_frame[1 + GSM_FR_BYTES] = {
+	GSMTAP_UM_VOICE_FR,
+	0xd0,
+};
+static const uint8_t tw_hr_frame[1 + GSM_HR_BYTES] = {
+	GSMTAP_UM_VOICE_HR,
+};
+
+static uint64_t tw_cpu_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t tw_wall_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+struct vbts_time_warp *vbts_tw_alloc(void *ctx)
+{
+	struct vbts_time_warp *tw = talloc_zero(ctx, struct vbts_time_warp);
+
+	if (!tw)
+		return NULL;
+	tw->num_frames = vbts_time_warp_cfg.num_frames;
+	tw->ul_load = vbts_time_warp_cfg.ul_load;
+
+	return tw;
+}
+
+void vbts_tw_start(struct vbts_time_warp *tw)
+{
+	LOGP(DL1P, LOGL_NOTICE, "Time-warp: running %"PRIu64" frames as fast as possible (%s)\n",
+	     tw->num_frames, tw->ul_load ? "with synthetic uplink" : "downlink only");
+
+	memset(tw->phase_ns, 0, sizeof(tw->phase_ns));
+	tw->frames = 0;
+	tw->start_wall_ns = tw_wall_ns();
+	tw->start_cpu_ns = tw_cpu_ns();
+	tw->mark_ns = tw->start_cpu_ns;
+}
+
+/*! Account the CPU time since the previous call to the given phase */
+void vbts_tw_mark(struct vbts_time_warp *tw, enum vbts_tw_phase phase)
+{
+	uint64_t now_ns = tw_cpu_ns();
+
+	tw->phase_ns[phase] += now_ns - tw->mark_ns;
+	tw->mark_ns = now_ns;
+}
+
+static void tw_ul_inject(struct virt_um_inst *vui, const struct gsm_bts_trx_ts *ts, uint32_t fn,
+			 uint8_t gsmtap_chantype, uint8_t subslot, const uint8_t *data, unsigned int len)
+{
+	struct msgb *msg;
+
+	msg = gsmtap_makemsg(ts->trx->arfcn | GSMTAP_ARFCN_F_UPLINK, ts->nr, gsmtap_chantype,
+			     subslot, fn, 0, 0, data, len);
+	if (!msg)
+		return;
+	msg->l1h = msgb_data(msg);
+	if (vui->recv_cb(vui, msg) < 0)
+		msgb_free(msg);
+}
+
+/* Is fn the last frame of a TCH block (26-multiframe, 4 bursts per block)? */
+static bool tw_tch_block_end(uint32_t fn)
+{
+	switch (fn % 26) {
+	case 3: case 7: case 11: case 16: case 20: case 24:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*! Feed one frame of synthetic uplink into the Virtual Um receive path.
+ *  Frames for inactive logical channels are dropped by L1SAP, like they
+ *  would be if sent by a misbehaving MS. */
+void vbts_tw_ul_load(struct gsm_bts *bts, uint32_t fn)
+{
+	struct gsm_bts_trx *trx;
+	uint8_t ra;
+	int tn;
+
+	llist_for_each_entry(trx, &bts->trx_list, list) {
+		struct phy_instance *pinst = trx_phy_instance(trx);
+		struct virt_um_inst *vui;
+
+		if (!pinst || !(vui = pinst->phy_link->u.virt.virt_um))
+			continue;
+
+		for (tn = 0; tn < ARRAY_SIZE(trx->ts); tn++) {
+			const struct gsm_bts_trx_ts *ts = &trx->ts[tn];
+
+			switch (ts_pchan(ts)) {
+			case GSM_PCHAN_CCCH:
+			case GSM_PCHAN_CCCH_SDCCH4:
+			case GSM_PCHAN_CCCH_SDCCH4_CBCH:
+				if (fn % TW_RACH_INTERVAL != 0)
+					break;
+				/* 000xxxxx: location updating (0001xxxx: other SDCCH
+				 * procedures, if NECI is set), 3GPP TS 44.018 Table
+				 * 9.1.8.1.  Either way an SDCCH is requested. */
+				ra = fn & 0x1f;
+				tw_ul_inject(vui, ts, fn, GSMTAP_CHANNEL_RACH, 0, &ra, 1);
+				break;
+			case GSM_PCHAN_SDCCH8_SACCH8C:
+			case GSM_PCHAN_SDCCH8_SACCH8C_CBCH:
+				if (fn % 4 != 3)
+					break;
+				tw_ul_inject(vui, ts, fn, GSMTAP_CHANNEL_SDCCH8, (fn / 4) % 8,
+					     tw_l2_fill, sizeof(tw_l2_fill));
+				break;
+			case GSM_PCHAN_TCH_F:
+				if (!tw_tch_block_end(fn))
+					break;
+				tw_ul_inject(vui, ts, fn, GSMTAP_CHANNEL_VOICE_F, 0,
+					     tw_fr_frame, sizeof(tw_fr_frame));
+				break;
+			case GSM_PCHAN_TCH_H:
+				if (!tw_tch_block_end(fn))
+					break;
+				tw_ul_inject(vui, ts, fn, GSMTAP_CHANNEL_VOICE_H, (fn % 26) & 1,
+					     tw_hr_frame, sizeof(tw_hr_frame));
+				break;
+			case GSM_PCHAN_PDCH:
+				if (fn % 4 != 3)
+					break;
+				tw_ul_inject(vui, ts, fn, GSMTAP_CHANNEL_PDCH, 0,
+					     tw_l2_fill, sizeof(tw_l2_fill));
+				break;
+			default:
+				break;
+			}
+		}
+	}
+}
+
+static void tw_report(const struct vbts_time_warp *tw)
+{
+	uint64_t wall_ns = tw_wall_ns() - tw->start_wall_ns;
+	uint64_t cpu_ns = tw_cpu_ns() - tw->start_cpu_ns;
+	double fps = tw->frames * 1e9 / (wall_ns ? wall_ns : 1);
+	unsigned int i;
+
+	LOGP(DL1P, LOGL_NOTICE, "Time-warp: %"PRIu64" frames in %.3f s: %.1f frames/s, "
+	     "%.2f times real-time, %.1f us CPU per frame\n",
+	     tw->frames, wall_ns / 1e9, fps, fps * 120 / 26 / 1000,
+	     cpu_ns / 1e3 / tw->frames);
+
+	for (i = 0; i < ARRAY_SIZE(tw->phase_ns); i++) {
+		LOGP(DL1P, LOGL_NOTICE, "Time-warp: %-16s %9.2f us/frame %5.1f%%\n",
+		     get_value_string(vbts_tw_phase_names, i),
+		     tw->phase_ns[i] / 1e3 / tw->frames,
+		     cpu_ns ? tw->phase_ns[i] * 100.0 / cpu_ns : 0);
+	}
+}
+
+/*! To be called after each frame.
+ *  \returns true if the benchmark is finished (and the result was logged). */
+bool vbts_tw_frame_done(struct vbts_time_warp *tw)
+{
+	if (++tw->frames < tw->num_frames)
+		return false;
+
+	tw_report(tw);
+	return true;
+}
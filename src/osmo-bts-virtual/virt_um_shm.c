@@ -0,0 +1,149 @@
+/* Shared memory transport of the Virtual Um interface */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#include <osmo-bts/logging.h>
+#include <osmo-bts/shm_ring.h>
+
+#include "virt_um_shm.h"
+
+/* How long to wait for the other side to initialize the area */
+#define VIRT_UM_SHM_INIT_WAIT_MS	1000
+
+osmo_static_assert(sizeof(struct virt_um_shm_rec) == sizeof(struct shm_ring_rec), virt_um_shm_rec_size);
+osmo_static_assert(VIRT_UM_SHM_REC_WRAP == SHM_RING_REC_WRAP, virt_um_shm_rec_wrap);
+
+#define VIRT_UM_SHM_RING(shm, id) SHM_RING(&(shm)->area->ring[id], DL1C, "Virtual Um")
+
+/*! Open (and create, if needed) the shared memory area of the Virtual Um.
+ *  Whichever side comes first initializes the area.
+ *  \param[in] ctx talloc context.
+ *  \param[in] name name of the shared memory object, e.g. "/osmo-bts-virtual-um".
+ *  \returns the opened area, NULL on error. */
+struct virt_um_shm *virt_um_shm_open(void *ctx, const char *name)
+{
+	struct virt_um_shm *shm;
+	uint32_t magic;
+	unsigned int i;
+	void *area;
+	int fd;
+
+	shm = talloc_zero(ctx, struct virt_um_shm);
+	if (!shm)
+		return NULL;
+	shm->name = talloc_strdup(shm, name);
+
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	if (fd < 0)
+		goto err;
+	if (ftruncate(fd, sizeof(*shm->area)) < 0) {
+		close(fd);
+		goto err;
+	}
+
+	area = mmap(NULL, sizeof(*shm->area), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (area == MAP_FAILED)
+		goto err;
+	shm->area = area;
+
+	magic = 0;
+	if (__atomic_compare_exchange_n(&shm->area->magic, &magic, VIRT_UM_SHM_INIT, false,
+					__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		memset(shm->area->ring, 0, sizeof(shm->area->ring));
+		shm->area->ring_size = VIRT_UM_SHM_RING_SIZE;
+		__atomic_store_n(&shm->area->magic, VIRT_UM_SHM_MAGIC, __ATOMIC_RELEASE);
+		return shm;
+	}
+
+	/* the other side is initializing the area right now */
+	for (i = 0; magic == VIRT_UM_SHM_INIT && i < VIRT_UM_SHM_INIT_WAIT_MS; i++) {
+		usleep(1000);
+		magic = __atomic_load_n(&shm->area->magic, __ATOMIC_ACQUIRE);
+	}
+
+	if (magic != VIRT_UM_SHM_MAGIC) {
+		LOGP(DL1C, LOGL_ERROR, "Virtual Um shared memory '%s' has unexpected magic 0x%08x "
+		     "(stale or of another version?)\n", name, magic);
+		errno = EINVAL;
+		goto err;
+	}
+	if (shm->area->ring_size != VIRT_UM_SHM_RING_SIZE) {
+		LOGP(DL1C, LOGL_ERROR, "Virtual Um shared memory '%s' has unexpected ring size %u\n",
+		     name, shm->area->ring_size);
+		errno = EINVAL;
+		goto err;
+	}
+
+	return shm;
+
+err:
+	LOGP(DL1C, LOGL_ERROR, "Failed to set up Virtual Um shared memory '%s': %s\n",
+	     name, strerror(errno));
+	virt_um_shm_close(shm);
+	return NULL;
+}
+
+void virt_um_shm_close(struct virt_um_shm *shm)
+{
+	if (shm->area)
+		munmap(shm->area, sizeof(*shm->area));
+	talloc_free(shm);
+}
+
+/*! Write a GSMTAP frame to the BTS->MS ring.
+ *  \returns len on success, -ENOSPC if the ring is full. */
+int virt_um_shm_tx(struct virt_um_shm *shm, const uint8_t *data, uint16_t len)
+{
+	const struct shm_ring ring = VIRT_UM_SHM_RING(shm, VIRT_UM_SHM_RING_BTS2MS);
+	uint8_t *rec_data;
+
+	if (len >= VIRT_UM_SHM_REC_WRAP)
+		return -EINVAL;
+
+	rec_data = shm_ring_reserve(&ring, len);
+	if (!rec_data)
+		return -ENOSPC;
+
+	memcpy(rec_data, data, len);
+	shm_ring_commit(&ring, len);
+
+	return len;
+}
+
+/*! Read all GSMTAP frames available in the MS->BTS ring.
+ *  \returns number of frames read. */
+int virt_um_shm_rx(struct virt_um_shm *shm, virt_um_shm_rx_cb_t *cb, void *cb_data)
+{
+	const struct shm_ring ring = VIRT_UM_SHM_RING(shm, VIRT_UM_SHM_RING_MS2BTS);
+
+	return shm_ring_read(&ring, cb, cb_data);
+}
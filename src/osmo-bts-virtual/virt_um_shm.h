@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Shared memory transport of the Virtual Um interface, for simulators
+ * running on the same host.
+ *
+ * The area is a POSIX shared memory object (see shm_open(3)) containing
+ * two single producer, single consumer rings, one per direction.  Each
+ * ring carries the same GSMTAP frames that would otherwise be sent as UDP
+ * datagrams, so a simulator only needs to replace its socket I/O.
+ *
+ * A frame is stored as a record: 16 bit length (host byte order), 16 bit
+ * spare, followed by the frame, padded to a multiple of 4 bytes.  Records
+ * do not wrap around the end of a ring: a length of VIRT_UM_SHM_REC_WRAP
+ * means that the rest of the ring is unused and the next record starts at
+ * offset 0.  head and tail are free running byte counters, the producer
+ * only writes head (with release semantics) and the consumer only writes
+ * tail.  Rings are polled once per TDMA frame, there is no wake-up.
+ *
+ * magic is 0 in a new area.  The side which changes it from 0 to
+ * VIRT_UM_SHM_INIT (atomically) initializes the area and then sets it to
+ * VIRT_UM_SHM_MAGIC, the other side waits for that. */
+
+#define VIRT_UM_SHM_MAGIC	0x564d5531	/* "VMU1" */
+#define VIRT_UM_SHM_INIT	0x564d5530	/* "VMU0", being initialized */
+#define VIRT_UM_SHM_RING_SIZE	(256 * 1024)
+#define VIRT_UM_SHM_REC_WRAP	0xffff
+
+enum virt_um_shm_ring_id {
+	VIRT_UM_SHM_RING_BTS2MS,
+	VIRT_UM_SHM_RING_MS2BTS,
+	_NUM_VIRT_UM_SHM_RING
+};
+
+struct virt_um_shm_rec {
+	uint16_t len;
+	uint16_t spare;
+	uint8_t data[0];
+} __attribute__((packed));
+
+struct virt_um_shm_ring {
+	uint32_t head __attribute__((aligned(64)));
+	uint32_t tail __attribute__((aligned(64)));
+	uint8_t data[VIRT_UM_SHM_RING_SIZE] __attribute__((aligned(64)));
+};
+
+struct virt_um_shm_area {
+	uint32_t magic;
+	uint32_t ring_size;
+	struct virt_um_shm_ring ring[_NUM_VIRT_UM_SHM_RING];
+};
+
+struct virt_um_shm {
+	struct virt_um_shm_area *area;
+	char *name;
+};
+
+struct virt_um_shm *virt_um_shm_open(void *ctx, const char *name);
+void virt_um_shm_close(struct virt_um_shm *shm);
+int virt_um_shm_tx(struct virt_um_shm *shm, const uint8_t *data, uint16_t len);
+
+/* Called for each frame read, data is only valid during the call */
+typedef void virt_um_shm_rx_cb_t(const uint8_t *data, uint16_t len, void *cb_data);
+int virt_um_shm_rx(struct virt_um_shm *shm, virt_um_shm_rx_cb_t *cb, void *cb_data);
@@ -19,18 +19,92 @@
  *
  */
 
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+
 #include <osmocom/core/select.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/core/socket.h>
 #include <osmocom/core/gsmtap.h>
 #include <osmocom/core/msgb.h>
 #include <osmocom/core/talloc.h>
+#include <osmocom/core/logging.h>
+#include <osmo-bts/logging.h>
 #include "osmo_mcast_sock.h"
 #include "virtual_um.h"
+#include "virt_um_shm.h"
 
 #include <unistd.h>
 #include <errno.h>
 
+/* With batching, messages written within a TDMA frame are sent with a single
+ * sendmmsg() by virt_um_flush(), and up to VIRT_UM_BATCH_MAX datagrams are
+ * read with a single recvmmsg() into preallocated message buffers.  Buffers
+ * of datagrams rejected by the receive callback are reused. */
+struct virt_um_batch {
+	struct msgb *tx_msgs[VIRT_UM_BATCH_MAX];
+	struct mmsghdr tx_mmsg[VIRT_UM_BATCH_MAX];
+	struct iovec tx_iov[VIRT_UM_BATCH_MAX];
+	unsigned int tx_num;
+	/* separate from tx, the receive callback may cause a flush */
+	struct msgb *rx_msgs[VIRT_UM_BATCH_MAX];
+	struct mmsghdr rx_mmsg[VIRT_UM_BATCH_MAX];
+	struct iovec rx_iov[VIRT_UM_BATCH_MAX];
+};
+
+static int virt_um_rx_fd(const struct virt_um_inst *vui)
+{
+	if (vui->transport == VIRT_UM_T_UNICAST)
+		return vui->udp_ofd.fd;
+	return vui->mcast_sock->rx_ofd.fd;
+}
+
+static int virt_um_read_batch(struct virt_um_inst *vui)
+{
+	struct virt_um_batch *vb = vui->batch;
+	int i, rc;
+
+	for (i = 0; i < VIRT_UM_BATCH_MAX; i++) {
+		if (!vb->rx_msgs[i]) {
+			vb->rx_msgs[i] = msgb_alloc(VIRT_UM_MSGB_SIZE, "Virtual UM Rx");
+			if (!vb->rx_msgs[i])
+				break;
+		}
+		vb->rx_iov[i].iov_base = msgb_data(vb->rx_msgs[i]);
+		vb->rx_iov[i].iov_len = msgb_tailroom(vb->rx_msgs[i]);
+		vb->rx_mmsg[i].msg_hdr = (struct msghdr) {
+			.msg_iov = &vb->rx_iov[i],
+			.msg_iovlen = 1,
+		};
+	}
+	if (i == 0)
+		return -ENOMEM;
+
+	rc = dgram_sock_rxv(virt_um_rx_fd(vui), vb->rx_mmsg, i);
+	if (rc < 0)
+		return rc;
+
+	for (i = 0; i < rc; i++) {
+		struct msgb *msg = vb->rx_msgs[i];
+
+		if (vb->rx_mmsg[i].msg_len == 0)
+			continue;
+		msgb_put(msg, vb->rx_mmsg[i].msg_len);
+		msg->l1h = msgb_data(msg);
+		if (vui->recv_cb(vui, msg) == 0)
+			vb->rx_msgs[i] = NULL;
+		else
+			msgb_reset(msg);
+	}
+
+	return rc;
+}
+
 /**
  * Virtual UM interface file descriptor callback.
  * Should be called by select.c when the fd is ready for reading.
@@ -39,23 +113,33 @@ static int virt_um_fd_cb(struct osmo_fd *ofd, unsigned int what)
 {
 	struct virt_um_inst *vui = ofd->data;
 
-	if (what & OSMO_FD_READ) {
+	if ((what & OSMO_FD_READ) && vui->batch) {
+		int rc = virt_um_read_batch(vui);
+		if (rc < 0 && rc != -EAGAIN)
+			perror("Read from Virtual Um socket");
+	} else if (what & OSMO_FD_READ) {
 		struct msgb *msg = msgb_alloc(VIRT_UM_MSGB_SIZE, "Virtual UM Rx");
 		int rc;
 
 		/* read message from fd into message buffer */
-		rc = mcast_bidir_sock_rx(vui->mcast_sock, msgb_data(msg), msgb_tailroom(msg));
+		if (vui->transport == VIRT_UM_T_UNICAST)
+			rc = recv(ofd->fd, msgb_data(msg), msgb_tailroom(msg), 0);
+		else
+			rc = mcast_bidir_sock_rx(vui->mcast_sock, msgb_data(msg), msgb_tailroom(msg));
 		if (rc > 0) {
 			msgb_put(msg, rc);
 			msg->l1h = msgb_data(msg);
 			/* call the l1 callback function for a received msg */
-			vui->recv_cb(vui, msg);
+			if (vui->recv_cb(vui, msg) < 0)
+				msgb_free(msg);
 		} else if (rc == 0) {
+			msgb_free(msg);
 			vui->recv_cb(vui, NULL);
 			osmo_fd_close(ofd);
-		} else
-			perror("Read from multicast socket");
-
+		} else {
+			msgb_free(msg);
+			perror("Read from Virtual Um socket");
+		}
 	}
 
 	return 0;
@@ -63,7 +147,7 @@ static int virt_um_fd_cb(struct osmo_fd *ofd, unsigned int what)
 
 struct virt_um_inst *virt_um_init(void *ctx, char *tx_mcast_group, uint16_t tx_mcast_port,
 				  char *rx_mcast_group, uint16_t rx_mcast_port, int ttl, const char *dev_name,
-				  void (*recv_cb)(struct virt_um_inst *vui, struct msgb *msg))
+				  virt_um_recv_cb_t *recv_cb)
 {
 	struct virt_um_inst *vui = talloc_zero(ctx, struct virt_um_inst);
 	int rc;
@@ -107,23 +191,245 @@ out_close:
 	return NULL;
 }
 
+/**
+ * Set up a Virtual Um interface sending to a list of unicast peers, useful
+ * where multicast is not available or too slow (e.g. loopback only setups).
+ * Frames are received on local_port from any peer.
+ */
+struct virt_um_inst *virt_um_init_unicast(void *ctx, uint16_t local_port, char **peers,
+					  unsigned int num_peers, uint16_t peer_port,
+					  virt_um_recv_cb_t *recv_cb)
+{
+	struct virt_um_inst *vui = talloc_zero(ctx, struct virt_um_inst);
+	unsigned int i;
+	int rc;
+
+	vui->transport = VIRT_UM_T_UNICAST;
+	vui->recv_cb = recv_cb;
+
+	vui->peers = talloc_zero_array(vui, struct sockaddr_in, num_peers);
+	for (i = 0; i < num_peers; i++) {
+		vui->peers[i].sin_family = AF_INET;
+		vui->peers[i].sin_port = htons(peer_port);
+		if (inet_pton(AF_INET, peers[i], &vui->peers[i].sin_addr) != 1) {
+			LOGP(DL1C, LOGL_ERROR, "Invalid Virtual Um unicast peer '%s'\n", peers[i]);
+			talloc_free(vui);
+			return NULL;
+		}
+	}
+	vui->num_peers = num_peers;
+
+	osmo_fd_setup(&vui->udp_ofd, -1, OSMO_FD_READ, virt_um_fd_cb, vui, 0);
+	rc = osmo_sock_init_ofd(&vui->udp_ofd, AF_INET, SOCK_DGRAM, IPPROTO_UDP,
+				"0.0.0.0", local_port, OSMO_SOCK_F_BIND);
+	if (rc < 0) {
+		perror("Unable to create VirtualUm unicast socket");
+		talloc_free(vui);
+		return NULL;
+	}
+
+	return vui;
+}
+
+/**
+ * Set up a Virtual Um interface over shared memory, see virt_um_shm.h.
+ * There is no file descriptor to wait for, the MS->BTS ring must be polled
+ * with virt_um_poll().
+ */
+struct virt_um_inst *virt_um_init_shm(void *ctx, const char *name, virt_um_recv_cb_t *recv_cb)
+{
+	struct virt_um_inst *vui = talloc_zero(ctx, struct virt_um_inst);
+
+	vui->transport = VIRT_UM_T_SHM;
+	vui->recv_cb = recv_cb;
+
+	vui->shm = virt_um_shm_open(vui, name);
+	if (!vui->shm) {
+		talloc_free(vui);
+		return NULL;
+	}
+
+	return vui;
+}
+
 void virt_um_destroy(struct virt_um_inst *vui)
 {
-	mcast_bidir_sock_close(vui->mcast_sock);
+	virt_um_set_batching(vui, false);
+	switch (vui->transport) {
+	case VIRT_UM_T_MULTICAST:
+		mcast_bidir_sock_close(vui->mcast_sock);
+		break;
+	case VIRT_UM_T_UNICAST:
+		osmo_fd_close(&vui->udp_ofd);
+		break;
+	case VIRT_UM_T_SHM:
+		virt_um_shm_close(vui->shm);
+		break;
+	}
 	talloc_free(vui);
 }
 
+static void virt_um_shm_rx_cb(const uint8_t *data, uint16_t len, void *cb_data)
+{
+	struct virt_um_inst *vui = cb_data;
+	struct msgb *msg;
+
+	if (len > VIRT_UM_MSGB_SIZE)
+		return;
+
+	msg = msgb_alloc(VIRT_UM_MSGB_SIZE, "Virtual UM Rx");
+	if (!msg)
+		return;
+	memcpy(msgb_put(msg, len), data, len);
+	msg->l1h = msgb_data(msg);
+	if (vui->recv_cb(vui, msg) < 0)
+		msgb_free(msg);
+}
+
 /**
- * Write msg to to multicast socket and free msg afterwards
+ * Read all messages available in the shared memory ring, to be called once
+ * per TDMA frame.  Returns the number of messages read.
  */
-int virt_um_write_msg(struct virt_um_inst *vui, struct msgb *msg)
+int virt_um_poll(struct virt_um_inst *vui)
 {
-	int rc;
+	if (vui->transport != VIRT_UM_T_SHM)
+		return 0;
+	return virt_um_shm_rx(vui->shm, virt_um_shm_rx_cb, vui);
+}
+
+/* Send one message (without freeing it) */
+static int virt_um_tx(struct virt_um_inst *vui, const struct msgb *msg)
+{
+	unsigned int i;
+	int rc = 0;
+
+	switch (vui->transport) {
+	case VIRT_UM_T_MULTICAST:
+		rc = mcast_bidir_sock_tx(vui->mcast_sock, msgb_data(msg), msgb_length(msg));
+		break;
+	case VIRT_UM_T_UNICAST:
+		for (i = 0; i < vui->num_peers; i++) {
+			rc = sendto(vui->udp_ofd.fd, msgb_data(msg), msgb_length(msg), 0,
+				    (const struct sockaddr *) &vui->peers[i], sizeof(vui->peers[i]));
+			if (rc < 0)
+				break;
+		}
+		break;
+	case VIRT_UM_T_SHM:
+		return virt_um_shm_tx(vui->shm, msgb_data(msg), msgb_length(msg));
+	}
 
-	rc = mcast_bidir_sock_tx(vui->mcast_sock, msgb_data(msg),
-	                msgb_length(msg));
 	if (rc < 0)
 		rc = -errno;
+	return rc;
+}
+
+/**
+ * Enable or disable batched I/O, see struct virt_um_batch.
+ */
+int virt_um_set_batching(struct virt_um_inst *vui, bool enable)
+{
+	struct virt_um_batch *vb = vui->batch;
+	unsigned int i;
+
+	if (enable) {
+		if (!vb)
+			vui->batch = talloc_zero(vui, struct virt_um_batch);
+		return vui->batch ? 0 : -ENOMEM;
+	}
+
+	if (!vb)
+		return 0;
+
+	virt_um_flush(vui);
+	for (i = 0; i < ARRAY_SIZE(vb->rx_msgs); i++) {
+		if (vb->rx_msgs[i])
+			msgb_free(vb->rx_msgs[i]);
+	}
+	talloc_free(vb);
+	vui->batch = NULL;
+
+	return 0;
+}
+
+/**
+ * Send all messages queued by virt_um_write_msg() and free them.
+ * Returns the number of messages sent, negative errno on error.
+ */
+int virt_um_flush(struct virt_um_inst *vui)
+{
+	struct virt_um_batch *vb = vui->batch;
+	unsigned int i, p;
+	int rc = 0;
+
+	if (!vb || !vb->tx_num)
+		return 0;
+
+	for (i = 0; i < vb->tx_num; i++) {
+		vb->tx_iov[i].iov_base = msgb_data(vb->tx_msgs[i]);
+		vb->tx_iov[i].iov_len = msgb_length(vb->tx_msgs[i]);
+		vb->tx_mmsg[i].msg_hdr = (struct msghdr) {
+			.msg_iov = &vb->tx_iov[i],
+			.msg_iovlen = 1,
+		};
+	}
+
+	/* like with unbatched sending, messages that could not be sent are lost */
+	switch (vui->transport) {
+	case VIRT_UM_T_MULTICAST:
+		rc = dgram_sock_txv(vui->mcast_sock->tx_ofd.fd, vb->tx_mmsg, vb->tx_num);
+		break;
+	case VIRT_UM_T_UNICAST:
+		/* one system call per peer */
+		rc = 0;
+		for (p = 0; p < vui->num_peers; p++) {
+			for (i = 0; i < vb->tx_num; i++) {
+				vb->tx_mmsg[i].msg_hdr.msg_name = &vui->peers[p];
+				vb->tx_mmsg[i].msg_hdr.msg_namelen = sizeof(vui->peers[p]);
+			}
+			rc = dgram_sock_txv(vui->udp_ofd.fd, vb->tx_mmsg, vb->tx_num);
+		}
+		break;
+	case VIRT_UM_T_SHM:
+		for (i = 0; i < vb->tx_num; i++) {
+			rc = virt_um_tx(vui, vb->tx_msgs[i]);
+			if (rc < 0)
+				break;
+		}
+		if (i > 0)
+			rc = i;
+		break;
+	}
+
+	for (i = 0; i < vb->tx_num; i++)
+		msgb_free(vb->tx_msgs[i]);
+	vb->tx_num = 0;
+
+	return rc;
+}
+
+/**
+ * Write msg to the Virtual Um and free msg afterwards.  With batching,
+ * msg is queued until the next virt_um_flush().
+ */
+int virt_um_write_msg(struct virt_um_inst *vui, struct msgb *msg)
+{
+	int rc;
+
+	if (vui->batch) {
+		struct virt_um_batch *vb = vui->batch;
+
+		rc = msgb_length(msg);
+		vb->tx_msgs[vb->tx_num++] = msg;
+		if (vb->tx_num == ARRAY_SIZE(vb->tx_msgs)) {
+			int flush_rc = virt_um_flush(vui);
+			if (flush_rc < 0)
+				return flush_rc;
+		}
+		return rc;
+	}
+
+	rc = virt_um_tx(vui, msg);
 	msgb_free(msg);
 
 	return rc;
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdbool.h>
+#include <netinet/in.h>
+
 #include <osmocom/core/select.h>
 #include <osmocom/core/msgb.h>
 #include "osmo_mcast_sock.h"
@@ -14,18 +17,53 @@
 #define DEFAULT_MS_MCAST_PORT 4729 /* IANA-registered port for GSMTAP */
 #define DEFAULT_BTS_MCAST_GROUP	"239.193.23.2"
 #define DEFAULT_BTS_MCAST_PORT 4729 /* IANA-registered port for GSMTAP */
+#define DEFAULT_SHM_NAME	"/osmo-bts-virtual-um"
+
+/* Maximum number of datagrams sent/received with one system call */
+#define VIRT_UM_BATCH_MAX	64
+
+struct virt_um_inst;
+struct virt_um_batch;
+struct virt_um_shm;
+
+enum virt_um_transport {
+	VIRT_UM_T_MULTICAST,	/* GSMTAP/UDP to/from multicast groups */
+	VIRT_UM_T_UNICAST,	/* GSMTAP/UDP to a list of peers */
+	VIRT_UM_T_SHM,		/* GSMTAP in shared memory rings, see virt_um_shm.h */
+};
+
+/* Called for each received message.  Returns 0 if the callee took ownership
+ * of msg, negative if msg was not used and remains owned by the caller. */
+typedef int virt_um_recv_cb_t(struct virt_um_inst *vui, struct msgb *msg);
 
 struct virt_um_inst {
 	void *priv;
+	enum virt_um_transport transport;
+	/* VIRT_UM_T_MULTICAST */
 	struct mcast_bidir_sock *mcast_sock;
-	void (*recv_cb)(struct virt_um_inst *vui, struct msgb *msg);
+	/* VIRT_UM_T_UNICAST */
+	struct osmo_fd udp_ofd;
+	struct sockaddr_in *peers;
+	unsigned int num_peers;
+	/* VIRT_UM_T_SHM */
+	struct virt_um_shm *shm;
+	virt_um_recv_cb_t *recv_cb;
+	/* batched I/O state, NULL if disabled */
+	struct virt_um_batch *batch;
 };
 
 struct virt_um_inst *virt_um_init(
                 void *ctx, char *tx_mcast_group, uint16_t tx_mcast_port,
                 char *rx_mcast_group, uint16_t rx_mcast_port, int ttl, const char *dev_name,
-                void (*recv_cb)(struct virt_um_inst *vui, struct msgb *msg));
+                virt_um_recv_cb_t *recv_cb);
+struct virt_um_inst *virt_um_init_unicast(
+		void *ctx, uint16_t local_port, char **peers, unsigned int num_peers,
+		uint16_t peer_port, virt_um_recv_cb_t *recv_cb);
+struct virt_um_inst *virt_um_init_shm(void *ctx, const char *name, virt_um_recv_cb_t *recv_cb);
 
 void virt_um_destroy(struct virt_um_inst *vui);
 
+int virt_um_set_batching(struct virt_um_inst *vui, bool enable);
 int virt_um_write_msg(struct virt_um_inst *vui, struct msgb *msg);
+int virt_um_flush(struct virt_um_inst *vui);
+int virt_um_poll(struct virt_um_inst *vui);
@@ -24,6 +24,7 @@
 #include <errno.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <string.h>
 
 #include <arpa/inet.h>
 
@@ -62,8 +63,17 @@ void bts_model_config_write_phy_inst(struct vty *vty, const struct phy_instance
 {
 }
 
+static const struct value_string virt_um_transport_names[] = {
+	{ VIRT_UM_T_MULTICAST,	"multicast" },
+	{ VIRT_UM_T_UNICAST,	"unicast" },
+	{ VIRT_UM_T_SHM,	"shm" },
+	{ 0, NULL }
+};
+
 void bts_model_config_write_phy(struct vty *vty, const struct phy_link *plink)
 {
+	unsigned int i;
+
 	if (plink->u.virt.mcast_dev)
 		vty_out(vty, " virtual-um net-device %s%s",
 			plink->u.virt.mcast_dev, VTY_NEWLINE);
@@ -82,7 +92,18 @@ void bts_model_config_write_phy(struct vty *vty, const struct phy_link *plink)
 	if (plink->u.virt.bts_mcast_port != DEFAULT_MS_MCAST_PORT)
 		vty_out(vty, " virtual-um bts-udp-port %u%s",
 			plink->u.virt.bts_mcast_port, VTY_NEWLINE);
-
+	if (plink->u.virt.batching)
+		vty_out(vty, " virtual-um batching enable%s", VTY_NEWLINE);
+	if (plink->u.virt.transport != VIRT_UM_T_MULTICAST)
+		vty_out(vty, " virtual-um transport %s%s",
+			get_value_string(virt_um_transport_names, plink->u.virt.transport),
+			VTY_NEWLINE);
+	for (i = 0; i < plink->u.virt.num_unicast_peers; i++)
+		vty_out(vty, " virtual-um unicast-peer %s%s",
+			plink->u.virt.unicast_peers[i], VTY_NEWLINE);
+	if (strcmp(plink->u.virt.shm_name, DEFAULT_SHM_NAME))
+		vty_out(vty, " virtual-um shm-name %s%s",
+			plink->u.virt.shm_name, VTY_NEWLINE);
 }
 
 #define VUM_STR	"Virtual Um layer\n"
@@ -189,6 +210,131 @@ DEFUN(cfg_phy_mcast_ttl, cfg_phy_mcast_ttl_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(cfg_phy_batching, cfg_phy_batching_cmd,
+	"virtual-um batching (enable|disable)",
+	VUM_STR "Send and receive several GSMTAP packets per system call\n"
+	"Use sendmmsg()/recvmmsg(), sending once per TDMA frame\n"
+	"Send and receive each packet on its own (default)\n")
+{
+	struct phy_link *plink = vty->index;
+
+	if (plink->state != PHY_LINK_SHUTDOWN) {
+		vty_out(vty, "Can only reconfigure a PHY link that is down%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	plink->u.virt.batching = (strcmp(argv[0], "enable") == 0);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_phy_transport, cfg_phy_transport_cmd,
+	"virtual-um transport (multicast|unicast|shm)",
+	VUM_STR "Configure how GSMTAP frames are exchanged with the MS side\n"
+	"UDP to/from the multicast groups (default)\n"
+	"UDP to the configured unicast peers, received on the BTS UDP port\n"
+	"Rings in a POSIX shared memory object, for simulators on the same host\n")
+{
+	struct phy_link *plink = vty->index;
+
+	if (plink->state != PHY_LINK_SHUTDOWN) {
+		vty_out(vty, "Can only reconfigure a PHY link that is down%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	plink->u.virt.transport = get_string_value(virt_um_transport_names, argv[0]);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_phy_unicast_peer, cfg_phy_unicast_peer_cmd,
+	"virtual-um unicast-peer A.B.C.D",
+	VUM_STR "Add a peer receiving frames on the MS UDP port (unicast transport)\n"
+	"IPv4 address of the peer\n")
+{
+	struct phy_link *plink = vty->index;
+	unsigned int i;
+	char **peers;
+
+	if (plink->state != PHY_LINK_SHUTDOWN) {
+		vty_out(vty, "Can only reconfigure a PHY link that is down%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	for (i = 0; i < plink->u.virt.num_unicast_peers; i++) {
+		if (!strcmp(plink->u.virt.unicast_peers[i], argv[0]))
+			return CMD_SUCCESS;
+	}
+
+	peers = talloc_realloc(plink, plink->u.virt.unicast_peers, char *, i + 1);
+	if (!peers)
+		return CMD_WARNING;
+	peers[i] = talloc_strdup(peers, argv[0]);
+	plink->u.virt.unicast_peers = peers;
+	plink->u.virt.num_unicast_peers = i + 1;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_phy_no_unicast_peer, cfg_phy_no_unicast_peer_cmd,
+	"no virtual-um unicast-peer A.B.C.D",
+	NO_STR VUM_STR "Remove a unicast peer\n"
+	"IPv4 address of the peer\n")
+{
+	struct phy_link *plink = vty->index;
+	char **peers = plink->u.virt.unicast_peers;
+	unsigned int i;
+
+	if (plink->state != PHY_LINK_SHUTDOWN) {
+		vty_out(vty, "Can only reconfigure a PHY link that is down%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	for (i = 0; i < plink->u.virt.num_unicast_peers; i++) {
+		if (!strcmp(peers[i], argv[0]))
+			break;
+	}
+	if (i == plink->u.virt.num_unicast_peers) {
+		vty_out(vty, "%% No such unicast peer: %s%s", argv[0], VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	talloc_free(peers[i]);
+	memmove(&peers[i], &peers[i + 1],
+		(plink->u.virt.num_unicast_peers - i - 1) * sizeof(peers[0]));
+	plink->u.virt.num_unicast_peers--;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_phy_shm_name, cfg_phy_shm_name_cmd,
+	"virtual-um shm-name NAME",
+	VUM_STR "Configure the shared memory object (shm transport)\n"
+	"Name as passed to shm_open(), e.g. " DEFAULT_SHM_NAME "\n")
+{
+	struct phy_link *plink = vty->index;
+
+	if (plink->state != PHY_LINK_SHUTDOWN) {
+		vty_out(vty, "Can only reconfigure a PHY link that is down%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	if (argv[0][0] != '/' || strchr(argv[0] + 1, '/')) {
+		vty_out(vty, "%% The name must start with '/' and contain no other '/'%s",
+			VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	osmo_talloc_replace_string(plink, &plink->u.virt.shm_name, argv[0]);
+
+	return CMD_SUCCESS;
+}
+
 int bts_model_vty_init(void *ctx)
 {
 	install_element(PHY_NODE, &cfg_phy_ms_mcast_group_cmd);
@@ -197,6 +343,11 @@ int bts_model_vty_init(void *ctx)
 	install_element(PHY_NODE, &cfg_phy_bts_mcast_port_cmd);
 	install_element(PHY_NODE, &cfg_phy_mcast_dev_cmd);
 	install_element(PHY_NODE, &cfg_phy_mcast_ttl_cmd);
+	install_element(PHY_NODE, &cfg_phy_batching_cmd);
+	install_element(PHY_NODE, &cfg_phy_transport_cmd);
+	install_element(PHY_NODE, &cfg_phy_unicast_peer_cmd);
+	install_element(PHY_NODE, &cfg_phy_no_unicast_peer_cmd);
+	install_element(PHY_NODE, &cfg_phy_shm_name_cmd);
 
 	return 0;
 }
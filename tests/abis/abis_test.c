@@ -0,0 +1,206 @@
+/* Test cases for the coalescing of RSL messages towards the BSC */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/application.h>
+#include <osmocom/abis/e1_input.h>
+#include <osmocom/gsm/gsm0502.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+
+#include <osmo-bts/abis.h>
+#include <osmo-bts/bts.h>
+#include <osmo-bts/bts_trx.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/gsm_data.h>
+
+#define MSG_LEN		200
+
+static struct gsm_bts *bts;
+static struct gsm_bts_trx *trx;
+static struct e1inp_sign_link *rsl_link;
+
+static unsigned int tx_count;
+static unsigned int tx_errors;
+static bool tx_verbose;
+
+/* libosmo-abis would queue the message on the signalling link */
+int abis_sendmsg(struct msgb *msg)
+{
+	if (tx_verbose)
+		printf("  abis_sendmsg(msg_type=0x%02x, %u)\n", msg->data[1], msg->data[2]);
+	if (msg->dst != rsl_link || msg->data[2] != tx_count)
+		tx_errors++;
+	tx_count++;
+	msgb_free(msg);
+	return 0;
+}
+
+static void start(bool verbose)
+{
+	rsl_link = talloc_zero(tall_bts_ctx, struct e1inp_sign_link);
+	trx->rsl_link = rsl_link;
+	bts->rsl_tx_coalesce_us = GSM_TDMA_FN_DURATION_uS;
+	tx_count = tx_errors = 0;
+	tx_verbose = verbose;
+}
+
+static void stop(void)
+{
+	abis_rsl_tx_discard(trx);
+	trx->rsl_link = NULL;
+	TALLOC_FREE(rsl_link);
+}
+
+/* RSL message i: MSG_LEN bytes, the message type followed by i */
+static void send_rsl(uint8_t msg_type, uint8_t i)
+{
+	struct msgb *msg = msgb_alloc(MSG_LEN, __func__);
+	uint8_t *data = msgb_put(msg, MSG_LEN);
+
+	data[0] = msg_type == RSL_MT_CHAN_RQD ? ABIS_RSL_MDISC_COM_CHAN : ABIS_RSL_MDISC_DED_CHAN;
+	data[1] = msg_type;
+	memset(data + 2, i, MSG_LEN - 2);
+
+	msg->trx = trx;
+	abis_bts_rsl_sendmsg(msg);
+}
+
+static void print_state(const char *what)
+{
+	printf("  %s: queued %u, sent %u, %u errors, timer %s\n", what, trx->rsl_tx.num,
+	       tx_count, tx_errors, osmo_timer_pending(&trx->rsl_tx.timer) ? "running" : "stopped");
+}
+
+static void test_rsl_tx_urgent(void)
+{
+	printf("Testing coalescing of RSL messages up to an urgent one.\n");
+	start(true);
+
+	send_rsl(RSL_MT_MEAS_RES, 0);
+	send_rsl(RSL_MT_MEAS_RES, 1);
+	send_rsl(RSL_MT_MEAS_RES, 2);
+	print_state("3 MEAS RES");
+
+	/* sent right away, after the queued ones */
+	send_rsl(RSL_MT_CHAN_RQD, 3);
+	print_state("CHAN RQD");
+
+	stop();
+}
+
+static void test_rsl_tx_window(void)
+{
+	printf("Testing coalescing of RSL messages within a window.\n");
+	start(true);
+
+	send_rsl(RSL_MT_MEAS_RES, 0);
+	send_rsl(RSL_MT_MEAS_RES, 1);
+	print_state("2 MEAS RES");
+
+	while (osmo_timer_pending(&trx->rsl_tx.timer))
+		osmo_select_main(0);
+	print_state("window expired");
+
+	stop();
+}
+
+static void test_rsl_tx_limit(void)
+{
+	unsigned int i;
+
+	printf("Testing coalescing of RSL messages up to the size limit.\n");
+	start(false);
+
+	/* the last one exceeds RSL_TX_COALESCE_MAX_LEN */
+	for (i = 0; i < 20; i++)
+		send_rsl(RSL_MT_MEAS_RES, i);
+	print_state("20 MEAS RES");
+	send_rsl(RSL_MT_MEAS_RES, 20);
+	print_state("21 MEAS RES");
+
+	stop();
+}
+
+static void test_rsl_tx_disable(void)
+{
+	printf("Testing disabling the coalescing of RSL messages.\n");
+	start(true);
+
+	send_rsl(RSL_MT_MEAS_RES, 0);
+	send_rsl(RSL_MT_MEAS_RES, 1);
+	bts->rsl_tx_coalesce_us = 0;
+	send_rsl(RSL_MT_MEAS_RES, 2);
+	print_state("disabled");
+
+	stop();
+}
+
+static void test_rsl_tx_link_down(void)
+{
+	printf("Testing RSL messages queued when the link goes down.\n");
+	start(true);
+
+	send_rsl(RSL_MT_MEAS_RES, 0);
+	send_rsl(RSL_MT_MEAS_RES, 1);
+	stop();
+	print_state("link down");
+}
+
+static void test_rsl_tx_ctrs(void)
+{
+	printf("Testing RSL coalescing counters.\n");
+	printf("  batches %" PRIu64 ", messages %" PRIu64 "\n",
+	       rate_ctr_group_get_ctr(bts->ctrs, BTS_CTR_RSL_TX_BATCHES)->current,
+	       rate_ctr_group_get_ctr(bts->ctrs, BTS_CTR_RSL_TX_MSGS)->current);
+}
+
+int main(int argc, char **argv)
+{
+	tall_bts_ctx = talloc_named_const(NULL, 1, "OsmoBTS context");
+	msgb_talloc_ctx_init(tall_bts_ctx, 0);
+
+	osmo_init_logging2(tall_bts_ctx, &bts_log_info);
+
+	bts = gsm_bts_alloc(tall_bts_ctx, 0);
+	if (bts_init(bts) < 0) {
+		fprintf(stderr, "unable to open bts\n");
+		exit(1);
+	}
+	trx = bts->c0;
+
+	test_rsl_tx_urgent();
+	test_rsl_tx_window();
+	test_rsl_tx_limit();
+	test_rsl_tx_disable();
+	test_rsl_tx_link_down();
+	test_rsl_tx_ctrs();
+	printf("Success\n");
+
+	return 0;
+}
@@ -21,10 +21,12 @@
  */
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/application.h>
+#include <osmocom/gsm/gsm0502.h>
 
 #include <osmo-bts/bts.h>
 #include <osmo-bts/logging.h>
 #include <osmo-bts/gsm_data.h>
+#include <osmo-bts/paging.h>
 
 #include <inttypes.h>
 #include <unistd.h>
@@ -158,7 +160,7 @@ static void test_agch_queue(void)
 		if (is_agch)
 			multiframes++;
 
-		rc = bts_ccch_copy_msg(bts, out_buf, &g_time, is_agch);
+		rc = bts_ccch_copy_msg(bts, out_buf, &g_time, is_agch, NULL);
 		ima = (struct gsm48_imm_ass *)out_buf;
 		switch (ima->msg_type) {
 		case GSM48_MT_RR_IMM_ASS:
@@ -188,6 +190,163 @@ static void test_agch_queue(void)
 	       bts->agch_queue.pch_msgs);
 }
 
+static void test_agch_queue_imm_ass_ext(void)
+{
+	struct gsm48_imm_ass *ima;
+	struct msgb *msg;
+	const uint8_t *data;
+	int idx;
+
+	printf("Testing AGCH IMM.ASS.EXT packing.\n");
+	bts->agch_queue.imm_ass_ext = true;
+	bts->agch_queue.merged_imm_ass_msgs = 0;
+
+	/* two IMM.ASS followed by an IMM.ASS.REJ and another IMM.ASS */
+	for (idx = 1; idx <= 4; idx++) {
+		msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+		if (idx == 3)
+			put_imm_ass_rej(msg, idx, 10);
+		else
+			put_imm_ass(msg, idx);
+		bts_agch_enqueue(bts, msg);
+	}
+
+	printf("AGCH filled: occupied %d, merged imm.ass %"PRIu64"\n",
+	       bts->agch_queue.length, bts->agch_queue.merged_imm_ass_msgs);
+
+	while ((msg = bts_agch_dequeue(bts))) {
+		ima = msgb_l3(msg);
+		data = msgb_l3(msg);
+		printf("  msg_type 0x%02x (%u): %s\n", ima->msg_type, msgb_l3len(msg),
+		       osmo_hexdump_nospc(data, msgb_l3len(msg)));
+		msgb_free(msg);
+	}
+
+	bts->agch_queue.imm_ass_ext = false;
+}
+
+static void test_agch_pch_preempt(void)
+{
+	static const uint8_t tmsi_lv[] = { 0x05, 0xf4, 0xde, 0xad, 0xbe, 0xef };
+	uint8_t out_buf[GSM_MACBLOCK_LEN];
+	struct gsm_time g_time;
+	struct msgb *msg;
+	int rc, i;
+
+	printf("Testing AGCH preemption of repeated paging on PCH.\n");
+
+	/* PCH block of paging group 0 */
+	gsm_fn2gsmtime(&g_time, 6);
+
+	paging_set_lifetime(bts->paging_state, 60);
+	rc = paging_add_identity(bts->paging_state, 0, tmsi_lv, 0);
+	OSMO_ASSERT(rc == 0);
+
+	for (i = 0; i < 3; i++) {
+		bts->agch_queue.pch_preempt = (i == 2);
+
+		msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+		put_imm_ass(msg, i);
+		bts_agch_enqueue(bts, msg);
+
+		rc = bts_ccch_copy_msg(bts, out_buf, &g_time, 0, NULL);
+		printf("  pch-preempt %d: msg_type 0x%02x, AGCH queue %d\n",
+		       bts->agch_queue.pch_preempt, out_buf[2], bts->agch_queue.length);
+	}
+
+	/* after two consecutive blocks, one is used for the repeated paging;
+	 * once the AGCH queue is drained, it is sent again anyway */
+	for (i = 0; i < 4; i++) {
+		rc = bts_ccch_copy_msg(bts, out_buf, &g_time, 0, NULL);
+		printf("  pch-preempt %d: msg_type 0x%02x, AGCH queue %d\n",
+		       bts->agch_queue.pch_preempt, out_buf[2], bts->agch_queue.length);
+	}
+
+	bts->agch_queue.pch_preempt = false;
+	paging_reset(bts->paging_state);
+	while ((msg = bts_agch_dequeue(bts)))
+		msgb_free(msg);
+}
+
+static void put_imm_ass_rach_fn(struct msgb *msg, uint32_t rach_fn)
+{
+	struct gsm48_imm_ass *ima;
+	struct gsm_time gt;
+
+	put_imm_ass(msg, 0);
+	ima = msgb_l3(msg);
+
+	gsm_fn2gsmtime(&gt, rach_fn);
+	ima->req_ref.t1 = gt.t1;
+	ima->req_ref.t2 = gt.t2;
+	ima->req_ref.t3_high = gt.t3 >> 3;
+	ima->req_ref.t3_low = gt.t3 & 0x07;
+}
+
+static void agch_deadline_tx(uint32_t fn)
+{
+	uint8_t out_buf[GSM_MACBLOCK_LEN];
+	struct gsm48_imm_ass *ima = (struct gsm48_imm_ass *)out_buf;
+	uint64_t dropped = bts->agch_queue.dropped_msgs;
+	struct gsm_time g_time;
+	int rc;
+
+	gsm_fn2gsmtime(&g_time, fn);
+	rc = bts_ccch_copy_msg(bts, out_buf, &g_time, 1, NULL);
+	if (rc > 0) {
+		struct gsm_time rach_time = {
+			.t1 = ima->req_ref.t1,
+			.t2 = ima->req_ref.t2,
+			.t3 = (ima->req_ref.t3_high << 3) | ima->req_ref.t3_low,
+		};
+		printf("  FN %u: sent RACH FN %u, dropped %"PRIu64", occupied %d\n",
+		       fn, gsm_gsmtime2fn(&rach_time),
+		       bts->agch_queue.dropped_msgs - dropped, bts->agch_queue.length);
+	} else {
+		printf("  FN %u: sent nothing, dropped %"PRIu64", occupied %d\n",
+		       fn, bts->agch_queue.dropped_msgs - dropped, bts->agch_queue.length);
+	}
+}
+
+static void test_agch_queue_deadline(void)
+{
+	static const uint32_t rach_fns[] = { 1000, 1050, 1150 };
+	struct msgb *msg;
+	int i;
+
+	printf("Testing AGCH queue deadline.\n");
+	bts->agch_queue.deadline_fn = 100;
+
+	for (i = 0; i < ARRAY_SIZE(rach_fns); i++) {
+		msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+		put_imm_ass_rach_fn(msg, rach_fns[i]);
+		bts_agch_enqueue(bts, msg);
+	}
+
+	/* the response to RACH FN 1000 is too late, the next one is not */
+	agch_deadline_tx(1120);
+	/* the response to RACH FN 1150 is too late */
+	agch_deadline_tx(1300);
+
+	/* the Request Reference wraps around every 42432 frames */
+	msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+	put_imm_ass_rach_fn(msg, 42400);
+	bts_agch_enqueue(bts, msg);
+	agch_deadline_tx(42432 + 50);
+
+	/* and so does the TDMA frame number, across the hyperframe boundary */
+	msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+	put_imm_ass_rach_fn(msg, GSM_TDMA_HYPERFRAME - 20);
+	bts_agch_enqueue(bts, msg);
+	msg = msgb_alloc(GSM_MACBLOCK_LEN, __FUNCTION__);
+	put_imm_ass_rach_fn(msg, 10);
+	bts_agch_enqueue(bts, msg);
+	agch_deadline_tx(30);
+	agch_deadline_tx(150);
+
+	bts->agch_queue.deadline_fn = 0;
+}
+
 static void test_agch_queue_length_computation(void)
 {
 	static const int ccch_configs[] = {
@@ -233,6 +392,9 @@ int main(int argc, char **argv)
 
 	test_agch_queue_length_computation();
 	test_agch_queue();
+	test_agch_queue_imm_ass_ext();
+	test_agch_pch_preempt();
+	test_agch_queue_deadline();
 	printf("Success\n");
 
 	return 0;
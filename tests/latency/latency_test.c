@@ -0,0 +1,222 @@
+/* Test cases for the Downlink latency accounting of RLL messages */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/application.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/latency.h>
+
+static struct gsm_lchan lchan;
+
+/* LAPDm frames as sent by the BTS (C/R = 1), header octets only */
+static void i_frame(uint8_t *frame, uint8_t sapi, uint8_t ns, bool more)
+{
+	frame[0] = (sapi << 2) | 0x03;
+	frame[1] = ns << 1;
+	frame[2] = (20 << 2) | (more << 1) | 0x01;
+}
+
+static void ui_frame(uint8_t *frame, uint8_t sapi, uint8_t len)
+{
+	frame[0] = (sapi << 2) | 0x03;
+	frame[1] = 0x03;
+	frame[2] = (len << 2) | 0x01;
+}
+
+static void rr_frame(uint8_t *frame, uint8_t sapi, uint8_t nr)
+{
+	frame[0] = (sapi << 2) | 0x03;
+	frame[1] = (nr << 5) | 0x01;
+	frame[2] = 0x01;
+}
+
+static void pop(const uint8_t *frame, bool sacch)
+{
+	struct msgb *msg = msgb_alloc(GSM_MACBLOCK_LEN, "PH-DATA.req");
+
+	OSMO_ASSERT(msg);
+	msgb_dl_lat_ts(msg) = 0;
+
+	bts_dl_lat_rll_pop(&lchan, frame, 3, sacch, msg);
+
+	printf("  %s %02x %02x %02x -> ", sacch ? "SACCH" : "DCCH ",
+	       frame[0], frame[1], frame[2]);
+	if (msgb_dl_lat_ts(msg))
+		printf("%lu (%s)\n", msgb_dl_lat_ts(msg),
+		       get_value_string(bts_lat_sapi_names, msgb_dl_lat_sapi(msg)));
+	else
+		printf("not stamped\n");
+
+	msgb_free(msg);
+}
+
+static void test_ui(void)
+{
+	uint8_t frame[3];
+
+	printf("Testing UI frames\n");
+	bts_dl_lat_rll_reset(&lchan);
+
+	bts_dl_lat_rll_push(&lchan, false, 0, 100);
+	bts_dl_lat_rll_push(&lchan, false, 0, 200);
+	/* not stamped: fill frame, supervisory frame */
+	ui_frame(frame, 0, 0);
+	pop(frame, false);
+	ui_frame(frame, 0, 18);
+	pop(frame, false);
+	rr_frame(frame, 0, 1);
+	pop(frame, false);
+	ui_frame(frame, 0, 18);
+	pop(frame, false);
+	/* nothing left */
+	ui_frame(frame, 0, 18);
+	pop(frame, false);
+}
+
+static void test_segmentation(void)
+{
+	uint8_t frame[3];
+	unsigned int i;
+
+	printf("Testing segmented I frames\n");
+	bts_dl_lat_rll_reset(&lchan);
+
+	bts_dl_lat_rll_push(&lchan, false, 0, 1000);
+	bts_dl_lat_rll_push(&lchan, false, 0, 2000);
+	bts_dl_lat_rll_push(&lchan, false, 0, 3000);
+
+	/* three segments */
+	i_frame(frame, 0, 0, true);
+	pop(frame, false);
+	i_frame(frame, 0, 1, true);
+	pop(frame, false);
+	i_frame(frame, 0, 2, false);
+	pop(frame, false);
+	/* one segment */
+	i_frame(frame, 0, 3, false);
+	pop(frame, false);
+	/* eight segments, the last one repeats the N(S) of the previous
+	 * message modulo 8 */
+	for (i = 4; i < 4 + 8; i++) {
+		i_frame(frame, 0, i % 8, i < 4 + 7);
+		pop(frame, false);
+	}
+}
+
+static void test_retransmission(void)
+{
+	uint8_t frame[3];
+
+	printf("Testing retransmitted I frames\n");
+	bts_dl_lat_rll_reset(&lchan);
+
+	bts_dl_lat_rll_push(&lchan, false, 0, 100);
+	bts_dl_lat_rll_push(&lchan, false, 0, 200);
+
+	i_frame(frame, 0, 0, false);
+	pop(frame, false);
+	pop(frame, false);
+	i_frame(frame, 0, 1, true);
+	pop(frame, false);
+	pop(frame, false);
+	i_frame(frame, 0, 2, false);
+	pop(frame, false);
+	pop(frame, false);
+}
+
+static void test_entities(void)
+{
+	uint8_t frame[3];
+
+	printf("Testing separate LAPDm entities and SAPIs\n");
+	bts_dl_lat_rll_reset(&lchan);
+
+	bts_dl_lat_rll_push(&lchan, true, 0, 10);
+	bts_dl_lat_rll_push(&lchan, false, 3, 20);
+	bts_dl_lat_rll_push(&lchan, false, 0, 30);
+	/* unknown SAPI, not stamped */
+	bts_dl_lat_rll_push(&lchan, false, 1, 40);
+	/* not stamped on arrival */
+	bts_dl_lat_rll_push(&lchan, false, 0, 0);
+
+	i_frame(frame, 0, 0, false);
+	pop(frame, false);
+	i_frame(frame, 0, 1, false);
+	pop(frame, false);
+	i_frame(frame, 3, 0, false);
+	pop(frame, false);
+	ui_frame(frame, 0, 18);
+	pop(frame, true);
+	ui_frame(frame, 1, 18);
+	pop(frame, false);
+}
+
+static void test_overflow_reset(void)
+{
+	uint8_t frame[3];
+	unsigned int i;
+
+	printf("Testing FIFO overflow and reset\n");
+	bts_dl_lat_rll_reset(&lchan);
+
+	/* the oldest entry is dropped */
+	for (i = 1; i <= BTS_DL_LAT_RLL_DEPTH + 1; i++)
+		bts_dl_lat_rll_push(&lchan, false, 0, i);
+	for (i = 0; i <= BTS_DL_LAT_RLL_DEPTH; i++) {
+		i_frame(frame, 0, i, false);
+		pop(frame, false);
+	}
+
+	/* a new data link starts over with N(S) = 0 */
+	bts_dl_lat_rll_push(&lchan, false, 3, 500);
+	bts_dl_lat_rll_push(&lchan, false, 0, 600);
+	bts_dl_lat_rll_push(&lchan, false, 0, 700);
+	bts_dl_lat_rll_reset_sapi(&lchan, false, 0);
+	bts_dl_lat_rll_push(&lchan, false, 0, 800);
+	i_frame(frame, 0, 0, false);
+	pop(frame, false);
+	i_frame(frame, 3, 0, false);
+	pop(frame, false);
+}
+
+int main(int argc, char **argv)
+{
+	tall_bts_ctx = talloc_named_const(NULL, 1, "OsmoBTS context");
+	msgb_talloc_ctx_init(tall_bts_ctx, 0);
+	osmo_init_logging2(tall_bts_ctx, &bts_log_info);
+
+	test_ui();
+	test_segmentation();
+	test_retransmission();
+	test_entities();
+	test_overflow_reset();
+
+	printf("Success\n");
+
+	return 0;
+}
@@ -144,8 +144,11 @@ static void test_sacch_get(void)
 
 	/* initialize the input. */
 	for (i = 1; i < _MAX_SYSINFO_TYPE; ++i) {
+		struct gsm_sacch_si *si = sacch_si_alloc(ctx);
+		memset(si->buf, i, GSM_MACBLOCK_LEN);
 		lchan.si.valid |= (1 << i);
-		memset(GSM_LCHAN_SI(&lchan, i), i, GSM_MACBLOCK_LEN);
+		lchan_sacch_si_set(&lchan, i, si);
+		sacch_si_put(si);
 	}
 
 	/* It will start with '1' */
@@ -158,6 +161,41 @@ static void test_sacch_get(void)
 		//printf("i=%d (%%=%d) -> data[0]=%d\n", i, off, data[0]);
 		OSMO_ASSERT(data[0] == off);
 	}
+
+	for (i = 1; i < _MAX_SYSINFO_TYPE; ++i)
+		lchan_sacch_si_set(&lchan, i, NULL);
+}
+
+static void test_sacch_si_shared(void)
+{
+	struct gsm_lchan lchan[2];
+	struct gsm_sacch_si *si;
+	size_t num_blocks = talloc_total_blocks(ctx);
+
+	printf("Testing shared SACCH SI buffers\n");
+	memset(lchan, 0, sizeof(lchan));
+
+	si = sacch_si_alloc(ctx);
+	memset(si->buf, 0x2b, GSM_MACBLOCK_LEN);
+	lchan_sacch_si_set(&lchan[0], SYSINFO_TYPE_5, si);
+	lchan_sacch_si_set(&lchan[1], SYSINFO_TYPE_5, si);
+	OSMO_ASSERT(si->refcnt == 3);
+	OSMO_ASSERT(lchan[0].si.sacch[SYSINFO_TYPE_5] == lchan[1].si.sacch[SYSINFO_TYPE_5]);
+
+	/* dropping the original reference keeps the buffer alive */
+	sacch_si_put(si);
+	OSMO_ASSERT(si->refcnt == 2);
+
+	lchan_sacch_si_set(&lchan[0], SYSINFO_TYPE_5, NULL);
+	OSMO_ASSERT(si->refcnt == 1);
+	OSMO_ASSERT(GSM_LCHAN_SI(&lchan[0], SYSINFO_TYPE_5) == NULL);
+	OSMO_ASSERT(*(uint8_t *) GSM_LCHAN_SI(&lchan[1], SYSINFO_TYPE_5) == 0x2b);
+
+	/* releasing the lchan drops its references */
+	lchan[1].si.valid = (1 << SYSINFO_TYPE_5);
+	lchan_sacch_si_release(&lchan[1]);
+	OSMO_ASSERT(lchan[1].si.valid == 0);
+	OSMO_ASSERT(talloc_total_blocks(ctx) == num_blocks);
 }
 
 static void test_bts_supports_cm(void)
@@ -216,6 +254,7 @@ int main(int argc, char **argv)
 	osmo_init_logging2(ctx, &bts_log_info);
 
 	test_sacch_get();
+	test_sacch_si_shared();
 	test_msg_utils_ipa();
 	test_msg_utils_oml();
 	test_bts_supports_cm();
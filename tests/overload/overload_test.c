@@ -0,0 +1,231 @@
+/* Test cases for the overload shedding controller */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/application.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/bts.h>
+#include <osmo-bts/bts_trx.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/overload.h>
+
+static struct gsm_bts *bts;
+static struct gsm_bts_trx *trx;
+static unsigned int fn_count;
+
+/* one frame clock tick, print the level changes */
+static void tick(uint32_t proc_us, unsigned int missed_fn)
+{
+	enum bts_ovld_level old = bts->ovld.level;
+
+	bts_ovld_fn(bts, proc_us, missed_fn);
+	fn_count++;
+
+	if (bts->ovld.level != old)
+		printf("  fn %u: avg %u us, level %s -> %s\n", fn_count, bts->ovld.avg_us,
+		       get_value_string(bts_ovld_level_names, old),
+		       get_value_string(bts_ovld_level_names, bts->ovld.level));
+}
+
+static void ticks(unsigned int num, uint32_t proc_us)
+{
+	while (num-- > 0)
+		tick(proc_us, 0);
+}
+
+static void start(void)
+{
+	bts_ovld_reset(bts);
+	fn_count = 0;
+}
+
+static unsigned long ctr(unsigned int idx)
+{
+	return rate_ctr_group_get_ctr(bts->ctrs, idx)->current;
+}
+
+static void test_raise(void)
+{
+	printf("Testing raising the level\n");
+	start();
+
+	/* below the high threshold of 3461 us */
+	ticks(100, 3400);
+	ticks(200, 4000);
+	printf("  frames shed: gsmtap %lu, logging %lu, interf %lu, meas-res %lu\n",
+	       ctr(BTS_CTR_OVLD_GSMTAP), ctr(BTS_CTR_OVLD_LOGGING),
+	       ctr(BTS_CTR_OVLD_INTERF), ctr(BTS_CTR_OVLD_MEAS_RES));
+}
+
+static void test_missed_tick(void)
+{
+	printf("Testing missed frame clock ticks\n");
+	start();
+
+	ticks(10, 1000);
+	tick(1000, 1);
+	tick(1000, 3);
+	ticks(10, 1000);
+}
+
+static void test_lower(void)
+{
+	printf("Testing lowering the level\n");
+	start();
+
+	tick(1000, 1);
+	tick(1000, 1);
+	tick(1000, 1);
+	tick(1000, 1);
+	/* between the low and the high threshold: no change */
+	ticks(500, 3000);
+	/* below the low threshold of 1846 us */
+	ticks(1000, 1000);
+}
+
+static void test_log_shed(void)
+{
+	printf("Testing shedding the logging\n");
+	log_set_log_level(osmo_stderr_target, LOGL_INFO);
+
+	start();
+	tick(1000, 1);
+	tick(1000, 1);
+	printf("  shed: %s\n", log_level_str(osmo_stderr_target->loglevel));
+	bts_ovld_reset(bts);
+	printf("  restored: %s\n", log_level_str(osmo_stderr_target->loglevel));
+
+	/* changed on the VTY meanwhile */
+	start();
+	tick(1000, 1);
+	tick(1000, 1);
+	log_set_log_level(osmo_stderr_target, LOGL_ERROR);
+	bts_ovld_reset(bts);
+	printf("  changed: %s\n", log_level_str(osmo_stderr_target->loglevel));
+
+	log_set_log_level(osmo_stderr_target, LOGL_INFO);
+}
+
+static void defer_meas_res(const struct gsm_lchan *lchan)
+{
+	struct msgb *msg = msgb_alloc(64, "MEAS RES");
+	struct abis_rsl_dchan_hdr *dch;
+
+	OSMO_ASSERT(msg);
+	dch = (struct abis_rsl_dchan_hdr *) msgb_put(msg, sizeof(*dch));
+	dch->c.msg_discr = ABIS_RSL_MDISC_DED_CHAN;
+	dch->c.msg_type = RSL_MT_MEAS_RES;
+	dch->ie_chan = RSL_IE_CHAN_NR;
+	dch->chan_nr = gsm_lchan2chan_nr(lchan);
+	msg->trx = lchan->ts->trx;
+
+	bts_ovld_meas_res_defer(bts, msg);
+}
+
+static void test_meas_res(void)
+{
+	struct gsm_lchan *lchan2 = &trx->ts[2].lchan[0];
+	struct gsm_lchan *lchan3 = &trx->ts[3].lchan[0];
+	unsigned int i;
+
+	printf("Testing deferred MEAS RES\n");
+	start();
+
+	tick(1000, 1);
+	tick(1000, 1);
+	tick(1000, 1);
+	tick(1000, 1);
+
+	for (i = 0; i < 10; i++)
+		defer_meas_res(lchan2);
+	printf("  queued: %u\n", bts->ovld.meas_res_queue_len);
+	for (i = 0; i < 4; i++) {
+		tick(1000, 0);
+		printf("  queued: %u\n", bts->ovld.meas_res_queue_len);
+	}
+
+	/* those of a deactivated lchan are dropped */
+	for (i = 0; i < 3; i++) {
+		defer_meas_res(lchan2);
+		defer_meas_res(lchan3);
+	}
+	lchan_set_state(lchan2, LCHAN_S_NONE);
+	printf("  queued after release: %u\n", bts->ovld.meas_res_queue_len);
+	tick(1000, 0);
+	printf("  queued: %u\n", bts->ovld.meas_res_queue_len);
+
+	/* the oldest are dropped when the queue is full */
+	for (i = 0; i < 260; i++)
+		defer_meas_res(lchan3);
+	printf("  queued: %u, dropped %lu\n", bts->ovld.meas_res_queue_len,
+	       ctr(BTS_CTR_OVLD_MEAS_RES_DROP));
+
+	/* all of them are sent when leaving the level */
+	bts_ovld_reset(bts);
+	printf("  queued after reset: %u\n", bts->ovld.meas_res_queue_len);
+}
+
+int main(int argc, char **argv)
+{
+	tall_bts_ctx = talloc_named_const(NULL, 1, "OsmoBTS context");
+	msgb_talloc_ctx_init(tall_bts_ctx, 0);
+	osmo_init_logging2(tall_bts_ctx, &bts_log_info);
+
+	bts = gsm_bts_alloc(tall_bts_ctx, 0);
+	if (!bts) {
+		fprintf(stderr, "Failed to create BTS structure\n");
+		exit(1);
+	}
+	if (bts_init(bts) < 0) {
+		fprintf(stderr, "unable to init BTS\n");
+		exit(1);
+	}
+	trx = gsm_bts_trx_alloc(bts);
+	if (!trx) {
+		fprintf(stderr, "Failed to alloc TRX structure\n");
+		exit(1);
+	}
+	trx->ts[2].pchan = GSM_PCHAN_TCH_F;
+	trx->ts[3].pchan = GSM_PCHAN_TCH_F;
+
+	/* MEAS RES are freed instead of being sent */
+	bts->variant = BTS_OSMO_OMLDUMMY;
+	bts->ovld.enabled = true;
+
+	test_raise();
+	test_missed_tick();
+	test_lower();
+	test_log_shed();
+	test_meas_res();
+
+	printf("Success\n");
+
+	return 0;
+}
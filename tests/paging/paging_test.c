@@ -27,7 +27,6 @@
 #include <osmo-bts/gsm_data.h>
 #include <osmo-bts/l1sap.h>
 
-#include <unistd.h>
 
 static struct gsm_bts *bts;
 
@@ -35,6 +34,10 @@ static const uint8_t static_ilv[] = {
 	0x08, 0x59, 0x51, 0x30, 0x99, 0x00, 0x00, 0x00, 0x19
 };
 
+static const uint8_t static_tmsi_lv[] = {
+	0x05, 0xf4, 0xde, 0xad, 0xbe, 0x00
+};
+
 #define ASSERT_TRUE(rc) \
 	if (!(rc)) { \
 		printf("Assert failed in %s:%d.\n",  \
@@ -94,27 +97,21 @@ static void test_paging_smoke(void)
 	 */
 }
 
-static void test_paging_sleep(void)
+static void test_paging_later_fn(void)
 {
 	int rc;
 	uint8_t out_buf[GSM_MACBLOCK_LEN];
 	struct gsm_time g_time;
 	int is_empty = -1;
-	printf("Testing that paging messages expire with sleep.\n");
+	printf("Testing that paging messages expire at a later frame.\n");
 
 	/* add paging entry */
 	rc = paging_add_identity(bts->paging_state, 0, static_ilv, 0);
 	ASSERT_TRUE(rc == 0);
 	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 1);
 
-	/* sleep */
-	sleep(1);
-
-	/* generate messages */
-	g_time.fn = 0;
-	g_time.t1 = 0;
-	g_time.t2 = 0;
-	g_time.t3 = 6;
+	/* generate messages two 51-multiframes later (same paging group) */
+	gsm_fn2gsmtime(&g_time, 2 * 51 + 6);
 	rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
 	ASSERT_TRUE(rc == 23);
 	ASSERT_TRUE(is_padding(out_buf+13, 23-13));
@@ -124,6 +121,143 @@ static void test_paging_sleep(void)
 	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 0);
 }
 
+static void test_paging_wheel_expiry(void)
+{
+	int rc, i;
+	uint8_t out_buf[GSM_MACBLOCK_LEN];
+	struct gsm_time g_time;
+	int is_empty = -1;
+	uint32_t fn = 4 * 51 + 6;
+	printf("Testing that paging records expire without being scheduled.\n");
+
+	paging_set_lifetime(bts->paging_state, 1);
+
+	/* add paging entry and send it once */
+	rc = paging_add_identity(bts->paging_state, 0, static_ilv, 0);
+	ASSERT_TRUE(rc == 0);
+	gsm_fn2gsmtime(&g_time, fn);
+	rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
+	ASSERT_TRUE(rc == 23);
+	ASSERT_TRUE(is_empty == 0);
+	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 1);
+	ASSERT_TRUE(!paging_group_queue_empty(bts->paging_state, 0));
+
+	/* only serve the (empty) paging group 9 in the odd multiframes; the
+	 * record of group 0 shall expire after one second nonetheless */
+	for (i = 0; i < 5; i++) {
+		fn += 51;
+		gsm_fn2gsmtime(&g_time, fn);
+		rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
+		ASSERT_TRUE(rc == 23);
+		ASSERT_TRUE(is_empty == 1);
+		printf("  FN %u: queue_len=%d\n", fn, paging_queue_length(bts->paging_state));
+		fn += 51;
+	}
+
+	ASSERT_TRUE(paging_group_queue_empty(bts->paging_state, 0));
+	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 0);
+
+	paging_set_lifetime(bts->paging_state, 0);
+}
+
+static void test_paging_fn_reset(void)
+{
+	int rc, i;
+	uint8_t out_buf[GSM_MACBLOCK_LEN];
+	struct gsm_time g_time;
+	int is_empty = -1;
+	uint32_t fn = 14 * 51 + 6;
+	printf("Testing that paging records expire after a frame number reset.\n");
+
+	paging_set_lifetime(bts->paging_state, 1);
+
+	/* add paging entry and send it once */
+	rc = paging_add_identity(bts->paging_state, 0, static_ilv, 0);
+	ASSERT_TRUE(rc == 0);
+	gsm_fn2gsmtime(&g_time, fn);
+	rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
+	ASSERT_TRUE(rc == 23);
+	ASSERT_TRUE(is_empty == 0);
+	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 1);
+
+	/* the transceiver clock is reset, frame numbers start over; serve
+	 * the (empty) paging group 9 in the odd multiframes */
+	fn = 51 + 6;
+	for (i = 0; i < 6; i++) {
+		gsm_fn2gsmtime(&g_time, fn);
+		rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
+		ASSERT_TRUE(rc == 23);
+		ASSERT_TRUE(is_empty == 1);
+		printf("  FN %u: queue_len=%d\n", fn, paging_queue_length(bts->paging_state));
+		fn += 2 * 51;
+	}
+
+	ASSERT_TRUE(paging_queue_length(bts->paging_state) == 0);
+
+	paging_set_lifetime(bts->paging_state, 0);
+}
+
+static int paging_req_type(uint8_t msg_type)
+{
+	switch (msg_type) {
+	case GSM48_MT_RR_PAG_REQ_1:
+		return 1;
+	case GSM48_MT_RR_PAG_REQ_2:
+		return 2;
+	case GSM48_MT_RR_PAG_REQ_3:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+static void test_paging_packing(void)
+{
+	/* paging group queue content, from the oldest to the newest record */
+	static const char queue[] = "ITTITTTTITITTTTI";
+	const int num_ids = sizeof(queue) - 1;
+	uint8_t out_buf[GSM_MACBLOCK_LEN];
+	uint8_t ilv[9];
+	struct gsm_time g_time;
+	int is_empty = -1;
+	int rc, i, num_blocks = 0, num_sent = 0;
+	uint32_t fn = 20 * 51 + 6;
+	printf("Testing packing of paging records into PCH blocks.\n");
+
+	/* records are added to the head of the queue, so go backwards */
+	for (i = num_ids - 1; i >= 0; i--) {
+		if (queue[i] == 'T') {
+			memcpy(ilv, static_tmsi_lv, sizeof(static_tmsi_lv));
+			ilv[sizeof(static_tmsi_lv) - 1] = i;
+		} else {
+			memcpy(ilv, static_ilv, sizeof(static_ilv));
+			ilv[sizeof(static_ilv) - 1] = i;
+		}
+		rc = paging_add_identity(bts->paging_state, 0, ilv, 0);
+		ASSERT_TRUE(rc == 0);
+	}
+	ASSERT_TRUE(paging_queue_length(bts->paging_state) == num_ids);
+
+	while (!paging_group_queue_empty(bts->paging_state, 0)) {
+		int queue_len = paging_queue_length(bts->paging_state);
+
+		gsm_fn2gsmtime(&g_time, fn);
+		rc = paging_gen_msg(bts->paging_state, out_buf, &g_time, &is_empty);
+		ASSERT_TRUE(rc > 0);
+		ASSERT_TRUE(is_empty == 0);
+
+		printf("  block %d: PAGING REQUEST TYPE %d, %d identities\n", num_blocks,
+		       paging_req_type(out_buf[2]),
+		       queue_len - paging_queue_length(bts->paging_state));
+		num_sent += queue_len - paging_queue_length(bts->paging_state);
+		num_blocks++;
+		fn += 2 * 51;
+	}
+
+	ASSERT_TRUE(num_sent == num_ids);
+	printf("Sent %d identities in %d PCH blocks\n", num_sent, num_blocks);
+}
+
 /* Set up a dummy trx with a valid setting for bs_ag_blks_res in SI3 */
 static struct gsm_bts_trx *test_is_ccch_for_agch_setup(uint8_t bs_ag_blks_res)
 {
@@ -191,7 +325,10 @@ int main(int argc, char **argv)
 	}
 
 	test_paging_smoke();
-	test_paging_sleep();
+	test_paging_later_fn();
+	test_paging_wheel_expiry();
+	test_paging_fn_reset();
+	test_paging_packing();
 	test_is_ccch_for_agch();
 	printf("Success\n");
 
@@ -0,0 +1,162 @@
+/* Test cases for the PCU shared memory rings */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/application.h>
+
+#include <osmo-bts/logging.h>
+#include <osmo-bts/pcu_shm.h>
+
+static unsigned int rx_count;
+static unsigned int rx_errors;
+static bool rx_check_len;
+
+/* record i has length rec_len(i) and contains the bytes (i + j) & 0xff */
+static uint16_t rec_len(unsigned int i)
+{
+	return 4 + (i * 37) % 300;
+}
+
+static void rec_write(struct gsm_pcu_if_shm_ring *ring, unsigned int i, uint16_t len)
+{
+	uint8_t *data;
+	unsigned int j;
+
+	data = pcu_shm_ring_reserve(ring, len);
+	OSMO_ASSERT(data != NULL);
+	for (j = 0; j < len; j++)
+		data[j] = (i + j) & 0xff;
+	pcu_shm_ring_commit(ring, len);
+}
+
+static int rx_cb(struct gsm_pcu_if *pcu_prim, size_t len, void *data)
+{
+	const uint8_t *buf = (const uint8_t *) pcu_prim;
+	unsigned int j;
+
+	if (rx_check_len && len != rec_len(rx_count))
+		rx_errors++;
+	for (j = 0; j < len; j++) {
+		if (buf[j] != ((rx_count + j) & 0xff)) {
+			rx_errors++;
+			break;
+		}
+	}
+
+	rx_count++;
+	return 0;
+}
+
+static void test_ring_full(void *ctx)
+{
+	struct gsm_pcu_if_shm_ring *ring = talloc_zero(ctx, struct gsm_pcu_if_shm_ring);
+	unsigned int num = 0;
+	int rc;
+
+	printf("Testing full PCU shared memory ring.\n");
+	rx_count = rx_errors = 0;
+	rx_check_len = false;
+
+	while (pcu_shm_ring_reserve(ring, 200)) {
+		pcu_shm_ring_commit(ring, 200);
+		num++;
+	}
+	printf("  %u records of 200 bytes fit, head=%u\n", num, ring->head);
+
+	rc = pcu_shm_ring_read(ring, rx_cb, NULL);
+	printf("  read %d records, tail=%u\n", rc, ring->tail);
+
+	/* the next one does not fit before the end of the ring */
+	OSMO_ASSERT(pcu_shm_ring_reserve(ring, 200) != NULL);
+	pcu_shm_ring_commit(ring, 200);
+	printf("  wrapped around, head=%u\n", ring->head);
+
+	rc = pcu_shm_ring_read(ring, rx_cb, NULL);
+	printf("  read %d records, tail=%u\n", rc, ring->tail);
+
+	talloc_free(ring);
+}
+
+static void test_ring_corrupt(void *ctx)
+{
+	struct gsm_pcu_if_shm_ring *ring = talloc_zero(ctx, struct gsm_pcu_if_shm_ring);
+	struct gsm_pcu_if_shm_rec *rec = (struct gsm_pcu_if_shm_rec *) ring->data;
+	int rc;
+
+	printf("Testing corrupted PCU shared memory ring.\n");
+	rx_count = rx_errors = 0;
+	rx_check_len = false;
+
+	/* wrap record, but head is not beyond the end of the ring */
+	rec->len = PCU_IF_SHM_REC_WRAP;
+	ring->head = 8;
+	rc = pcu_shm_ring_read(ring, rx_cb, NULL);
+	printf("  wrap: read %d records, tail=%u\n", rc, ring->tail);
+
+	/* record longer than the data written */
+	rec_write(ring, 0, 16);
+	rec = (struct gsm_pcu_if_shm_rec *) &ring->data[ring->head % sizeof(ring->data)];
+	rec->len = 100;
+	ring->head += 8;
+	rc = pcu_shm_ring_read(ring, rx_cb, NULL);
+	printf("  length: read %d records, tail=%u\n", rc, ring->tail);
+
+	talloc_free(ring);
+}
+
+static void test_ring_stream(void *ctx)
+{
+	struct gsm_pcu_if_shm_ring *ring = talloc_zero(ctx, struct gsm_pcu_if_shm_ring);
+	const unsigned int num = 10000;
+	unsigned int i;
+
+	printf("Testing streaming through PCU shared memory ring.\n");
+	rx_count = rx_errors = 0;
+	rx_check_len = true;
+
+	for (i = 0; i < num; i++) {
+		rec_write(ring, i, rec_len(i));
+		if (i % 7 == 6)
+			pcu_shm_ring_read(ring, rx_cb, NULL);
+	}
+	pcu_shm_ring_read(ring, rx_cb, NULL);
+
+	printf("  wrote %u records, read %u records, %u errors, %s\n",
+	       num, rx_count, rx_errors, ring->head == ring->tail ? "empty" : "not empty");
+
+	talloc_free(ring);
+}
+
+int main(int argc, char **argv)
+{
+	void *ctx = talloc_named_const(NULL, 1, "pcu_shm_test");
+
+	osmo_init_logging2(ctx, &bts_log_info);
+
+	test_ring_full(ctx);
+	test_ring_corrupt(ctx);
+	test_ring_stream(ctx);
+	printf("Success\n");
+
+	return 0;
+}
@@ -0,0 +1,261 @@
+/* Test cases for the PCU interface primitive encoding */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/application.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/pcu_if.h>
+#include <osmo-bts/pcu_enc.h>
+
+static unsigned int rx_count;
+
+static int print_elem_cb(uint8_t msg_type, const void *data, uint8_t len, void *cb_data)
+{
+	printf("  elem %u: msg_type=0x%02x len=%u data=%s\n", rx_count++,
+	       msg_type, len, osmo_hexdump_nospc(data, len));
+	return 0;
+}
+
+static int count_elem_cb(uint8_t msg_type, const void *data, uint8_t len, void *cb_data)
+{
+	rx_count++;
+	return 0;
+}
+
+static void test_batch_roundtrip(void)
+{
+	const struct gsm_pcu_if_time_ind time_ind = { .fn = 0x123456 };
+	const uint8_t data[] = { 0xde, 0xad, 0xbe, 0xef, 0x2b };
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+	int rc;
+
+	printf("Testing BATCH.ind encoding and decoding.\n");
+
+	msg = pcu_batch_alloc(3);
+	OSMO_ASSERT(msg);
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+	printf("  empty: %s\n", osmo_hexdump_nospc(msg->data, msgb_length(msg)));
+
+	OSMO_ASSERT(pcu_batch_append(msg, PCU_IF_MSG_TIME_IND, &time_ind, sizeof(time_ind)) == 0);
+	OSMO_ASSERT(pcu_batch_append(msg, PCU_IF_MSG_DATA_IND, data, sizeof(data)) == 0);
+	OSMO_ASSERT(pcu_batch_append(msg, PCU_IF_MSG_RTS_REQ, NULL, 0) == 0);
+	printf("  bts_nr=%u num_elems=%u length=%u msg_len=%u\n", pcu_prim->bts_nr,
+	       pcu_prim->u.batch_ind.num_elems, pcu_prim->u.batch_ind.length, msgb_length(msg));
+
+	rx_count = 0;
+	rc = pcu_batch_decode(pcu_prim, msgb_length(msg), print_elem_cb, NULL);
+	printf("  decoded %d elements\n", rc);
+
+	msgb_free(msg);
+}
+
+static void test_batch_overflow(void)
+{
+	uint8_t data[30] = { 0 };
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+	unsigned int num = 0;
+	int rc;
+
+	printf("Testing BATCH.ind overflow.\n");
+
+	msg = pcu_batch_alloc(0);
+	OSMO_ASSERT(msg);
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+
+	while ((rc = pcu_batch_append(msg, PCU_IF_MSG_DATA_IND, data, sizeof(data))) == 0)
+		num++;
+	printf("  %u elements of %zu bytes fit, rc=%d, num_elems=%u length=%u msg_len=%u\n",
+	       num, sizeof(data), rc, pcu_prim->u.batch_ind.num_elems,
+	       pcu_prim->u.batch_ind.length, msgb_length(msg));
+
+	/* a smaller one still fits into the remaining space */
+	rc = pcu_batch_append(msg, PCU_IF_MSG_DATA_IND, data, 20);
+	printf("  appending 20 bytes: rc=%d, msg_len=%u\n", rc, msgb_length(msg));
+	rc = pcu_batch_append(msg, PCU_IF_MSG_RTS_REQ, data, 1);
+	printf("  appending 1 byte: rc=%d, msg_len=%u\n", rc, msgb_length(msg));
+
+	rx_count = 0;
+	rc = pcu_batch_decode(pcu_prim, msgb_length(msg), count_elem_cb, NULL);
+	printf("  decoded %d elements, %u callbacks\n", rc, rx_count);
+
+	msgb_free(msg);
+}
+
+static void test_batch_malformed(void)
+{
+	const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+	unsigned int len;
+	int rc;
+
+	printf("Testing malformed BATCH.ind.\n");
+
+	msg = pcu_batch_alloc(0);
+	OSMO_ASSERT(msg);
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+	OSMO_ASSERT(pcu_batch_append(msg, PCU_IF_MSG_DATA_IND, data, sizeof(data)) == 0);
+	OSMO_ASSERT(pcu_batch_append(msg, PCU_IF_MSG_DATA_IND, data, sizeof(data)) == 0);
+	len = msgb_length(msg);
+
+#define DECODE(descr, prim_len) \
+	do { \
+		rx_count = 0; \
+		rc = pcu_batch_decode(pcu_prim, prim_len, count_elem_cb, NULL); \
+		printf("  %s: rc=%d, %u callbacks\n", descr, rc, rx_count); \
+	} while (0)
+
+	DECODE("valid", len);
+	DECODE("truncated header", PCUIF_HDR_SIZE + 2);
+	DECODE("truncated", len - 1);
+	DECODE("exceeding the maximum", PCU_IF_BATCH_MAX_LEN + 1);
+
+	pcu_prim->u.batch_ind.length++;
+	DECODE("length too large", len);
+	pcu_prim->u.batch_ind.length--;
+
+	pcu_prim->u.batch_ind.num_elems++;
+	DECODE("one element too many", len);
+	pcu_prim->u.batch_ind.num_elems -= 2;
+	DECODE("one element too few", len);
+	pcu_prim->u.batch_ind.num_elems++;
+
+	/* second element claims more data than there is */
+	pcu_prim->u.batch_ind.elems[sizeof(struct gsm_pcu_if_batch_elem) + sizeof(data) + 1]++;
+	DECODE("element overrunning the batch", len);
+	pcu_prim->u.batch_ind.elems[sizeof(struct gsm_pcu_if_batch_elem) + sizeof(data) + 1]--;
+
+	DECODE("valid again", len);
+#undef DECODE
+
+	msgb_free(msg);
+}
+
+static void info_encode(struct pcu_info_state *state, const struct gsm_pcu_if_info_ind *info_ind)
+{
+	const struct gsm_pcu_if_info_delta_ind *delta_ind;
+	const struct gsm_pcu_if_info_delta_ts *delta_ts;
+	struct gsm_pcu_if *pcu_prim;
+	struct msgb *msg;
+	unsigned int i;
+	int rc;
+
+	rc = pcu_info_ind_encode(state, 0, info_ind, &msg);
+	OSMO_ASSERT(rc == 0);
+	if (!msg) {
+		printf("  nothing to send, seq=%u\n", state->seq);
+		return;
+	}
+
+	pcu_prim = (struct gsm_pcu_if *) msg->data;
+	switch (pcu_prim->msg_type) {
+	case PCU_IF_MSG_INFO_IND:
+		printf("  INFO.ind, seq=%u\n", state->seq);
+		break;
+	case PCU_IF_MSG_INFO_DELTA_IND:
+		delta_ind = &pcu_prim->u.info_delta_ind;
+		printf("  INFO_DELTA.ind #%u with %u timeslots, len=%u, seq=%u\n",
+		       delta_ind->seq, delta_ind->num_ts, msgb_length(msg), state->seq);
+		for (i = 0; i < delta_ind->num_ts; i++) {
+			delta_ts = &delta_ind->ts[i];
+			printf("    trx=%u ts=%u pdch=%u tsc=%u maio=%u\n", delta_ts->trx_nr,
+			       delta_ts->ts_nr, delta_ts->pdch, delta_ts->ts.tsc, delta_ts->ts.maio);
+		}
+		break;
+	default:
+		printf("  unexpected msg_type 0x%02x\n", pcu_prim->msg_type);
+	}
+
+	msgb_free(msg);
+}
+
+static void test_info_delta(void)
+{
+	struct pcu_info_state state = { .delta = true };
+	struct gsm_pcu_if_info_ind info_ind;
+	unsigned int tn;
+
+	printf("Testing INFO_DELTA.ind encoding.\n");
+
+	memset(&info_ind, 0, sizeof(info_ind));
+	info_ind.bsic = 63;
+	info_ind.trx[0].arfcn = 871;
+	info_ind.trx[0].pdch_mask = 0x0f;
+	for (tn = 0; tn < 8; tn++)
+		info_ind.trx[0].ts[tn].tsc = 7;
+
+	printf(" initial:\n");
+	info_encode(&state, &info_ind);
+	printf(" unchanged:\n");
+	info_encode(&state, &info_ind);
+
+	printf(" one timeslot changed:\n");
+	info_ind.trx[0].ts[2].maio = 1;
+	info_encode(&state, &info_ind);
+
+	printf(" two PDCH added:\n");
+	info_ind.trx[0].pdch_mask = 0x3f;
+	info_encode(&state, &info_ind);
+	printf(" unchanged:\n");
+	info_encode(&state, &info_ind);
+
+	printf(" BSIC changed:\n");
+	info_ind.bsic = 1;
+	info_encode(&state, &info_ind);
+
+	printf(" one timeslot changed:\n");
+	info_ind.trx[0].ts[3].tsc = 5;
+	info_encode(&state, &info_ind);
+
+	printf(" one timeslot changed, but the previous one was not sent:\n");
+	state.valid = false;
+	info_ind.trx[0].ts[3].tsc = 6;
+	info_encode(&state, &info_ind);
+
+	printf(" one timeslot changed, PCU does not want deltas:\n");
+	state.delta = false;
+	info_ind.trx[0].ts[3].tsc = 7;
+	info_encode(&state, &info_ind);
+}
+
+int main(int argc, char **argv)
+{
+	void *ctx = talloc_named_const(NULL, 1, "pcu_sock_test");
+
+	msgb_talloc_ctx_init(ctx, 0);
+	osmo_init_logging2(ctx, &bts_log_info);
+
+	test_batch_roundtrip();
+	test_batch_overflow();
+	test_batch_malformed();
+	test_info_delta();
+	printf("Success\n");
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+/* Test cases for receiving primitives on the PCU socket */
+
+/* (C) 2026 by agent <agent@local>
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/socket.h>
+#include <osmocom/core/application.h>
+
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/bts.h>
+#include <osmo-bts/bts_trx.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/pcu_if.h>
+#include <osmo-bts/pcuif_proto.h>
+
+#define PCU_SOCK_PATH "pcu_sock_rx_test.sock"
+
+static struct gsm_bts *bts;
+
+/* one iteration of the main loop of the BTS */
+static void bts_poll(void)
+{
+	osmo_select_main(1);
+}
+
+/* number of primitives the BTS sent to the PCU since the last call */
+static unsigned int pcu_rx_count(int fd)
+{
+	struct gsm_pcu_if pcu_prim;
+	unsigned int num = 0;
+
+	while (recv(fd, &pcu_prim, sizeof(pcu_prim), MSG_DONTWAIT) > 0)
+		num++;
+
+	return num;
+}
+
+/* INFO_DELTA.req declining deltas, answered by the BTS with an INFO.ind */
+static void pcu_tx_info_delta_req(int fd)
+{
+	struct gsm_pcu_if pcu_prim = {
+		.msg_type = PCU_IF_MSG_INFO_DELTA_REQ,
+		.bts_nr = bts->nr,
+	};
+	size_t len = PCUIF_HDR_SIZE + sizeof(pcu_prim.u.info_delta_req);
+
+	OSMO_ASSERT(send(fd, &pcu_prim, len, 0) == len);
+}
+
+static int pcu_connect(void)
+{
+	int fd;
+
+	fd = osmo_sock_unix_init(SOCK_SEQPACKET, 0, PCU_SOCK_PATH, OSMO_SOCK_F_CONNECT);
+	OSMO_ASSERT(fd >= 0);
+
+	/* accept, then send the initial INFO.ind */
+	bts_poll();
+	bts_poll();
+	printf("  connected: %d, received %u\n", pcu_connected(), pcu_rx_count(fd));
+
+	return fd;
+}
+
+static void test_drain(void)
+{
+	const uint8_t short_prim[2] = { PCU_IF_MSG_INFO_DELTA_REQ, 0 };
+	unsigned int i;
+	int fd;
+
+	printf("Testing draining several primitives per wake-up\n");
+	fd = pcu_connect();
+
+	for (i = 0; i < 3; i++)
+		pcu_tx_info_delta_req(fd);
+	/* shorter than the header, skipped */
+	OSMO_ASSERT(send(fd, short_prim, sizeof(short_prim), 0) == sizeof(short_prim));
+	for (i = 0; i < 3; i++)
+		pcu_tx_info_delta_req(fd);
+
+	/* all requests are read at once, the answers are sent next time */
+	bts_poll();
+	printf("  1st wake-up: received %u\n", pcu_rx_count(fd));
+	bts_poll();
+	printf("  2nd wake-up: received %u\n", pcu_rx_count(fd));
+
+	close(fd);
+	bts_poll();
+	printf("  closed: connected: %d\n", pcu_connected());
+}
+
+int main(int argc, char **argv)
+{
+	tall_bts_ctx = talloc_named_const(NULL, 1, "OsmoBTS context");
+	msgb_talloc_ctx_init(tall_bts_ctx, 0);
+	osmo_init_logging2(tall_bts_ctx, &bts_log_info);
+
+	bts = gsm_bts_alloc(tall_bts_ctx, 0);
+	if (!bts) {
+		fprintf(stderr, "Failed to create BTS structure\n");
+		exit(1);
+	}
+	if (bts_init(bts) < 0) {
+		fprintf(stderr, "unable to init BTS\n");
+		exit(1);
+	}
+	if (!gsm_bts_trx_alloc(bts)) {
+		fprintf(stderr, "Failed to alloc TRX structure\n");
+		exit(1);
+	}
+	bts->variant = BTS_OSMO_OMLDUMMY;
+
+	unlink(PCU_SOCK_PATH);
+	OSMO_ASSERT(pcu_sock_init(PCU_SOCK_PATH) == 0);
+
+	test_drain();
+
+	pcu_sock_exit();
+	unlink(PCU_SOCK_PATH);
+
+	printf("Success\n");
+
+	return 0;
+}
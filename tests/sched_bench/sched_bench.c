@@ -0,0 +1,665 @@
+/* Microbenchmarks for the hot path of the L1 scheduler */
+
+/* (C) 2026 by agent <agent@local>
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Each case configures timeslots 1..7 of a TRX with one channel combination,
+ * activates all of its logical channels and times the scheduler entry points
+ * in a tight loop, using the burst handlers of osmo-bts-trx:
+ *
+ *   ul_*       trx_sched_ul_burst() with coded bursts, including the hand-over
+ *              of the decoded blocks to L1SAP (which drops them, as no lchan
+ *              is active on the upper layers),
+ *   dl_*       _sched_dl_burst(), with the DL primitives queued in advance,
+ *              like the PH-RTS.ind / PH-DATA.req round trip would do,
+ *   dequeue    _sched_dequeue_prim(),
+ *   set_lchan  trx_sched_set_lchan(), activating and deactivating a TCH/F.
+ *
+ * The results are printed as one line per case:
+ *
+ *   case=NAME ns_per_op=N allocs_per_op=N ops=N
+ *
+ * Allocations are counted by wrapping malloc() (glibc only, -1 otherwise).
+ * With -b, the results are compared against a baseline file of the same
+ * format, in which ns_per_op and ops may be omitted: more allocations per
+ * operation than in the baseline make the program fail.  Timing depends on
+ * the machine, so it is only compared on request (-t), failing if the time
+ * per operation exceeds the baseline by more than the given factor.
+ *
+ * The allocations of the ul_* cases include those of the Viterbi decoder of
+ * libosmocoding, whose number depends on the libosmocore version and build,
+ * so these cases are not part of the committed baseline. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/application.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/gsm/protocol/gsm_08_58.h>
+#include <osmocom/gsm/protocol/gsm_04_08.h>
+#include <osmocom/coding/gsm0503_coding.h>
+
+#include <osmo-bts/bts.h>
+#include <osmo-bts/gsm_data.h>
+#include <osmo-bts/logging.h>
+#include <osmo-bts/l1sap.h>
+#include <osmo-bts/scheduler.h>
+#include <osmo-bts/scheduler_backend.h>
+
+/* Frames between queueing a DL primitive and its transmission, like the sum
+ * of 'fn-advance' and 'rts-advance' of osmo-bts-trx */
+#define BENCH_RTS_ADVANCE	5
+
+#define BENCH_FIRST_TN		1
+
+struct bench_result {
+	uint64_t ns;
+	int64_t allocs;
+	uint64_t ops;
+};
+
+struct bench_case {
+	const char *name;
+	enum gsm_phys_chan_config pchan;
+	bool vamos;
+	void (*run)(const struct bench_case *bc, struct bench_result *res);
+};
+
+static struct gsm_bts *bts;
+static struct gsm_bts_trx *trx;
+static unsigned int num_frames = 26 * 51 * 4;
+
+/* UL coded blocks, per [shadow][tn][chan] */
+static ubit_t ul_coded[2][8][_TRX_CHAN_MAX][928];
+
+static const uint8_t l2_fill[GSM_MACBLOCK_LEN] = {
+	0x03, 0x03, 0x01, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+	0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b, 0x2b,
+};
+/* silence frame (FR) and RFC 5993 HR frame (ToC followed by 14 octets) */
+static const uint8_t tch_fr_frame[GSM_FR_BYTES] = { 0xd0 };
+static const uint8_t tch_hr_frame[15] = { 0x00 };
+
+/*
+ * Allocation counter
+ */
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static const bool have_num_allocs = true;
+static int64_t num_allocs;
+
+void *malloc(size_t size)
+{
+	num_allocs++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	num_allocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	num_allocs++;
+	return __libc_realloc(ptr, size);
+}
+#else
+static const bool have_num_allocs = false;
+static const int64_t num_allocs = 0;
+#endif
+
+/*
+ * Measurement windows
+ */
+
+static uint64_t win_ns;
+static int64_t win_allocs;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline void win_open(void)
+{
+	win_allocs = num_allocs;
+	win_ns = now_ns();
+}
+
+static inline void win_close(struct bench_result *res, unsigned int ops)
+{
+	res->ns += now_ns() - win_ns;
+	res->allocs += num_allocs - win_allocs;
+	res->ops += ops;
+}
+
+/*
+ * Stubs for what osmo-bts-trx implements outside of its burst handlers
+ */
+
+void _sched_act_rach_det(struct gsm_bts_trx *trx, uint8_t tn, uint8_t ss, int activate)
+{
+}
+
+/*
+ * Timeslot setup
+ */
+
+static const enum trx_chan_type chans_tchf[] = {
+	TRXC_TCHF, TRXC_SACCHTF,
+};
+static const enum trx_chan_type chans_tchh[] = {
+	TRXC_TCHH_0, TRXC_TCHH_1, TRXC_SACCHTH_0, TRXC_SACCHTH_1,
+};
+static const enum trx_chan_type chans_sdcch8[] = {
+	TRXC_SDCCH8_0, TRXC_SDCCH8_1, TRXC_SDCCH8_2, TRXC_SDCCH8_3,
+	TRXC_SDCCH8_4, TRXC_SDCCH8_5, TRXC_SDCCH8_6, TRXC_SDCCH8_7,
+	TRXC_SACCH8_0, TRXC_SACCH8_1, TRXC_SACCH8_2, TRXC_SACCH8_3,
+	TRXC_SACCH8_4, TRXC_SACCH8_5, TRXC_SACCH8_6, TRXC_SACCH8_7,
+};
+/* PTCCH shares chan_nr and link_id with PDTCH, so it is activated along */
+static const enum trx_chan_type chans_pdch[] = {
+	TRXC_PDTCH,
+};
+
+static void set_chan(struct gsm_bts_trx_ts *ts, enum trx_chan_type chan, bool active)
+{
+	uint8_t chan_nr = trx_chan_desc[chan].chan_nr | ts->nr;
+	uint8_t link_id = trx_chan_desc[chan].link_id;
+	struct gsm_lchan *lchan = &ts->lchan[l1sap_chan2ss(chan_nr)];
+
+	if (ts->vamos.is_shadow)
+		chan_nr |= RSL_CHAN_OSMO_VAMOS_MASK;
+
+	OSMO_ASSERT(trx_sched_set_lchan(lchan, chan_nr, link_id, active) == 0);
+
+	if (active && (chan == TRXC_TCHF || chan == TRXC_TCHH_0 || chan == TRXC_TCHH_1))
+		trx_sched_set_mode(ts, chan_nr, RSL_CMOD_SPD_SPEECH, GSM48_CMODE_SPEECH_V1,
+				   0, 0, 0, 0, 0, 0, 0);
+}
+
+static void setup_ts(const struct bench_case *bc, bool active)
+{
+	const enum trx_chan_type *chans;
+	unsigned int num_chans, tn, i;
+
+	switch (bc->pchan) {
+	case GSM_PCHAN_TCH_F:
+		chans = chans_tchf;
+		num_chans = ARRAY_SIZE(chans_tchf);
+		break;
+	case GSM_PCHAN_TCH_H:
+		chans = chans_tchh;
+		num_chans = ARRAY_SIZE(chans_tchh);
+		break;
+	case GSM_PCHAN_SDCCH8_SACCH8C:
+		chans = chans_sdcch8;
+		num_chans = ARRAY_SIZE(chans_sdcch8);
+		break;
+	case GSM_PCHAN_PDCH:
+		chans = chans_pdch;
+		num_chans = ARRAY_SIZE(chans_pdch);
+		break;
+	default:
+		OSMO_ASSERT(0);
+	}
+
+	for (tn = BENCH_FIRST_TN; tn < ARRAY_SIZE(trx->ts); tn++) {
+		struct gsm_bts_trx_ts *ts = &trx->ts[tn];
+
+		if (active) {
+			ts->pchan = bc->pchan;
+			ts->vamos.peer->pchan = bc->pchan;
+			OSMO_ASSERT(trx_sched_set_pchan(ts, bc->pchan) == 0);
+		}
+
+		for (i = 0; i < num_chans; i++) {
+			set_chan(ts, chans[i], active);
+			if (bc->vamos)
+				set_chan(ts->vamos.peer, chans[i], active);
+		}
+
+		if (!active) {
+			msgb_queue_flush(&((struct l1sched_ts *) ts->priv)->dl_prims);
+			msgb_queue_flush(&((struct l1sched_ts *) ts->vamos.peer->priv)->dl_prims);
+		}
+	}
+}
+
+/*
+ * Uplink
+ */
+
+/* Get the coded bits of an UL burst, encoding the next block at bid 0 */
+static const ubit_t *ul_burst_bits(bool shadow, uint8_t tn, enum trx_chan_type chan, uint8_t bid)
+{
+	ubit_t *bursts = ul_coded[shadow][tn][chan];
+
+	switch (chan) {
+	case TRXC_TCHF:
+		/* block diagonal interleaving over 8 bursts */
+		if (bid == 0) {
+			memcpy(bursts, bursts + 464, 464);
+			memset(bursts + 464, 0, 464);
+			gsm0503_tch_fr_encode(bursts, tch_fr_frame, sizeof(tch_fr_frame), 1);
+		}
+		break;
+	case TRXC_TCHH_0:
+	case TRXC_TCHH_1:
+		/* interleaving over 4 bursts, shifted by 2 */
+		if (bid == 0) {
+			memcpy(bursts, bursts + 232, 232);
+			memset(bursts + 232, 0, 232);
+			gsm0503_tch_hr_encode(bursts, tch_hr_frame + 1, sizeof(tch_hr_frame) - 1);
+		}
+		break;
+	case TRXC_PDTCH:
+		if (bid == 0)
+			gsm0503_pdtch_encode(bursts, l2_fill, sizeof(l2_fill));
+		break;
+	default:
+		if (!TRX_CHAN_IS_DEDIC(chan))
+			return NULL;
+		if (bid == 0)
+			gsm0503_xcch_encode(bursts, l2_fill);
+		break;
+	}
+
+	return bursts + bid * 116;
+}
+
+static void ul_burst_prepare(struct trx_ul_burst_ind *bi, bool shadow, uint8_t tn, uint32_t fn)
+{
+	const struct l1sched_ts *l1ts = shadow ? trx->ts[tn].vamos.peer->priv : trx->ts[tn].priv;
+	const struct trx_sched_frame *frame = &l1ts->mf_frames[fn % l1ts->mf_period];
+	const ubit_t *bits = ul_burst_bits(shadow, tn, frame->ul_chan, frame->ul_bid);
+	unsigned int i;
+
+	bi->flags = TRX_BI_F_MOD_TYPE | TRX_BI_F_TS_INFO | TRX_BI_F_CI_CB;
+	bi->fn = fn;
+	bi->tn = tn;
+	bi->toa256 = 0;
+	bi->rssi = -60;
+	bi->mod = TRX_MOD_T_GMSK;
+	bi->tsc_set = 0;
+	bi->tsc = 7;
+	bi->ci_cb = 100;
+
+	if (shadow)
+		bi->flags |= TRX_BI_F_SHADOW_IND;
+
+	/* like osmo-trx, indicate the absence of a burst (IDLE, PTCCH, ...) */
+	if (!bits) {
+		bi->flags |= TRX_BI_F_NOPE_IND;
+		bi->burst_len = 0;
+		return;
+	}
+
+	memset(bi->burst, 0, GSM_BURST_LEN);
+	for (i = 0; i < 58; i++) {
+		bi->burst[3 + i] = bits[i] ? -127 : 127;
+		bi->burst[87 + i] = bits[58 + i] ? -127 : 127;
+	}
+	bi->burst_len = GSM_BURST_LEN;
+}
+
+static void run_ul(const struct bench_case *bc, struct bench_result *res)
+{
+	struct trx_ul_burst_ind bi[8 * 2];
+	unsigned int num, i, tn;
+	uint32_t fn;
+
+	for (fn = 0; fn < num_frames; fn++) {
+		num = 0;
+		for (tn = BENCH_FIRST_TN; tn < ARRAY_SIZE(trx->ts); tn++) {
+			ul_burst_prepare(&bi[num++], false, tn, fn);
+			if (bc->vamos)
+				ul_burst_prepare(&bi[num++], true, tn, fn);
+		}
+
+		win_open();
+		for (i = 0; i < num; i++)
+			trx_sched_ul_burst(trx->ts[bi[i].tn].priv, &bi[i]);
+		win_close(res, num);
+	}
+}
+
+/*
+ * Downlink
+ */
+
+static struct msgb *dl_prim_alloc(enum trx_chan_type chan, uint8_t tn, uint32_t fn)
+{
+	struct osmo_phsap_prim *l1sap;
+	const uint8_t *data;
+	unsigned int len;
+	struct msgb *msg;
+	bool tch = true;
+
+	switch (chan) {
+	case TRXC_TCHF:
+		data = tch_fr_frame;
+		len = sizeof(tch_fr_frame);
+		break;
+	case TRXC_TCHH_0:
+	case TRXC_TCHH_1:
+		data = tch_hr_frame;
+		len = sizeof(tch_hr_frame);
+		break;
+	default:
+		data = l2_fill;
+		len = sizeof(l2_fill);
+		tch = false;
+		break;
+	}
+
+	msg = l1sap_msgb_alloc(len);
+	l1sap = msgb_l1sap_prim(msg);
+	if (tch) {
+		osmo_prim_init(&l1sap->oph, SAP_GSM_PH, PRIM_TCH, PRIM_OP_REQUEST, msg);
+		l1sap->u.tch.chan_nr = trx_chan_desc[chan].chan_nr | tn;
+		l1sap->u.tch.fn = fn;
+	} else {
+		osmo_prim_init(&l1sap->oph, SAP_GSM_PH, PRIM_PH_DATA, PRIM_OP_REQUEST, msg);
+		l1sap->u.data.chan_nr = trx_chan_desc[chan].chan_nr | tn;
+		l1sap->u.data.link_id = trx_chan_desc[chan].link_id;
+		l1sap->u.data.fn = fn;
+	}
+	msg->l2h = msgb_put(msg, len);
+	memcpy(msg->l2h, data, len);
+
+	return msg;
+}
+
+/* Queue what L2 would send in response to the PH-RTS.ind of _sched_rts() */
+static void dl_rts(struct l1sched_ts *l1ts, uint32_t fn)
+{
+	const struct trx_sched_frame *frame = &l1ts->mf_frames[fn % l1ts->mf_period];
+	enum trx_chan_type chan = frame->dl_chan;
+
+	if (frame->dl_bid != 0 || !trx_chan_desc[chan].rts_fn)
+		return;
+	if (!TRX_CHAN_IS_ACTIVE(&l1ts->chan_state[chan], chan))
+		return;
+
+	msgb_enqueue(&l1ts->dl_prims, dl_prim_alloc(chan, l1ts->ts->nr, fn));
+}
+
+static void run_dl(const struct bench_case *bc, struct bench_result *res)
+{
+	struct l1sched_ts *l1ts[8 * 2];
+	unsigned int num = 0, i, tn;
+	uint32_t fn;
+
+	for (tn = BENCH_FIRST_TN; tn < ARRAY_SIZE(trx->ts); tn++) {
+		l1ts[num++] = trx->ts[tn].priv;
+		if (bc->vamos)
+			l1ts[num++] = trx->ts[tn].vamos.peer->priv;
+	}
+
+	for (fn = 0; fn < BENCH_RTS_ADVANCE; fn++) {
+		for (i = 0; i < num; i++)
+			dl_rts(l1ts[i], fn);
+	}
+
+	for (fn = 0; fn < num_frames; fn++) {
+		for (i = 0; i < num; i++)
+			dl_rts(l1ts[i], fn + BENCH_RTS_ADVANCE);
+
+		win_open();
+		for (i = 0; i < num; i++) {
+			struct trx_dl_burst_req br = {
+				.fn = fn,
+				.tn = l1ts[i]->ts->nr,
+			};
+			_sched_dl_burst(l1ts[i], &br);
+		}
+		win_close(res, num);
+	}
+}
+
+/*
+ * Queue and lchan management
+ */
+
+static void run_dequeue(const struct bench_case *bc, struct bench_result *res)
+{
+	struct l1sched_ts *l1ts = trx->ts[BENCH_FIRST_TN].priv;
+	struct msgb **msgs;
+	uint32_t fn;
+
+	msgs = talloc_zero_array(tall_bts_ctx, struct msgb *, num_frames);
+	OSMO_ASSERT(msgs != NULL);
+
+	for (fn = 0; fn < num_frames; fn++)
+		msgb_enqueue(&l1ts->dl_prims, dl_prim_alloc(TRXC_SDCCH8_0, BENCH_FIRST_TN, fn));
+
+	win_open();
+	for (fn = 0; fn < num_frames; fn++) {
+		const struct trx_dl_burst_req br = {
+			.fn = fn,
+			.tn = BENCH_FIRST_TN,
+			.chan = TRXC_SDCCH8_0,
+		};
+		msgs[fn] = _sched_dequeue_prim(l1ts, &br);
+	}
+	win_close(res, num_frames);
+
+	for (fn = 0; fn < num_frames; fn++) {
+		OSMO_ASSERT(msgs[fn] != NULL);
+		msgb_free(msgs[fn]);
+	}
+	talloc_free(msgs);
+}
+
+static void run_set_lchan(const struct bench_case *bc, struct bench_result *res)
+{
+	struct gsm_bts_trx_ts *ts = &trx->ts[BENCH_FIRST_TN];
+	struct gsm_lchan *lchan = &ts->lchan[0];
+	uint8_t chan_nr = trx_chan_desc[TRXC_TCHF].chan_nr | ts->nr;
+	unsigned int i;
+
+	/* setup_ts() activated all channels */
+	set_chan(ts, TRXC_TCHF, false);
+	set_chan(ts, TRXC_SACCHTF, false);
+
+	win_open();
+	for (i = 0; i < num_frames; i++) {
+		trx_sched_set_lchan(lchan, chan_nr, 0x00, true);
+		trx_sched_set_lchan(lchan, chan_nr, 0x40, true);
+		trx_sched_set_lchan(lchan, chan_nr, 0x00, false);
+		trx_sched_set_lchan(lchan, chan_nr, 0x40, false);
+	}
+	win_close(res, num_frames * 4);
+
+	set_chan(ts, TRXC_TCHF, true);
+	set_chan(ts, TRXC_SACCHTF, true);
+}
+
+static const struct bench_case bench_cases[] = {
+	{ "ul_tchf",		GSM_PCHAN_TCH_F,		false,	run_ul },
+	{ "ul_tchh_vamos",	GSM_PCHAN_TCH_H,		true,	run_ul },
+	{ "ul_sdcch8",		GSM_PCHAN_SDCCH8_SACCH8C,	false,	run_ul },
+	{ "ul_pdch",		GSM_PCHAN_PDCH,			false,	run_ul },
+	{ "dl_tchf",		GSM_PCHAN_TCH_F,		false,	run_dl },
+	{ "dl_tchh_vamos",	GSM_PCHAN_TCH_H,		true,	run_dl },
+	{ "dl_sdcch8",		GSM_PCHAN_SDCCH8_SACCH8C,	false,	run_dl },
+	{ "dl_pdch",		GSM_PCHAN_PDCH,			false,	run_dl },
+	{ "dequeue",		GSM_PCHAN_SDCCH8_SACCH8C,	false,	run_dequeue },
+	{ "set_lchan",		GSM_PCHAN_TCH_F,		false,	run_set_lchan },
+};
+
+/*
+ * Baseline comparison
+ */
+
+static int check_baseline(const char *path, const char *name,
+			  const struct bench_result *res, double tolerance)
+{
+	double ns = (double) res->ns / res->ops;
+	double allocs = (double) res->allocs / res->ops;
+	double base_ns, base_allocs;
+	char line[256], base_name[64];
+	const char *val;
+	int rc = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Failed to open baseline file %s\n", path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "case=%63s", base_name) != 1)
+			continue;
+		if (strcmp(base_name, name))
+			continue;
+
+		val = strstr(line, " allocs_per_op=");
+		if (val && sscanf(val, " allocs_per_op=%lf", &base_allocs) == 1 &&
+		    res->allocs >= 0 && base_allocs >= 0 && allocs > base_allocs + 0.0005) {
+			fprintf(stderr, "%s: %.3f allocations per operation, baseline %.3f\n",
+				name, allocs, base_allocs);
+			rc = -1;
+		}
+
+		val = strstr(line, " ns_per_op=");
+		if (tolerance > 0 && val && sscanf(val, " ns_per_op=%lf", &base_ns) == 1 &&
+		    ns > base_ns * tolerance) {
+			fprintf(stderr, "%s: %.1f ns per operation, baseline %.1f (tolerance x%.1f)\n",
+				name, ns, base_ns, tolerance);
+			rc = -1;
+		}
+		break;
+	}
+
+	fclose(f);
+	return rc;
+}
+
+static void print_help(const char *prog)
+{
+	printf("Usage: %s [-n FRAMES] [-b BASELINE] [-t FACTOR]\n", prog);
+	printf("  -n FRAMES	Number of TDMA frames per case (default: %u)\n", num_frames);
+	printf("  -b BASELINE	Compare the results against a baseline file\n");
+	printf("  -t FACTOR	Also compare the time per operation, accepting a\n"
+	       "		slow-down by FACTOR (default: 0, allocations only)\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *baseline = NULL;
+	double tolerance = 0;
+	unsigned int i;
+	int c, rc = 0;
+
+	while ((c = getopt(argc, argv, "hn:b:t:")) != -1) {
+		switch (c) {
+		case 'n':
+			num_frames = atoi(optarg);
+			break;
+		case 'b':
+			baseline = optarg;
+			break;
+		case 't':
+			tolerance = atof(optarg);
+			break;
+		case 'h':
+		default:
+			print_help(argv[0]);
+			exit(c == 'h' ? 0 : 2);
+		}
+	}
+
+	if (num_frames < 1) {
+		fprintf(stderr, "Number of frames must be positive\n");
+		exit(2);
+	}
+
+	tall_bts_ctx = talloc_named_const(NULL, 1, "OsmoBTS context");
+	msgb_talloc_ctx_init(tall_bts_ctx, 0);
+
+	/* logging of dropped indications must not show up in the results */
+	osmo_init_logging2(tall_bts_ctx, &bts_log_info);
+	for (i = 0; i < bts_log_info.num_cat; i++)
+		osmo_stderr_target->categories[i].loglevel = LOGL_FATAL;
+
+	bts = gsm_bts_alloc(tall_bts_ctx, 0);
+	if (!bts) {
+		fprintf(stderr, "Failed to create BTS structure\n");
+		exit(1);
+	}
+	if (bts_init(bts) < 0) {
+		fprintf(stderr, "unable to init BTS\n");
+		exit(1);
+	}
+
+	trx = gsm_bts_trx_alloc(bts);
+	if (!trx) {
+		fprintf(stderr, "Failed to alloc TRX structure\n");
+		exit(1);
+	}
+
+	trx_sched_init(trx);
+
+	printf("# %u frames per case, timeslots %u..7\n", num_frames, BENCH_FIRST_TN);
+
+	for (i = 0; i < ARRAY_SIZE(bench_cases); i++) {
+		const struct bench_case *bc = &bench_cases[i];
+		struct bench_result res = { 0 };
+
+		setup_ts(bc, true);
+		bc->run(bc, &res);
+		setup_ts(bc, false);
+
+		if (!res.ops)
+			continue;
+		if (!have_num_allocs)
+			res.allocs = -1;
+
+		printf("case=%s ns_per_op=%.1f allocs_per_op=%.3f ops=%"PRIu64"\n",
+		       bc->name, (double) res.ns / res.ops,
+		       res.allocs >= 0 ? (double) res.allocs / res.ops : -1.0, res.ops);
+
+		if (baseline && check_baseline(baseline, bc->name, &res, tolerance) < 0)
+			rc = 1;
+	}
+
+	trx_sched_clean(trx);
+
+	return rc;
+}